@@ -0,0 +1,157 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_batch_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Converts blocks of raw 14 byte frames and reports samples/s,
+ *  ns and cycles per sample for:
+ *  - Per-sample gy521_decode() into dev->v (what fn.read() does)
+ *  - gy521_batch_raw / _fixed / _float into SoA arrays
+ *  Batch results are checked against the per-sample path
+ *  (fixed: identical, float: within a few rounding steps).
+ *
+ *  Exit code 1 on a mismatch.
+ *
+ *  Usage: gy521_batch_bench [samples]
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gy521.h"
+#include "gy521_batch.h"
+#include "gy521_host.h"
+#include "gy521_port.h" // gy521_decode()
+#include "gy521_sim.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GY521_BENCH_CYCLES() __rdtsc()
+#else
+#define GY521_BENCH_CYCLES() 0ull
+#endif
+
+#define BENCH_BLOCK 512 // Frames per block (half a FIFO of 14 byte frames, rounded up)
+
+static gy521_sim_bus_t g_sim_bus;
+static gy521_bus_t g_bus;
+static gy521_sim_t g_sim;
+static gy521_s g_dev;
+
+static uint8_t g_frames[BENCH_BLOCK * 14];
+static int16_t g_raw[7][BENCH_BLOCK];
+static int32_t g_fixed[7][BENCH_BLOCK];
+static float g_float[7][BENCH_BLOCK];
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+typedef struct{
+	const char *name;
+	uint64_t ns, cycles;
+	uint32_t samples;
+} bench_result_t;
+
+static void bench_print(const bench_result_t *r){
+	double n = r->samples ? r->samples : 1;
+	printf("%-20s %12.2f %10.2f %10.1f\n", r->name, r->samples / (r->ns / 1e9) / 1e6, r->ns / n, r->cycles / n);
+}
+
+// 0 = raw, 1 = fixed, 2 = float, 3 = per-sample fixed, 4 = per-sample float
+static bench_result_t bench_run(const char *name, uint8_t variant, uint32_t samples){
+	bench_result_t r = {.name = name};
+	const gy521_soa_raw_t raw = {{g_raw[0], g_raw[1], g_raw[2]}, g_raw[3], {g_raw[4], g_raw[5], g_raw[6]}};
+	const gy521_soa_fixed_t fixed = {{g_fixed[0], g_fixed[1], g_fixed[2]}, g_fixed[3], {g_fixed[4], g_fixed[5], g_fixed[6]}};
+	const gy521_soa_float_t flt = {{g_float[0], g_float[1], g_float[2]}, g_float[3], {g_float[4], g_float[5], g_float[6]}};
+	g_dev.conf.fixed = variant == 3;
+	g_dev.conf.scaled = variant == 4;
+
+	while(r.samples < samples){
+		uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+		switch(variant){
+			case 0: gy521_batch_raw(g_frames, BENCH_BLOCK, GY521_LAYOUT_REGS, &raw); break;
+			case 1: gy521_batch_fixed(&g_dev, g_frames, BENCH_BLOCK, GY521_LAYOUT_REGS, &fixed); break;
+			case 2: gy521_batch_float(&g_dev, g_frames, BENCH_BLOCK, GY521_LAYOUT_REGS, &flt); break;
+			default:
+				for(uint16_t i = 0; i < BENCH_BLOCK; i++) gy521_decode(&g_dev, GY521_ALL, &g_frames[i * 14]);
+		}
+		r.cycles += GY521_BENCH_CYCLES() - c0;
+		r.ns += bench_ns() - t0;
+		r.samples += BENCH_BLOCK;
+	}
+	return r;
+}
+
+// =================================
+// === Batch vs. per-sample path ===
+// =================================
+static uint32_t bench_check(void){
+	bench_run("", 0, 1);
+	bench_run("", 1, 1);
+	bench_run("", 2, 1);
+
+	uint32_t bad = 0;
+	for(uint16_t i = 0; i < BENCH_BLOCK; i++){
+		g_dev.conf.fixed = g_dev.conf.scaled = true;
+		gy521_decode(&g_dev, GY521_ALL, &g_frames[i * 14]);
+
+		const int16_t raw[7] = {g_dev.v.accel.raw.x, g_dev.v.accel.raw.y, g_dev.v.accel.raw.z, g_dev.v.temp.raw,
+			g_dev.v.gyro.raw.x, g_dev.v.gyro.raw.y, g_dev.v.gyro.raw.z};
+		const int32_t fixed[7] = {g_dev.v.accel.mg.x, g_dev.v.accel.mg.y, g_dev.v.accel.mg.z, g_dev.v.temp.mcelsius,
+			g_dev.v.gyro.mdps.x, g_dev.v.gyro.mdps.y, g_dev.v.gyro.mdps.z};
+		const float flt[7] = {g_dev.v.accel.g.x, g_dev.v.accel.g.y, g_dev.v.accel.g.z, g_dev.v.temp.celsius,
+			g_dev.v.gyro.dps.x, g_dev.v.gyro.dps.y, g_dev.v.gyro.dps.z};
+
+		for(uint8_t c = 0; c < 7; c++){
+			// Relative to the terms summed (temp: raw / 340 + 36.53)
+			float mag = c == 3 ? fabsf(raw[c] / 340.0f) + 36.53f : fabsf(flt[c]);
+			float tol = 2e-6f * mag + 1e-6f;
+			if(g_raw[c][i] != raw[c] || g_fixed[c][i] != fixed[c] || fabsf(g_float[c][i] - flt[c]) > tol) bad++;
+		}
+	}
+	return bad;
+}
+
+int main(int argc, char **argv){
+	uint32_t samples = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000000;
+
+	gy521_sim_bus_init(&g_sim_bus, &g_bus);
+	gy521_sim_init(&g_sim, GY521_I2C_ADDR_GND);
+	gy521_sim_attach(&g_sim_bus, &g_sim);
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &g_sim_bus);
+	g_dev = gy521_init(&g_bus, GY521_I2C_ADDR_GND);
+	g_dev.conf.accel.fsr = GY521_ACCEL_FSR_SEL_8G;
+	g_dev.conf.gyro.fsr = GY521_GYRO_FSR_SEL_2000DPS;
+	g_dev.fn.fsr(&g_dev);
+
+	srand(521);
+	for(uint32_t i = 0; i < sizeof(g_frames); i++) g_frames[i] = (uint8_t)rand();
+
+	printf("gy521 batch conversion benchmark, %u samples, blocks of %d frames (all 7 channels, ±8 g / ±2000 °/s)\n\n",
+		samples, BENCH_BLOCK);
+	printf("%-20s %12s %10s %10s\n", "variant", "Msmp/s", "ns/smp", "cyc/smp");
+
+	bench_result_t r;
+	r = bench_run("per-sample fixed", 3, samples); bench_print(&r);
+	r = bench_run("per-sample float", 4, samples); bench_print(&r);
+	r = bench_run("batch raw", 0, samples); bench_print(&r);
+	r = bench_run("batch fixed", 1, samples); bench_print(&r);
+	r = bench_run("batch float", 2, samples); bench_print(&r);
+
+	uint32_t bad = bench_check();
+	printf("\nbatch vs. per-sample: %u mismatches in %d frames: %s\n", bad, BENCH_BLOCK, bad ? "FAILED" : "ok");
+
+	return bad ? 1 : 0;
+}
@@ -0,0 +1,788 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Host benchmark of the driver hot path against the register
+ *  simulator. Per gy521_read mode it reports:
+ *  - CPU time (ns) and cycles per sample spent in the driver
+ *    (including the simulated transport)
+ *  - I²C transactions and bytes per sample
+ *  - Simulated bus time per sample at 400 kHz
+ *  Polling rows poll 4x per sample period and count only
+ *  distinct samples, with and without conf.rate.pace.
+ *  FIFO bursts: every frame's sample index must follow the
+ *  previous one; a stalled reader must see the overflow counted
+ *  and only fresh, consecutive frames after the flush.
+ *  Fixed-point output against the float path: every raw value on
+ *  every channel for all accel / gyro FSRs and the temperature,
+ *  at most 1 milli-unit apart from round(float * 1000).
+ *  Two simulated devices (0x68 / 0x69) on one bus read with
+ *  gy521_read_batch(): no crossed or stale samples, v.seq per
+ *  device, a NACK of one leaves the other's sample intact.
+ *  Data-ready interrupt through the simulator's INT line at 1 kHz:
+ *  every pulse read once, no sample missed or repeated.
+ *  Non-blocking reads on the fake DMA engine of the host port:
+ *  each completed half handed out once and in order, never the
+ *  half being filled, stamp and data of the same transfer.
+ *  Masked reads: channels derived from standby / temp sleep,
+ *  read in one or two minimal register spans.
+ *  Magnetometer on the auxiliary bus (simulated slave): read by
+ *  the MPU-6050 I2C master in the same burst vs. separately in
+ *  bypass mode. Each reading is checked against its IMU sample.
+ *  Bus clock self-test (gy521_baud_test()) on wiring that is
+ *  clean up to 400 kHz: samples/s and error rate per clock, the
+ *  clock it picks must be 400 kHz.
+ *  Finally fn.calibrate() on a biased, still sensor: simulated
+ *  duration, bus traffic and the bias left afterwards.
+ *  Built with GY521_INSTRUMENT it also dumps the instrumentation
+ *  of a paced polling run (times are simulated bus time).
+ *
+ *  Usage: gy521_bench [samples]
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gy521.h"
+#include "gy521_host.h"
+#include "gy521_sim.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GY521_BENCH_CYCLES() __rdtsc()
+#else
+#define GY521_BENCH_CYCLES() 0ull
+#endif
+
+// ========================
+// === Global Variables ===
+// ========================
+static gy521_sim_bus_t g_sim_bus;
+static gy521_bus_t g_bus;
+static gy521_sim_t g_sim;
+static gy521_s g_dev;
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// =============================
+// === Fresh Device + Sensor ===
+// =============================
+static void bench_setup(void){
+	gy521_sim_bus_init(&g_sim_bus, &g_bus);
+	gy521_sim_init(&g_sim, GY521_I2C_ADDR_GND);
+	gy521_sim_attach(&g_sim_bus, &g_sim);
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &g_sim_bus);
+
+	g_dev = gy521_init(&g_bus, GY521_I2C_ADDR_GND);
+	g_dev.conf.sleep = false;
+	g_dev.fn.sleep(&g_dev);
+	g_dev.conf.accel.fsr = GY521_ACCEL_FSR_SEL_8G;
+	g_dev.conf.gyro.fsr = GY521_GYRO_FSR_SEL_2000DPS;
+	g_dev.fn.fsr(&g_dev);
+
+	// 1 kHz sample rate, 8 kHz would outrun a 400 kHz bus
+	g_dev.conf.rate.dlpf = GY521_DLPF_184HZ;
+	g_dev.fn.rate(&g_dev);
+}
+
+typedef struct{
+	const char *name;
+	uint64_t ns, cycles, bus_ns;
+	uint32_t samples, transactions, bytes;
+} bench_result_t;
+
+static void bench_print(const bench_result_t *r){
+	double n = r->samples ? r->samples : 1;
+	printf("%-18s %10.1f %10.0f %8.2f %8.2f %10.1f\n", r->name,
+		r->ns / n, r->cycles / n, r->transactions / n, r->bytes / n, r->bus_ns / n / 1000.0);
+}
+
+// ===========================
+// === Register Read Modes ===
+// ===========================
+static bench_result_t bench_read(const char *name, uint8_t mode, bool scaled, bool fixed, uint32_t samples){
+	bench_setup();
+	g_dev.conf.scaled = scaled;
+	g_dev.conf.fixed = fixed;
+
+	bench_result_t r = {.name = name};
+	uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	uint32_t tr0 = g_bus.stat.transactions, by0 = g_bus.stat.bytes;
+
+	for(uint32_t i = 0; i < samples; i++){
+		gy521_sim_advance(&g_sim_bus, period);
+		uint64_t sim0 = g_sim_bus.now_ns;
+		uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+		if(g_dev.fn.read(&g_dev, mode)) r.samples++;
+		r.cycles += GY521_BENCH_CYCLES() - c0;
+		r.ns += bench_ns() - t0;
+		r.bus_ns += g_sim_bus.now_ns - sim0;
+	}
+
+	r.transactions = g_bus.stat.transactions - tr0;
+	r.bytes = g_bus.stat.bytes - by0;
+	return r;
+}
+
+// ===========================
+// === Channel Masked Read ===
+// ===========================
+// 'off' = channels put in standby / temp sleep, read with GY521_MASK_AUTO.
+// Decoded channels are checked against the simulator's data registers;
+// with two spans a new sample may land between them (counted the same).
+static bench_result_t bench_mask(const char *name, uint8_t off, uint32_t samples, uint32_t *bad){
+	bench_setup();
+	g_dev.conf.accel.x.stby = off & GY521_MASK_ACCEL_X;
+	g_dev.conf.accel.y.stby = off & GY521_MASK_ACCEL_Y;
+	g_dev.conf.accel.z.stby = off & GY521_MASK_ACCEL_Z;
+	g_dev.conf.temp.sleep = off & GY521_MASK_TEMP;
+	g_dev.conf.gyro.x.stby = off & GY521_MASK_GYRO_X;
+	g_dev.conf.gyro.y.stby = off & GY521_MASK_GYRO_Y;
+	g_dev.conf.gyro.z.stby = off & GY521_MASK_GYRO_Z;
+	g_dev.fn.commit(&g_dev);
+
+	bench_result_t r = {.name = name};
+	const uint8_t mask = gy521_mask_default(&g_dev);
+	uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	uint32_t tr0 = g_bus.stat.transactions, by0 = g_bus.stat.bytes;
+
+	for(uint32_t i = 0; i < samples; i++){
+		gy521_sim_advance(&g_sim_bus, period);
+		uint64_t sim0 = g_sim_bus.now_ns;
+		uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+		bool ok = g_dev.fn.read_mask(&g_dev, GY521_MASK_AUTO);
+		r.cycles += GY521_BENCH_CYCLES() - c0;
+		r.ns += bench_ns() - t0;
+		r.bus_ns += g_sim_bus.now_ns - sim0;
+		if(!ok) continue;
+		r.samples++;
+
+		const int16_t v[7] = {g_dev.v.accel.raw.x, g_dev.v.accel.raw.y, g_dev.v.accel.raw.z, g_dev.v.temp.raw,
+			g_dev.v.gyro.raw.x, g_dev.v.gyro.raw.y, g_dev.v.gyro.raw.z};
+		const uint8_t *d = &g_sim.reg[0x3B]; // ACCEL_XOUT_H
+		for(uint8_t c = 0; c < 7; c++)
+			if((mask & (1 << c)) && v[c] != (int16_t)((d[2 * c] << 8) | d[2 * c + 1])) (*bad)++;
+	}
+
+	r.transactions = g_bus.stat.transactions - tr0;
+	r.bytes = g_bus.stat.bytes - by0;
+	return r;
+}
+
+// ===============================
+// === Polling faster than ODR ===
+// ===============================
+// Polls 4x per sample period; samples = distinct samples delivered
+static bench_result_t bench_poll(const char *name, bool pace, uint32_t samples){
+	bench_setup();
+	g_dev.conf.rate.pace = pace;
+
+	bench_result_t r = {.name = name};
+	uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	uint32_t tr0 = g_bus.stat.transactions, by0 = g_bus.stat.bytes;
+	int16_t last = g_dev.v.accel.raw.x;
+
+	while(r.samples < samples){
+		gy521_sim_advance(&g_sim_bus, period / 4);
+		uint64_t sim0 = g_sim_bus.now_ns;
+		uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+		bool ok = g_dev.fn.read(&g_dev, GY521_ALL);
+		r.cycles += GY521_BENCH_CYCLES() - c0;
+		r.ns += bench_ns() - t0;
+		r.bus_ns += g_sim_bus.now_ns - sim0;
+
+		// Default simulator source counts up in accel.x
+		if(ok && g_dev.v.accel.raw.x != last){
+			last = g_dev.v.accel.raw.x;
+			r.samples++;
+		}
+	}
+
+	r.transactions = g_bus.stat.transactions - tr0;
+	r.bytes = g_bus.stat.bytes - by0;
+	return r;
+}
+
+// =======================
+// === FIFO Burst Mode ===
+// =======================
+static void bench_fifo_setup(void){
+	bench_setup();
+	g_dev.conf.fifo.enable = true;
+	g_dev.conf.fifo.accel = true;
+	g_dev.conf.fifo.temp = true;
+	g_dev.conf.fifo.gyro = true;
+	g_dev.fn.fifo.set(&g_dev);
+}
+
+// Sample index of the default simulator source: low half in accel.x, high half in accel.y
+static uint32_t bench_index(const gy521_sample_t *s){
+	return (uint16_t)s->accel.x | ((uint32_t)(uint16_t)s->accel.y << 16);
+}
+
+// Every frame must carry the index after the previous one (none dropped or repeated)
+static bench_result_t bench_fifo(const char *name, uint16_t burst, uint32_t samples, uint32_t *bad){
+	bench_fifo_setup();
+
+	bench_result_t r = {.name = name};
+	gy521_sample_t buf[64];
+	uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	uint32_t tr0 = g_bus.stat.transactions, by0 = g_bus.stat.bytes;
+	uint32_t next = g_sim.index;
+	uint64_t spent_us = 0;
+
+	// One burst period per loop including the bus time of the read, the reader drains what piled up meanwhile
+	while(r.samples < samples){
+		const uint64_t wait_us = (uint64_t)period * burst;
+		gy521_sim_advance(&g_sim_bus, wait_us > spent_us ? wait_us - spent_us : 0);
+		uint64_t sim0 = g_sim_bus.now_ns;
+		uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+		uint16_t n = g_dev.fn.fifo.read(&g_dev, buf, 64);
+		r.cycles += GY521_BENCH_CYCLES() - c0;
+		r.ns += bench_ns() - t0;
+		r.bus_ns += g_sim_bus.now_ns - sim0;
+		spent_us = (g_sim_bus.now_ns - sim0) / 1000u;
+
+		for(uint16_t i = 0; i < n; i++){
+			if(bench_index(&buf[i]) != next) (*bad)++;
+			next = bench_index(&buf[i]) + 1;
+		}
+		r.samples += n;
+	}
+	*bad += g_dev.v.fifo.overflows;
+
+	r.transactions = g_bus.stat.transactions - tr0;
+	r.bytes = g_bus.stat.bytes - by0;
+	return r;
+}
+
+// Reader stalls until the FIFO overflows: the loss is counted, the
+// FIFO flushed, and reading resumes with the first sample after the
+// flush (no stale or repeated frames).
+static bool bench_fifo_overflow(void){
+	bench_fifo_setup();
+	gy521_sample_t buf[64];
+	uint32_t period = gy521_sim_sample_period_us(&g_sim);
+
+	gy521_sim_advance(&g_sim_bus, (uint64_t)period * 16);
+	uint16_t n = g_dev.fn.fifo.read(&g_dev, buf, 64);
+	const uint32_t last = n ? bench_index(&buf[n - 1]) : 0;
+
+	gy521_sim_advance(&g_sim_bus, (uint64_t)period * 200); // 1024 byte FIFO holds 73 frames
+	const uint16_t during = g_dev.fn.fifo.read(&g_dev, buf, 64);
+	const uint32_t flushed_at = g_sim.index;
+
+	uint32_t bad = 0, got = 0, next = flushed_at;
+	for(uint8_t b = 0; b < 8; b++){
+		gy521_sim_advance(&g_sim_bus, (uint64_t)period * 16);
+		n = g_dev.fn.fifo.read(&g_dev, buf, 64);
+		for(uint16_t i = 0; i < n; i++){
+			if(bench_index(&buf[i]) != next) bad++;
+			next = bench_index(&buf[i]) + 1;
+		}
+		got += n;
+	}
+
+	bool ok = n && during == 0 && g_dev.v.fifo.overflows == 1 && !bad && got >= 8 * 15;
+	printf("\nfifo overflow: %u overflow(s), samples %u..%u lost, %u frames after the flush, %u out of order: %s\n",
+		g_dev.v.fifo.overflows, last + 1, flushed_at - 1, got, bad, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+// ============================
+// === Fixed-point Accuracy ===
+// ============================
+// Every raw value on every channel: accel / gyro axes offset against each other
+static void bench_sweep_source(void *user, uint32_t index, gy521_sample_t *out){
+	(void)user;
+	const uint16_t v = (uint16_t)index;
+	out->accel = (gy521_axis_raw_t){(int16_t)v, (int16_t)(v + 0x5555), (int16_t)(v + 0xaaaa)};
+	out->temp = (int16_t)v;
+	out->gyro = (gy521_axis_raw_t){(int16_t)(v + 0x1234), (int16_t)~v, (int16_t)(v * 3u)};
+}
+
+// |fixed - round(float * 1000)| for one value, tracks the worst
+static void bench_fixed_err(int32_t fixed, float value, int32_t *worst){
+	const int64_t want = llround((double)value * 1000.0);
+	const int32_t err = (int32_t)llabs(fixed - want);
+	if(err > *worst) *worst = err;
+}
+
+// All 65536 raw values through fn.read() with conf.scaled + conf.fixed, per FSR
+static bool bench_fixed(void){
+	static const char *const accel_name[4] = {"2G", "4G", "8G", "16G"};
+	static const uint16_t gyro_dps[4] = {250, 500, 1000, 2000};
+	bool ok = true;
+	int32_t temp_worst = 0;
+
+	printf("\nfixed-point vs. float (round(float * 1000)), all 65536 raw values per channel:\n");
+	for(uint8_t fs = 0; fs < 4; fs++){
+		bench_setup();
+		g_sim_bus.baud = 0;
+		g_sim.source = &bench_sweep_source;
+		g_dev.conf.scaled = true;
+		g_dev.conf.fixed = true;
+		g_dev.conf.accel.fsr = fs << 3;
+		g_dev.conf.gyro.fsr = fs << 3;
+		if(!g_dev.fn.fsr(&g_dev)) return false;
+
+		const uint32_t period = gy521_sim_sample_period_us(&g_sim);
+		int32_t accel_worst = 0, gyro_worst = 0;
+		for(uint32_t i = 0; i < 65536; i++){
+			gy521_sim_advance(&g_sim_bus, period);
+			if(!g_dev.fn.read(&g_dev, GY521_ALL)) return false;
+
+			const int32_t *mg = &g_dev.v.accel.mg.x, *mdps = &g_dev.v.gyro.mdps.x;
+			const float *g = &g_dev.v.accel.g.x, *dps = &g_dev.v.gyro.dps.x;
+			for(uint8_t k = 0; k < 3; k++){
+				bench_fixed_err(mg[k], g[k], &accel_worst);
+				bench_fixed_err(mdps[k], dps[k], &gyro_worst);
+			}
+			bench_fixed_err(g_dev.v.temp.mcelsius, g_dev.v.temp.celsius, &temp_worst);
+		}
+
+		printf("accel ±%-4s max error %d mg   gyro ±%4u °/s max error %d m°/s\n", accel_name[fs], accel_worst,
+			gyro_dps[fs], gyro_worst);
+		ok = ok && accel_worst <= 1 && gyro_worst <= 1;
+	}
+	printf("temperature max error %d m°C\n", temp_worst);
+	ok = ok && temp_worst <= 1;
+	printf("fixed-point within 1 milli-unit: %s\n", ok ? "ok" : "FAILED");
+	return ok;
+}
+
+// ============================
+// === Two Devices, one Bus ===
+// ============================
+static gy521_sim_t g_sim2;
+static gy521_s g_dev2;
+
+// Per device: accel.y = its tag, accel.x / gyro.x = its own sample index
+static void bench_tag_source(void *user, uint32_t index, gy521_sample_t *out){
+	*out = (gy521_sample_t){0};
+	out->accel.x = (int16_t)index;
+	out->accel.y = (int16_t)(uintptr_t)user;
+	out->gyro.x = (int16_t)(index * 3u);
+}
+
+// 0x68 at 1 kHz and 0x69 at 500 Hz read by gy521_read_batch(); every
+// 17th batch the first device read NACKs (order swaps every time).
+// Each device must get its own tag and its latest sample, v.seq count
+// its own reads only, and a NACK must leave the other device intact.
+static bool bench_two(uint32_t batches){
+	bench_setup();
+	gy521_sim_init(&g_sim2, GY521_I2C_ADDR_VCC);
+	gy521_sim_attach(&g_sim_bus, &g_sim2);
+	g_sim_bus.baud = 0; // No sample changes during the batch
+	g_sim.source = g_sim2.source = &bench_tag_source;
+	g_sim.source_user = (void *)(uintptr_t)0x1168;
+	g_sim2.source_user = (void *)(uintptr_t)0x1169;
+
+	g_dev2 = gy521_init(&g_bus, GY521_I2C_ADDR_VCC);
+	g_dev2.conf.sleep = false;
+	g_dev2.conf.rate.dlpf = GY521_DLPF_184HZ;
+	g_dev2.conf.rate.div = 1;
+	if(!g_dev2.fn.commit(&g_dev2)) return false;
+	gy521_sim_advance(&g_sim_bus, 2000); // First 500 Hz sample in place
+
+	gy521_s *devs[2] = {&g_dev, &g_dev2};
+	gy521_sim_t *sims[2] = {&g_sim, &g_sim2};
+	const uint16_t tags[2] = {0x1168, 0x1169};
+	uint32_t reads[2] = {0}, good[2] = {0}, nacked[2] = {0}, crossed = 0, stale = 0, bad_seq = 0, bad_ret = 0, hit = 0;
+
+	for(uint32_t b = 0; b < batches; b++){
+		gy521_sim_advance(&g_sim_bus, 1000);
+		const uint8_t first = b & 1;
+		gy521_s *order[2] = {devs[first], devs[first ^ 1]};
+		const bool nack = b % 17 == 16;
+		if(nack) g_sim_bus.fault.nack = 1; // Address phase of the first read
+
+		const gy521_s before = *order[0];
+		const bool all = gy521_read_batch(order, 2, GY521_ALL);
+		if(all == nack) bad_ret++;
+
+		for(uint8_t k = 0; k < 2; k++){
+			gy521_s *d = devs[k];
+			reads[k]++;
+			if(nack && d == order[0]){
+				// Failed read: previous sample and seq stay
+				nacked[k]++;
+				if(memcmp(&d->v.accel.raw, &before.v.accel.raw, sizeof(d->v.accel.raw)) || d->v.seq != before.v.seq) hit++;
+				continue;
+			}
+			good[k]++;
+			if((uint16_t)d->v.accel.raw.y != tags[k]) crossed++;
+			if((uint16_t)d->v.accel.raw.x != (uint16_t)(sims[k]->index - 1) || d->v.gyro.raw.x != (int16_t)((sims[k]->index - 1) * 3u)) stale++;
+			if(d->v.seq != reads[k]) bad_seq++; // Stamped per own read, NACKed ones included
+			if(d->priv.failures) hit++;
+		}
+	}
+
+	bool ok = !crossed && !stale && !bad_seq && !bad_ret && !hit && nacked[0] && nacked[1];
+	printf("\ntwo devices, %u batches (0x68 1 kHz / 0x69 500 Hz): %u + %u samples, %u + %u NACKed,"
+		" %u crossed, %u stale, %u seq, %u returns, %u disturbed: %s\n", batches, good[0], good[1], nacked[0], nacked[1],
+		crossed, stale, bad_seq, bad_ret, hit, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+// =================================
+// === Data-ready Interrupt Line ===
+// =================================
+// INT pulse of the simulator -> driver, as the GPIO IRQ does on the RP2040
+static void bench_int_line(void *user){
+	gy521_data_ready((gy521_s *)user);
+}
+
+// 1 kHz via 'dlpf' + 'div', polled 4x per period: every pulse read once,
+// v.seq and the sample index step by exactly 1, no pulse missed
+static bool bench_interrupt(const char *name, uint8_t dlpf, uint8_t div, uint32_t samples){
+	bench_setup();
+	g_dev.conf.rate.dlpf = dlpf;
+	g_dev.conf.rate.div = div;
+	g_dev.conf.interrupt.data_ready = true;
+	g_sim.int_line = &bench_int_line;
+	g_sim.int_user = &g_dev;
+	if(!g_dev.fn.rate(&g_dev) || !g_dev.fn.interrupt(&g_dev)) return false;
+
+	const uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	uint32_t got = 0, bad_seq = 0, bad_index = 0, last_seq = 0, last_index = 0;
+	while(got < samples){
+		gy521_sim_advance(&g_sim_bus, period / 4);
+		if(!g_dev.fn.read(&g_dev, GY521_ALL)) continue;
+
+		const uint32_t index = (uint16_t)g_dev.v.accel.raw.x | ((uint32_t)(uint16_t)g_dev.v.accel.raw.y << 16);
+		if(got && g_dev.v.seq != last_seq + 1) bad_seq++;
+		if(got && index != last_index + 1) bad_index++;
+		last_seq = g_dev.v.seq;
+		last_index = index;
+		got++;
+	}
+
+	bool ok = period == 1000 && !bad_seq && !bad_index && !g_dev.v.interrupt.missed;
+	printf("data-ready %-14s %u us period, %u samples, %u seq steps != 1, %u repeated / skipped, %u missed: %s\n",
+		name, period, got, bad_seq, bad_index, g_dev.v.interrupt.missed, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+// ===============================
+// === Non-blocking (fake DMA) ===
+// ===============================
+typedef struct{
+	uint32_t expect_index[4], expect_seq[4]; // Sample + stamp per started transfer (by seq)
+	uint64_t expect_us[4];
+	uint32_t started, got, last_seq;
+	uint8_t next_half; // Half the next completion must hand over
+	uint32_t bad_order, bad_owner, bad_data, bad_stamp;
+} bench_async_t;
+
+static bench_async_t g_async;
+
+// conf.async.callback: halves complete alternately
+static void bench_async_done(gy521_s *dev){
+	if(dev->v.async.ready_buf != g_async.next_half) g_async.bad_order++;
+	g_async.next_half ^= 1;
+}
+
+// Stamp taken for the transfer just started: the sample in the registers now
+static void bench_async_started(void){
+	const gy521_stamp_t *st = &g_dev.priv.dma_stamp[g_dev.priv.dma_fill];
+	if(!g_dev.v.async.busy || st->seq == g_async.started) return;
+	g_async.started = st->seq;
+	g_async.expect_index[st->seq % 4] = g_sim.index - 1;
+	g_async.expect_seq[st->seq % 4] = st->seq;
+	g_async.expect_us[st->seq % 4] = st->timestamp_us;
+}
+
+// Transfers complete 'transfer_us' after their start; every half must be
+// handed out once, in order, never while the next transfer fills it, with
+// the stamp of its own transfer. Every 8th step a blocking read waits for
+// the transfer in flight on the same bus.
+static bool bench_async(uint32_t transfer_us, uint32_t samples){
+	bench_setup();
+	g_sim_bus.baud = 0; // Register copy takes no time: the data is the sample at the stamp
+	g_async = (bench_async_t){0};
+	gy521_host_dma(transfer_us);
+	g_dev.conf.async.enable = true;
+	g_dev.conf.async.callback = &bench_async_done;
+
+	const uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	for(uint32_t i = 0; i < samples; i++){
+		gy521_sim_advance(&g_sim_bus, period);
+		const bool got = g_dev.fn.read(&g_dev, GY521_ALL);
+
+		if(got){
+			const uint32_t k = g_dev.v.seq % 4;
+			const uint32_t index = (uint16_t)g_dev.v.accel.raw.x | ((uint32_t)(uint16_t)g_dev.v.accel.raw.y << 16);
+			if(g_async.got && g_dev.v.seq != g_async.last_seq + 1) g_async.bad_order++;
+			if(g_async.expect_seq[k] != g_dev.v.seq || g_async.expect_us[k] != g_dev.v.timestamp_us) g_async.bad_stamp++;
+			if(index != g_async.expect_index[k]) g_async.bad_data++;
+			if(g_dev.v.async.busy && g_dev.v.async.ready_buf == g_dev.priv.dma_fill) g_async.bad_owner++;
+			g_async.last_seq = g_dev.v.seq;
+			g_async.got++;
+		}
+		bench_async_started();
+
+		if(i % 8 == 7 && g_dev.v.async.busy){
+			uint8_t who;
+			if(!gy521_read_register(&g_dev, 0x75, &who, 1) || g_bus.owner) g_async.bad_owner++; // WHO_AM_I
+		}
+	}
+
+	// Each completion handed out exactly once (one may still wait for the next read)
+	const uint32_t pending = g_dev.v.async.ready;
+	if(g_async.got + pending != g_dev.v.async.completed) g_async.bad_order++;
+	gy521_host_dma(0);
+
+	bool ok = g_async.got > samples / 4 && !g_dev.v.async.errors &&
+		!g_async.bad_order && !g_async.bad_owner && !g_async.bad_data && !g_async.bad_stamp;
+	printf("async %4u us: %u reads, %u samples, %u completed, order %u, owner %u, data %u, stamp %u errors: %s\n",
+		transfer_us, samples, g_async.got, g_dev.v.async.completed, g_async.bad_order, g_async.bad_owner,
+		g_async.bad_data, g_async.bad_stamp, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+// ===================================
+// === Auxiliary I2C: Magnetometer ===
+// ===================================
+// HMC5883L-like slave: mode 0x02 (0 = continuous), X/Z/Y big endian at 0x03, ID "H43" at 0x0A
+#define BENCH_MAG_ADDR 0x1E
+#define BENCH_MAG_MODE 0x02
+#define BENCH_MAG_DATA 0x03
+#define BENCH_MAG_ID 0x0A
+
+static gy521_sim_slave_t g_mag;
+
+// X follows the sample index like the default accel.x, so each reading can be matched to its IMU sample
+static void bench_mag_update(void *user, uint32_t index, gy521_sim_slave_t *mag){
+	(void)user;
+	if(mag->reg[BENCH_MAG_MODE] != 0) return;
+	const int16_t v[3] = {(int16_t)index, (int16_t)~index, (int16_t)(index * 3)};
+	for(uint8_t k = 0; k < 3; k++){
+		mag->reg[BENCH_MAG_DATA + 2 * k] = (uint8_t)((uint16_t)v[k] >> 8);
+		mag->reg[BENCH_MAG_DATA + 2 * k + 1] = (uint8_t)v[k];
+	}
+}
+
+// Bypass: the host reads the magnetometer itself, counted like a driver register read
+static bool bench_mag_read(uint8_t reg, uint8_t *out, uint8_t len){
+	g_bus.stat.transactions++;
+	g_bus.stat.bytes += 1 + len;
+	return g_bus.write(g_bus.ctx, BENCH_MAG_ADDR, &reg, 1, true) == 1 && g_bus.read(g_bus.ctx, BENCH_MAG_ADDR, out, len, false) == len;
+}
+
+static bool bench_mag_write(uint8_t reg, uint8_t value){
+	const uint8_t buf[2] = {reg, value};
+	return g_bus.write(g_bus.ctx, BENCH_MAG_ADDR, buf, 2, false) == 2;
+}
+
+// Counts readings that do not belong to the IMU sample read with them
+static bench_result_t bench_aux(const char *name, bool master, uint32_t samples, uint32_t *torn, bool *ok){
+	bench_setup();
+	gy521_sim_slave_init(&g_mag, BENCH_MAG_ADDR);
+	memcpy(&g_mag.reg[BENCH_MAG_ID], "H43", 3);
+	g_mag.reg[BENCH_MAG_MODE] = 0x01; // Single measurement after power-up
+	g_mag.update = &bench_mag_update;
+	gy521_sim_aux_attach(&g_sim, &g_mag);
+
+	uint8_t id[3] = {0}, mode = 0xff;
+	if(master){
+		// Configure the slave through SLV4, then read it with every sample via SLV0
+		g_dev.conf.aux.enable = true;
+		*ok = g_dev.fn.aux.set(&g_dev);
+		for(uint8_t i = 0; *ok && i < 3; i++) *ok = g_dev.fn.aux.read(&g_dev, BENCH_MAG_ADDR, BENCH_MAG_ID + i, &id[i]);
+		*ok = *ok && g_dev.fn.aux.write(&g_dev, BENCH_MAG_ADDR, BENCH_MAG_MODE, 0x00);
+		*ok = *ok && g_dev.fn.aux.read(&g_dev, BENCH_MAG_ADDR, BENCH_MAG_MODE, &mode);
+
+		g_dev.conf.aux.slv[0].addr = BENCH_MAG_ADDR;
+		g_dev.conf.aux.slv[0].reg = BENCH_MAG_DATA;
+		g_dev.conf.aux.slv[0].len = 6;
+		*ok = *ok && g_dev.fn.aux.set(&g_dev);
+	}else{
+		g_dev.conf.aux.bypass = true;
+		*ok = g_dev.fn.aux.set(&g_dev) && bench_mag_read(BENCH_MAG_ID, id, 3) && bench_mag_write(BENCH_MAG_MODE, 0x00) &&
+			bench_mag_read(BENCH_MAG_MODE, &mode, 1);
+	}
+	*ok = *ok && !memcmp(id, "H43", 3) && mode == 0x00;
+
+	bench_result_t r = {.name = name};
+	uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	uint32_t tr0 = g_bus.stat.transactions, by0 = g_bus.stat.bytes;
+	*torn = 0;
+
+	for(uint32_t i = 0; *ok && i < samples; i++){
+		gy521_sim_advance(&g_sim_bus, period);
+		uint64_t sim0 = g_sim_bus.now_ns;
+		uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+		uint8_t mag[6];
+		bool got = g_dev.fn.read(&g_dev, GY521_ALL);
+		if(got && master) memcpy(mag, g_dev.v.aux.data, 6);
+		else if(got) got = bench_mag_read(BENCH_MAG_DATA, mag, 6);
+		r.cycles += GY521_BENCH_CYCLES() - c0;
+		r.ns += bench_ns() - t0;
+		r.bus_ns += g_sim_bus.now_ns - sim0;
+
+		if(!got) continue;
+		r.samples++;
+		if((int16_t)((mag[0] << 8) | mag[1]) != g_dev.v.accel.raw.x) (*torn)++;
+	}
+
+	r.transactions = g_bus.stat.transactions - tr0;
+	r.bytes = g_bus.stat.bytes - by0;
+	return r;
+}
+
+// ===================
+// === Calibration ===
+// ===================
+// Still sensor (±8 g / ±2000 °/s) with a bias on every axis and -4..3 LSB noise
+static void bench_bias_source(void *user, uint32_t index, gy521_sample_t *out){
+	(void)user;
+	int16_t n = (int16_t)((index * 2654435761u) >> 29) - 4;
+	*out = (gy521_sample_t){0};
+	out->accel = (gy521_axis_raw_t){120 + n, -85 - n, 4096 + 60 + n};
+	out->gyro = (gy521_axis_raw_t){23 + n, -17 + n, 9 - n};
+}
+
+// Mean of what fn.read() delivers (no software correction), 1 g removed from Z
+static bool bench_bias(double *mg, double *mdps){
+	int64_t sum[6] = {0};
+	const uint16_t reads = 256;
+	uint32_t period = gy521_sim_sample_period_us(&g_sim);
+	for(uint16_t i = 0; i < reads; i++){
+		gy521_sim_advance(&g_sim_bus, period);
+		if(!g_dev.fn.read(&g_dev, GY521_ALL)) return false;
+		const int16_t *a = &g_dev.v.accel.raw.x, *g = &g_dev.v.gyro.raw.x;
+		for(uint8_t k = 0; k < 3; k++){
+			sum[k] += a[k];
+			sum[3 + k] += g[k];
+		}
+	}
+	sum[2] -= 4096 * reads;
+
+	for(uint8_t k = 0; k < 3; k++){
+		mg[k] = sum[k] * 1000.0 / 4096 / reads;
+		mdps[k] = sum[3 + k] * 1000.0 / 16.4 / reads;
+	}
+	return true;
+}
+
+// ===========================
+// === Bus Clock Self-test ===
+// ===========================
+static bool bench_baud(void){
+	static const uint32_t bauds[5] = {GY521_BAUD_STANDARD, 200000, GY521_BAUD_FAST, 700000, GY521_BAUD_FAST_PLUS};
+	gy521_baud_result_t res[5];
+
+	bench_setup();
+	g_sim_bus.fault.max_baud = GY521_BAUD_FAST; // Long cable
+	uint32_t best = gy521_baud_test(&g_dev, bauds, 5, 500, res);
+
+	printf("\nbus clock self-test, 500 bursts each (wiring clean up to 400 kHz):\n");
+	printf("%10s %10s %8s %10s\n", "kHz", "smp/s", "errors", "error %");
+	for(uint8_t i = 0; i < 5; i++)
+		printf("%10u %10u %8u %10.2f\n", res[i].actual / 1000, res[i].samples_per_s, res[i].errors,
+			res[i].bursts ? 100.0 * res[i].errors / res[i].bursts : 0.0);
+
+	bool ok = best == GY521_BAUD_FAST && g_bus.baud == best && g_dev.fn.read(&g_dev, GY521_ALL);
+	printf("picked %u kHz, bus at %u kHz: %s\n", best / 1000, g_bus.baud / 1000, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+static bool bench_calibrate(uint16_t samples, uint32_t baud){
+	bench_setup();
+	gy521_bus_baud(&g_bus, baud);
+	g_sim.source = &bench_bias_source;
+
+	double mg[2][3], mdps[2][3];
+	if(!bench_bias(mg[0], mdps[0])) return false;
+
+	uint32_t tr0 = g_bus.stat.transactions, by0 = g_bus.stat.bytes;
+	uint64_t sim0 = g_sim_bus.now_ns, t0 = bench_ns();
+	bool ok = g_dev.fn.calibrate(&g_dev, samples);
+	uint64_t ns = bench_ns() - t0, sim_ns = g_sim_bus.now_ns - sim0;
+
+	printf("\ncalibrate %u samples at %u kHz: %s, %.1f ms simulated, %u tx, %u B, %.0f us CPU\n", samples, baud / 1000,
+		ok ? "ok" : "FAILED", sim_ns / 1e6, g_bus.stat.transactions - tr0, g_bus.stat.bytes - by0, ns / 1000.0);
+	if(!ok || !bench_bias(mg[1], mdps[1])) return false;
+
+	for(uint8_t i = 0; i < 2; i++)
+		printf("%-8s accel %7.2f %7.2f %7.2f mg   gyro %8.1f %8.1f %8.1f m°/s\n", i ? "after" : "before",
+			mg[i][0], mg[i][1], mg[i][2], mdps[i][0], mdps[i][1], mdps[i][2]);
+
+	// Residual within the offset register resolution (Z: distance from 1 g)
+	bool residual = true;
+	for(uint8_t k = 0; k < 3; k++) residual = residual && fabs(mg[1][k]) < 2.0 && fabs(mdps[1][k]) < 50.0;
+	printf("residual bias below 2 mg / 50 m°/s: %s\n", residual ? "ok" : "FAILED");
+	return residual;
+}
+
+int main(int argc, char **argv){
+	uint32_t samples = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 100000;
+
+	printf("gy521 driver benchmark, %u samples per mode (simulated MPU-6050, 1 kHz ODR, 400 kHz I2C)\n\n", samples);
+	printf("%-18s %10s %10s %8s %8s %10s\n", "mode", "ns/smp", "cyc/smp", "tx/smp", "B/smp", "bus us/smp");
+
+	bench_result_t r;
+	r = bench_read("read all raw", GY521_ALL, false, false, samples); bench_print(&r);
+	r = bench_read("read accel raw", GY521_ACCEL, false, false, samples); bench_print(&r);
+	r = bench_read("read temp raw", GY521_TEMP, false, false, samples); bench_print(&r);
+	r = bench_read("read gyro raw", GY521_GYRO, false, false, samples); bench_print(&r);
+	r = bench_read("read all float", GY521_ALL, true, false, samples); bench_print(&r);
+	r = bench_read("read all fixed", GY521_ALL, false, true, samples); bench_print(&r);
+	uint32_t mask_bad = 0, mask_torn = 0;
+	r = bench_mask("mask auto all on", 0, samples, &mask_bad); bench_print(&r);
+	r = bench_mask("mask accel only", GY521_MASK_TEMP | GY521_MASK_GYRO, samples, &mask_bad); bench_print(&r);
+	r = bench_mask("mask gyro z only", GY521_MASK_ALL & ~GY521_MASK_GYRO_Z, samples, &mask_bad); bench_print(&r);
+	r = bench_mask("mask ax + gz", GY521_MASK_ALL & ~(GY521_MASK_ACCEL_X | GY521_MASK_GYRO_Z), samples, &mask_torn); bench_print(&r);
+	r = bench_poll("poll 4x unpaced", false, samples); bench_print(&r);
+	r = bench_poll("poll 4x paced", true, samples); bench_print(&r);
+	uint32_t fifo_bad = 0;
+	r = bench_fifo("fifo burst 16", 16, samples, &fifo_bad); bench_print(&r);
+	r = bench_fifo("fifo burst 64", 64, samples, &fifo_bad); bench_print(&r);
+
+	uint32_t torn[2];
+	bool aux_ok[2];
+	r = bench_aux("all + mag bypass", false, samples, &torn[0], &aux_ok[0]); bench_print(&r);
+	r = bench_aux("all + mag aux mst", true, samples, &torn[1], &aux_ok[1]); bench_print(&r);
+	printf("\nmagnetometer: bypass %s, %u readings from another sample; aux master %s, %u readings from another sample\n",
+		aux_ok[0] ? "ok" : "FAILED", torn[0], aux_ok[1] ? "ok" : "FAILED", torn[1]);
+	printf("masked reads: %u channel mismatches, two spans: %u channels from a newer sample (unpaced polling)\n", mask_bad, mask_torn);
+	printf("fifo bursts: %u frames dropped, repeated or out of order\n", fifo_bad);
+	bool ok = aux_ok[0] && aux_ok[1] && !torn[1] && !mask_bad && !fifo_bad;
+
+#if GY521_INSTRUMENT
+	char dump[512];
+	bench_poll("poll 4x paced", true, samples);
+	gy521_instrument_dump(&g_dev.inst, dump, sizeof(dump));
+	printf("\ninstrumentation, poll 4x paced:\n%s", dump);
+#endif
+
+	ok = bench_fifo_overflow() && ok;
+	ok = bench_fixed() && ok;
+	ok = bench_two(4000) && ok;
+	printf("\n");
+	ok = bench_interrupt("DLPF off, div 7", GY521_DLPF_260HZ, 7, 5000) && ok;
+	ok = bench_interrupt("DLPF on, div 0", GY521_DLPF_184HZ, 0, 5000) && ok;
+	printf("\nnon-blocking reads on the fake DMA engine (gy521_host_dma()):\n");
+	ok = bench_async(300, samples < 20000 ? samples : 20000) && ok;
+	ok = bench_async(2500, samples < 20000 ? samples : 20000) && ok;
+	ok = bench_baud() && ok;
+	ok = bench_calibrate(1024, 400000) && ok;
+	ok = bench_calibrate(1024, 100000) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_bias_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Online gyro bias tracking (gy521_bias.h) on synthetic drifting
+ *  data: the board warms up from 25 to ~55 °C and cools down again,
+ *  the gyro bias follows the temperature linearly, 12 s still and
+ *  28 s of motion alternate. ±250 °/s, ±2 g, 1 kHz.
+ *  - Open loop, offsets applied in software: remaining bias error
+ *    (RMS / max, overall and in motion) with the boot calibration
+ *    only, tracking without and with the temperature fit
+ *  - Stillness detection: windows in motion taken as still,
+ *    still windows found
+ *  - Fitted slope vs. the true one
+ *  - ns and cycles per sample, plain and window-end samples
+ *  - Closed loop through the driver and the simulator: offsets
+ *    written to the chip while fn.read() keeps streaming
+ *
+ *  Exit code 1 if the error, the detection or the slope is off.
+ *
+ *  Usage: gy521_bias_bench [seconds]
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gy521_bias.h"
+#include "gy521_host.h"
+#include "gy521_sim.h"
+#include "gy521_regs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GY521_BENCH_CYCLES() __rdtsc()
+#else
+#define GY521_BENCH_CYCLES() 0ull
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_ODR_HZ 1000
+#define BENCH_GYRO_LSB 131.0 // Per °/s at ±250 °/s
+#define BENCH_ACCEL_LSB 16384.0 // Per g at ±2 g
+#define BENCH_OFFSET_LSB (BENCH_GYRO_LSB / 4) // Offset register LSB per °/s at ±250 °/s
+#define BENCH_SETTLE_S 60 // Errors counted from here: the fit needs 1 °C of spread, the second still phase
+
+static const double g_bias0[3] = {1.2, -0.8, 0.4}; // °/s at 25 °C
+static const double g_drift[3] = {0.04, -0.06, 0.09}; // °/s per °C
+
+static double g_seconds = 1200;
+static gy521_sample_t *g_feed; // What the open loop tracker got, for the timing run
+
+typedef struct{
+	const char *name;
+	double rms, max, rms_motion; // Remaining bias error in m°/s
+	uint32_t false_still, moving; // Windows fully in motion taken as still / all such windows
+	uint32_t found, still; // Windows fully still found / all such windows
+	uint32_t changes;
+	float slope[3];
+	bool fitted;
+} bench_result_t;
+
+// ================
+// === Scenario ===
+// ================
+static double bench_temp(double t){
+	const double warm = g_seconds * 0.6;
+	const double peak = 25 + 30 * (1 - exp(-warm / 250));
+	if(t < warm) return 25 + 30 * (1 - exp(-t / 250));
+	return 30 + (peak - 30) * exp(-(t - warm) / 150);
+}
+
+static double bench_bias(uint8_t k, double temp){
+	return g_bias0[k] + g_drift[k] * (temp - 25);
+}
+
+static bool bench_moving(double t){
+	return fmod(t, 40) >= 12;
+}
+
+static uint64_t g_rng = 0x9e3779b97f4a7c15ull;
+
+static double bench_gauss(void){
+	double u[2];
+	for(uint8_t i = 0; i < 2; i++){
+		g_rng ^= g_rng << 13;
+		g_rng ^= g_rng >> 7;
+		g_rng ^= g_rng << 17;
+		u[i] = ((g_rng >> 11) + 0.5) / 9007199254740992.0;
+	}
+	return sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+static int16_t bench_clamp(double v){
+	return v > 32767 ? 32767 : v < -32768 ? -32768 : (int16_t)lround(v);
+}
+
+// Raw sample at time t without any offset (gyro = bias + motion + noise)
+static void bench_sample(double t, gy521_sample_t *s){
+	const double temp = bench_temp(t);
+	double a[3] = {0, 0, 1}, g[3] = {0, 0, 0};
+	if(bench_moving(t)){
+		a[0] = 0.3 * sin(2 * M_PI * 0.5 * t);
+		a[1] = 0.3 * cos(2 * M_PI * 0.37 * t);
+		a[2] = sqrt(1 - a[0] * a[0] - a[1] * a[1]) + 0.05 * sin(2 * M_PI * 7 * t);
+		for(uint8_t k = 0; k < 3; k++) g[k] = 40 * sin(2 * M_PI * (0.7 + 0.3 * k) * t + k);
+	}
+
+	int16_t *acc = &s->accel.x, *gyr = &s->gyro.x;
+	for(uint8_t k = 0; k < 3; k++){
+		acc[k] = bench_clamp((a[k] + 0.004 * bench_gauss()) * BENCH_ACCEL_LSB);
+		gyr[k] = bench_clamp((g[k] + bench_bias(k, temp) + 0.08 * bench_gauss()) * BENCH_GYRO_LSB);
+	}
+	s->temp = bench_clamp((temp - 36.53) * 340 + 10 * bench_gauss());
+}
+
+// Remaining bias with the offsets applied, m°/s
+static double bench_error(uint8_t k, double t, int32_t offset){
+	return (bench_bias(k, bench_temp(t)) + offset / BENCH_OFFSET_LSB) * 1000;
+}
+
+// ===================================
+// === Open loop, software offsets ===
+// ===================================
+// mode 0 = boot calibration only, 1 = tracking, 2 = tracking + temperature fit
+static bench_result_t bench_open(const char *name, uint8_t mode){
+	bench_result_t r = {.name = name};
+	gy521_bias_t b;
+	gy521_bias_init(&b);
+	b.conf.model = mode == 2;
+	for(uint8_t k = 0; k < 3; k++) (&b.v.offset.x)[k] = (int32_t)lround(-bench_bias(k, 25) * BENCH_OFFSET_LSB);
+
+	const uint32_t n = (uint32_t)(g_seconds * BENCH_ODR_HZ);
+	double sq = 0, sq_motion = 0;
+	uint32_t count = 0, count_motion = 0, in_window = 0, moving = 0;
+	g_rng = 0x9e3779b97f4a7c15ull;
+
+	for(uint32_t i = 0; i < n; i++){
+		const double t = (double)i / BENCH_ODR_HZ;
+		gy521_sample_t s;
+		bench_sample(t, &s);
+
+		const int32_t *off = &b.v.offset.x;
+		int16_t *g = &s.gyro.x;
+		for(uint8_t k = 0; k < 3; k++) g[k] = bench_clamp(g[k] + 4.0 * off[k]); // What the chip adds
+		if(t >= BENCH_SETTLE_S){
+			for(uint8_t k = 0; k < 3; k++){
+				const double e = bench_error(k, t, off[k]);
+				sq += e * e;
+				if(fabs(e) > r.max) r.max = fabs(e);
+				if(bench_moving(t)) sq_motion += e * e;
+			}
+			count++;
+			count_motion += bench_moving(t);
+		}
+		if(g_feed) g_feed[i] = s;
+		if(mode == 0) continue;
+
+		// Ground truth per window: samples the tracker took in since its last window
+		const uint32_t before = b.v.windows, skipped = b.priv.skip;
+		if(!skipped){
+			in_window++;
+			moving += bench_moving(t);
+		}
+		gy521_bias_update_sample(&b, &s, GY521_ACCEL_FSR_SEL_2G, GY521_GYRO_FSR_SEL_250DPS);
+		if(b.v.windows == before) continue;
+
+		if(moving == in_window){
+			r.moving++;
+			r.false_still += b.v.still;
+		}else if(!moving){
+			r.still++;
+			r.found += b.v.still;
+		}
+		in_window = moving = 0;
+	}
+
+	r.rms = sqrt(sq / (3.0 * count));
+	r.rms_motion = count_motion ? sqrt(sq_motion / (3.0 * count_motion)) : 0;
+	r.changes = b.v.changes;
+	r.fitted = b.v.fitted;
+	for(uint8_t k = 0; k < 3; k++) r.slope[k] = b.v.slope[k];
+	return r;
+}
+
+// ==============
+// === Timing ===
+// ==============
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Same input again (same path: the tracker is deterministic)
+static void bench_timing(uint32_t n){
+	gy521_bias_t b;
+	gy521_bias_init(&b);
+	for(uint8_t k = 0; k < 3; k++) (&b.v.offset.x)[k] = (int32_t)lround(-bench_bias(k, 25) * BENCH_OFFSET_LSB);
+
+	uint64_t t0 = bench_ns();
+	for(uint32_t i = 0; i < n; i++) gy521_bias_update_sample(&b, &g_feed[i], GY521_ACCEL_FSR_SEL_2G, GY521_GYRO_FSR_SEL_250DPS);
+	const uint64_t ns = bench_ns() - t0;
+
+	gy521_bias_init(&b);
+	for(uint8_t k = 0; k < 3; k++) (&b.v.offset.x)[k] = (int32_t)lround(-bench_bias(k, 25) * BENCH_OFFSET_LSB);
+	uint64_t cyc[2] = {0};
+	uint32_t calls[2] = {0};
+	for(uint32_t i = 0; i < n; i++){
+		const uint64_t c0 = GY521_BENCH_CYCLES();
+		const uint8_t done = gy521_bias_update_sample(&b, &g_feed[i], GY521_ACCEL_FSR_SEL_2G, GY521_GYRO_FSR_SEL_250DPS);
+		const uint64_t c = GY521_BENCH_CYCLES() - c0;
+		const uint8_t kind = done ? 1 : 0;
+		cyc[kind] += c;
+		calls[kind]++;
+	}
+
+	printf("\ncost: %.1f ns/sample; cycles per plain sample %.0f, per window-end sample %.0f (%u windows)\n",
+		(double)ns / n, calls[0] ? (double)cyc[0] / calls[0] : 0.0, calls[1] ? (double)cyc[1] / calls[1] : 0.0, calls[1]);
+}
+
+// =================================
+// === Closed loop, driver + sim ===
+// =================================
+static void bench_source(void *user, uint32_t index, gy521_sample_t *out){
+	(void)user;
+	bench_sample((double)index / BENCH_ODR_HZ, out);
+}
+
+static bool bench_closed(double seconds){
+	gy521_bus_t bus;
+	gy521_sim_bus_t sim_bus;
+	gy521_sim_t sim;
+	gy521_sim_bus_init(&sim_bus, &bus);
+	gy521_sim_init(&sim, GY521_I2C_ADDR_GND);
+	gy521_sim_attach(&sim_bus, &sim);
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &sim_bus);
+	sim.source = &bench_source;
+	g_rng = 0x2545f4914f6cdd1dull;
+
+	gy521_s dev = gy521_init(&bus, GY521_I2C_ADDR_GND);
+	dev.conf.sleep = false;
+	dev.conf.accel.fsr = GY521_ACCEL_FSR_SEL_2G;
+	dev.conf.gyro.fsr = GY521_GYRO_FSR_SEL_250DPS;
+	dev.conf.rate.dlpf = GY521_DLPF_44HZ;
+	dev.conf.rate.div = 0; // 1 kHz
+	if(!dev.fn.commit(&dev) || !dev.fn.gyro.calibrate(&dev, 1024)){
+		printf("closed loop: setup FAILED\n");
+		return false;
+	}
+
+	gy521_bias_t b;
+	gy521_bias_init(&b);
+	const uint32_t writes0 = bus.stat.transactions;
+	uint32_t reads = 0, failed = 0, written = 0;
+	double sq = 0, max = 0;
+	uint32_t count = 0;
+
+	while(sim.index < seconds * BENCH_ODR_HZ){
+		gy521_sim_advance(&sim_bus, 1000000 / BENCH_ODR_HZ);
+		if(!dev.fn.read(&dev, GY521_ALL)){
+			failed++;
+			continue;
+		}
+		reads++;
+		if(gy521_bias_update(&b, &dev) & GY521_BIAS_OFFSET) written++;
+
+		const double t = (double)sim.index / BENCH_ODR_HZ;
+		if(t < BENCH_SETTLE_S) continue;
+		const uint8_t *reg = &sim.reg[GY521_REG_XG_OFFS_USRH];
+		for(uint8_t k = 0; k < 3; k++){
+			const double e = bench_error(k, t, (int16_t)((reg[2 * k] << 8) | reg[2 * k + 1]));
+			sq += e * e;
+			if(fabs(e) > max) max = fabs(e);
+		}
+		count++;
+	}
+
+	const uint8_t *reg = &sim.reg[GY521_REG_XG_OFFS_USRH];
+	bool match = true;
+	for(uint8_t k = 0; k < 3; k++)
+		match &= (int16_t)((reg[2 * k] << 8) | reg[2 * k + 1]) == (&dev.conf.gyro.offset.x)[k];
+
+	const double rms = sqrt(sq / (3.0 * count));
+	const bool ok = !failed && match && written == b.v.changes && rms < 60 && max < 200;
+	printf("\nclosed loop %.0f s through the driver: %u reads, %u failed, %u offset writes (%.2f/s), %u bus transfers\n",
+		seconds, reads, failed, written, written / seconds, bus.stat.transactions - writes0);
+	printf("chip offsets %s conf, error RMS %.1f max %.1f m°/s: %s\n", match ? "match" : "DIFFER FROM", rms, max, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int main(int argc, char **argv){
+	if(argc > 1) g_seconds = strtod(argv[1], NULL);
+	if(g_seconds < 200) g_seconds = 200;
+	const uint32_t n = (uint32_t)(g_seconds * BENCH_ODR_HZ);
+
+	printf("gy521 bias tracking, %.0f s at 1 kHz, 25 -> %.1f -> %.1f °C, 12 s still / 28 s motion\n",
+		g_seconds, bench_temp(g_seconds * 0.6), bench_temp(g_seconds));
+	printf("true drift %.3f %.3f %.3f °/s per °C, errors from %d s on\n\n", g_drift[0], g_drift[1], g_drift[2], BENCH_SETTLE_S);
+	printf("%-22s %9s %9s %9s %8s %12s %10s\n", "", "rms", "max", "motion", "changes", "false still", "found");
+
+	g_feed = malloc(n * sizeof(*g_feed));
+	if(!g_feed) return 1;
+
+	bench_result_t r[3] = {
+		bench_open("boot calibration only", 0),
+		bench_open("tracking", 1),
+		bench_open("tracking + temp fit", 2), // Last: g_feed holds its input
+	};
+	for(uint8_t i = 0; i < 3; i++){
+		printf("%-22s %9.1f %9.1f %9.1f %8u", r[i].name, r[i].rms, r[i].max, r[i].rms_motion, r[i].changes);
+		if(i) printf(" %6u/%-5u %5u/%-5u", r[i].false_still, r[i].moving, r[i].found, r[i].still);
+		printf("\n");
+	}
+	printf("(m°/s; windows of %u samples)\n", GY521_BIAS_WINDOW);
+
+	bool ok = true;
+	const bench_result_t *fit = &r[2];
+	printf("\nslope, offset LSB per °C:\n");
+	for(uint8_t k = 0; k < 3; k++){
+		const double truth = -g_drift[k] * BENCH_OFFSET_LSB;
+		const double rel = fabs(fit->slope[k] - truth) / fabs(truth);
+		const bool good = fit->fitted && rel < 0.1;
+		printf("  %c  fitted %7.3f  true %7.3f  %5.1f %%  %s\n", 'x' + k, fit->slope[k], truth, 100 * rel, good ? "ok" : "FAILED");
+		ok &= good;
+	}
+
+	for(uint8_t i = 1; i < 3; i++){
+		const bool detect = !r[i].false_still && r[i].found >= r[i].still * 0.9;
+		if(!detect) printf("%s: stillness detection FAILED\n", r[i].name);
+		ok &= detect;
+	}
+	const bool tracked = fit->rms < 50 && fit->max < 150 && fit->rms_motion < r[1].rms_motion && fit->rms < r[0].rms / 10;
+	if(!tracked) printf("tracking + temp fit: error FAILED\n");
+	ok &= tracked;
+
+	bench_timing(n);
+	free(g_feed);
+	g_feed = NULL;
+
+	ok &= bench_closed(g_seconds / 2);
+	printf("\n%s\n", ok ? "all ok" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_cpp_bench.cpp
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  C path vs. the compile-time specialized C++ wrapper
+ *  (gy521.hpp), ±8 g / ±2000 °/s. Reports ns and cycles per
+ *  sample for:
+ *  - read + scale against the register simulator
+ *    (fn.read() with conf.fixed / conf.scaled vs. Device::read())
+ *  - decode + scale only (gy521_decode() vs. Device::decode())
+ *  Results of both paths are compared (fixed: identical, float:
+ *  within a few rounding steps). The wrapper's register values
+ *  are checked against the driver's with static_assert.
+ *
+ *  Exit code 1 on a mismatch.
+ *
+ *  Usage: gy521_cpp_bench [samples]
+ *
+ * ================================================================
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gy521.hpp"
+#include "gy521_host.h"
+#include "gy521_sim.h"
+extern "C"{
+#include "gy521_port.h" // gy521_decode()
+#include "gy521_regs.h"
+#include "gy521_scale.h"
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GY521_BENCH_CYCLES() __rdtsc()
+#else
+#define GY521_BENCH_CYCLES() 0ull
+#endif
+
+using Imu = gy521::Device<GY521_I2C_ADDR_GND, GY521_ACCEL_FSR_SEL_8G, GY521_GYRO_FSR_SEL_2000DPS>;
+
+// ===============================
+// === Wrapper vs. C registers ===
+// ===============================
+static_assert(gy521::reg::accel_xout_h == GY521_REG_ACCEL_XOUT_H, "Data register");
+static_assert(Imu::accel_config == 0x10 && Imu::gyro_config == 0x18 && Imu::clksel == 0x01, "Register values");
+static_assert(gy521::accel_mg_q16(GY521_ACCEL_FSR_SEL_2G) == GY521_ACCEL_MG_Q16, "Accel Q16");
+static_assert(gy521::gyro_mdps_q16(GY521_GYRO_FSR_SEL_250DPS) == GY521_GYRO_MDPS_Q16, "Gyro Q16");
+static_assert(gy521::temp_mc_q16 == GY521_TEMP_MC_Q16 && gy521::temp_mc_offset == GY521_TEMP_MC_OFFSET, "Temp Q16");
+static_assert(Imu::mg_q16 == GY521_ACCEL_MG_Q16 << 2, "Accel Q16 at ±8 g");
+
+#define BENCH_FRAMES 512
+
+static gy521_sim_bus_t g_sim_bus;
+static gy521_bus_t g_bus;
+static gy521_sim_t g_sim;
+static uint8_t g_frames[BENCH_FRAMES * 14];
+
+// Scaled sample in both unit systems
+typedef struct{
+	int32_t fixed[7]; // mg, m°C, m°/s
+	float flt[7]; // g, °C, °/s
+} bench_out_t;
+
+// Results land in memory like dev->v does (external linkage: the stores stay)
+gy521_sample_t g_sample;
+bench_out_t g_out;
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+typedef struct{
+	const char *name;
+	uint64_t ns, cycles;
+	uint32_t samples;
+} bench_result_t;
+
+static void bench_print(const bench_result_t *r){
+	double n = r->samples ? r->samples : 1;
+	printf("%-24s %10.2f %10.1f\n", r->name, r->ns / n, r->cycles / n);
+}
+
+static void bench_sim(void){
+	gy521_sim_bus_init(&g_sim_bus, &g_bus);
+	gy521_sim_init(&g_sim, GY521_I2C_ADDR_GND);
+	gy521_sim_attach(&g_sim_bus, &g_sim);
+	g_sim_bus.baud = 0; // CPU only
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &g_sim_bus);
+}
+
+static void bench_cpp_scale(const gy521_sample_t &s, bench_out_t &o, bool fixed){
+	const int16_t *a = &s.accel.x, *g = &s.gyro.x;
+	for(uint8_t k = 0; k < 3; k++){
+		if(fixed){
+			o.fixed[k] = Imu::mg(a[k]);
+			o.fixed[4 + k] = Imu::mdps(g[k]);
+		}else{
+			o.flt[k] = Imu::g(a[k]);
+			o.flt[4 + k] = Imu::dps(g[k]);
+		}
+	}
+	if(fixed) o.fixed[3] = Imu::mcelsius(s.temp);
+	else o.flt[3] = Imu::celsius(s.temp);
+}
+
+static void bench_c_out(const gy521_s &dev, bench_out_t &o){
+	const int32_t fixed[7] = {dev.v.accel.mg.x, dev.v.accel.mg.y, dev.v.accel.mg.z, dev.v.temp.mcelsius,
+		dev.v.gyro.mdps.x, dev.v.gyro.mdps.y, dev.v.gyro.mdps.z};
+	const float flt[7] = {dev.v.accel.g.x, dev.v.accel.g.y, dev.v.accel.g.z, dev.v.temp.celsius,
+		dev.v.gyro.dps.x, dev.v.gyro.dps.y, dev.v.gyro.dps.z};
+	for(uint8_t c = 0; c < 7; c++){
+		o.fixed[c] = fixed[c];
+		o.flt[c] = flt[c];
+	}
+}
+
+// ====================
+// === Read + Scale ===
+// ====================
+// variant 0 = C fixed, 1 = C float, 2 = C++ fixed, 3 = C++ float
+static bench_result_t bench_read(const char *name, uint8_t variant, uint32_t samples){
+	bench_sim();
+	Imu imu(&g_bus);
+	imu.begin();
+	gy521_s &dev = imu.c();
+	dev.conf.fixed = variant == 0;
+	dev.conf.scaled = variant == 1;
+
+	bench_result_t r = {name, 0, 0, 0};
+	uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+	for(uint32_t i = 0; i < samples; i++){
+		if(variant < 2){
+			if(!dev.fn.read(&dev, GY521_ALL)) continue;
+		}else{
+			if(!imu.read(g_sample)) continue;
+			bench_cpp_scale(g_sample, g_out, variant == 2);
+		}
+		r.samples++;
+	}
+	r.cycles = GY521_BENCH_CYCLES() - c0;
+	r.ns = bench_ns() - t0;
+	return r;
+}
+
+// ===========================
+// === Decode + Scale only ===
+// ===========================
+static bench_result_t bench_decode(const char *name, uint8_t variant, uint32_t samples){
+	bench_sim();
+	Imu imu(&g_bus);
+	gy521_s &dev = imu.c();
+	gy521_set_fsr(&dev);
+	dev.conf.fixed = variant == 0;
+	dev.conf.scaled = variant == 1;
+
+	bench_result_t r = {name, 0, 0, 0};
+	uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+	while(r.samples < samples){
+		for(uint16_t i = 0; i < BENCH_FRAMES; i++){
+			const uint8_t *f = &g_frames[i * 14];
+			if(variant < 2){
+				gy521_decode(&dev, GY521_ALL, f);
+			}else{
+				Imu::decode(f, g_sample);
+				bench_cpp_scale(g_sample, g_out, variant == 2);
+			}
+		}
+		r.samples += BENCH_FRAMES;
+	}
+	r.cycles = GY521_BENCH_CYCLES() - c0;
+	r.ns = bench_ns() - t0;
+	return r;
+}
+
+// =========================
+// === C vs. C++ results ===
+// =========================
+static uint32_t bench_check(void){
+	bench_sim();
+	Imu imu(&g_bus);
+	gy521_s &dev = imu.c();
+	gy521_set_fsr(&dev);
+	dev.conf.fixed = dev.conf.scaled = true;
+
+	// Runtime tables of the C driver after fn.fsr()
+	uint32_t bad = dev.conf.accel.fixed_mul != Imu::mg_q16 || dev.conf.gyro.fixed_mul != Imu::mdps_q16;
+
+	for(uint16_t i = 0; i < BENCH_FRAMES; i++){
+		const uint8_t *f = &g_frames[i * 14];
+		bench_out_t c, cpp;
+		gy521_sample_t s;
+		gy521_decode(&dev, GY521_ALL, f);
+		bench_c_out(dev, c);
+		Imu::decode(f, s);
+		bench_cpp_scale(s, cpp, true);
+		bench_cpp_scale(s, cpp, false);
+
+		for(uint8_t k = 0; k < 7; k++){
+			float tol = 2e-6f * (k == 3 ? fabsf(cpp.flt[k] - 36.53f) + 36.53f : fabsf(c.flt[k])) + 1e-6f;
+			if(c.fixed[k] != cpp.fixed[k] || fabsf(c.flt[k] - cpp.flt[k]) > tol) bad++;
+		}
+	}
+	return bad;
+}
+
+int main(int argc, char **argv){
+	uint32_t samples = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+
+	srand(521);
+	for(uint32_t i = 0; i < sizeof(g_frames); i++) g_frames[i] = (uint8_t)rand();
+
+	printf("gy521 C vs. C++ wrapper, %u samples, ±8 g / ±2000 °/s\n\n", samples);
+	printf("%-24s %10s %10s\n", "variant", "ns/smp", "cyc/smp");
+
+	bench_result_t r;
+	r = bench_read("C read fixed", 0, samples); bench_print(&r);
+	r = bench_read("C++ read fixed", 2, samples); bench_print(&r);
+	r = bench_read("C read float", 1, samples); bench_print(&r);
+	r = bench_read("C++ read float", 3, samples); bench_print(&r);
+	r = bench_decode("C decode fixed", 0, samples); bench_print(&r);
+	r = bench_decode("C++ decode fixed", 2, samples); bench_print(&r);
+	r = bench_decode("C decode float", 1, samples); bench_print(&r);
+	r = bench_decode("C++ decode float", 3, samples); bench_print(&r);
+
+	uint32_t bad = bench_check();
+	printf("\nC vs. C++: %u mismatches in %d frames: %s\n", bad, BENCH_FRAMES, bad ? "FAILED" : "ok");
+
+	return bad ? 1 : 0;
+}
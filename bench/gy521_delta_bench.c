@@ -0,0 +1,268 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_delta_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Change-only delta stream (gy521_delta.h) on a recorded
+ *  session: CSV from gy521_decode
+ *  (seq,timestamp_us,ax,ay,az,temp,gx,gy,gz), or without -r a
+ *  synthetic 1 kHz one (sensor lying still with noise, a few
+ *  motion bursts).
+ *  Per deadband: bytes per sample and compression vs. telemetry
+ *  frames and printf lines, packets sent, encode ns per sample.
+ *  Every stream is decoded again, the receiver's value must stay
+ *  within the deadband of every input sample. Then a damaged
+ *  stream (bit flips, dropped bytes): no decoded packet may
+ *  differ from the one sent.
+ *
+ *  Exit code 1 on a failed check.
+ *
+ *  Usage: gy521_delta_bench [-r samples.csv] [seconds]
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gy521_delta.h"
+#include "gy521_telemetry.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_TEXT_BYTES 110 // printf line of main.c
+
+static gy521_frame_t *g_in; // Recorded samples
+static uint32_t g_n;
+static uint8_t *g_stream; // Encoded stream
+static size_t g_size;
+static gy521_frame_t *g_sent; // Receiver's values after every packet sent
+static uint32_t g_packets;
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void bench_ch(const gy521_sample_t *s, int16_t c[7]){
+	c[0] = s->accel.x; c[1] = s->accel.y; c[2] = s->accel.z;
+	c[3] = s->temp;
+	c[4] = s->gyro.x; c[5] = s->gyro.y; c[6] = s->gyro.z;
+}
+
+static double bench_noise(double sigma){
+	double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+	return sigma * sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+// ================
+// === Sessions ===
+// ================
+// ±8 g (4096 LSB/g), ±2000 °/s (16.4 LSB/(°/s)): still on a table, 3 % of the time moved
+static void bench_synthetic(uint32_t seconds){
+	g_n = seconds * 1000;
+	g_in = calloc(g_n, sizeof(*g_in));
+	for(uint32_t i = 0; i < g_n; i++){
+		const double t = i / 1000.0;
+		const double burst = fmod(t, 100.0) < 3.0 ? sin(M_PI * fmod(t, 100.0) / 3.0) : 0.0;
+		const double a[3] = {1500 * burst * sin(2 * M_PI * 1.3 * t), 900 * burst * sin(2 * M_PI * 0.7 * t), 4096 + 600 * burst * cos(2 * M_PI * 2.1 * t)};
+		const double g[3] = {1200 * burst * cos(2 * M_PI * 1.3 * t), 800 * burst * sin(2 * M_PI * 0.9 * t), 300 * burst};
+		gy521_frame_t *f = &g_in[i];
+		f->seq = i + 1;
+		f->timestamp_us = i * 1000ull;
+		f->sample.accel = (gy521_axis_raw_t){(int16_t)lround(a[0] + bench_noise(4)), (int16_t)lround(a[1] + bench_noise(4)),
+			(int16_t)lround(a[2] + bench_noise(5))};
+		f->sample.temp = (int16_t)lround(-2000 + 30 * t / 60 + bench_noise(3)); // ~30 °C, slow drift
+		f->sample.gyro = (gy521_axis_raw_t){(int16_t)lround(g[0] + bench_noise(2)), (int16_t)lround(g[1] + bench_noise(2)),
+			(int16_t)lround(g[2] + bench_noise(2))};
+	}
+}
+
+static bool bench_csv(const char *path){
+	FILE *f = fopen(path, "r");
+	if(!f) return false;
+
+	uint32_t cap = 0;
+	char line[256];
+	while(fgets(line, sizeof(line), f)){
+		unsigned long seq;
+		unsigned long long t;
+		int v[7];
+		if(sscanf(line, "%lu,%llu,%d,%d,%d,%d,%d,%d,%d", &seq, &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 9) continue;
+		if(g_n == cap){
+			cap = cap ? cap * 2 : 4096;
+			g_in = realloc(g_in, cap * sizeof(*g_in));
+			if(!g_in) return false;
+		}
+		g_in[g_n++] = (gy521_frame_t){.seq = (uint32_t)seq, .timestamp_us = t,
+			.sample = {.accel = {v[0], v[1], v[2]}, .temp = v[3], .gyro = {v[4], v[5], v[6]}}};
+	}
+	fclose(f);
+	return g_n > 0;
+}
+
+// ==================
+// === Round Trip ===
+// ==================
+typedef struct{
+	uint64_t ns;
+	uint32_t outside; // Samples the receiver has further off than the deadband
+	uint32_t max_err[7];
+	uint32_t bad_packets; // Decoded != sent, or missing
+} bench_result_t;
+
+// Input samples before 'seq' against the receiver's values 'have'
+static void bench_hold(bench_result_t *r, const gy521_delta_encoder_t *e, const gy521_frame_t *have, uint32_t *k, uint32_t seq){
+	int16_t c[7], h[7];
+	bench_ch(&have->sample, h);
+	for(; *k < g_n && g_in[*k].seq < seq; (*k)++){
+		bench_ch(&g_in[*k].sample, c);
+		bool out = false;
+		for(uint8_t ch = 0; ch < 7; ch++){
+			const uint32_t err = (uint32_t)abs(c[ch] - h[ch]);
+			if(err > r->max_err[ch]) r->max_err[ch] = err;
+			if(err > e->conf.deadband[ch]) out = true;
+		}
+		r->outside += out;
+	}
+}
+
+static bench_result_t bench_run(uint16_t accel_lsb, uint16_t gyro_lsb, uint16_t temp_lsb, gy521_delta_encoder_t *e){
+	bench_result_t r = {0};
+	gy521_delta_init(e, accel_lsb, gyro_lsb);
+	e->conf.deadband[3] = temp_lsb;
+
+	g_size = 0;
+	g_packets = 0;
+	uint8_t pkt[GY521_DELTA_MAX_SIZE];
+	for(uint32_t i = 0; i < g_n; i++){
+		uint64_t t0 = bench_ns();
+		uint8_t len = gy521_delta_encode_frame(e, &g_in[i], pkt);
+		r.ns += bench_ns() - t0;
+		if(!len) continue;
+		memcpy(&g_stream[g_size], pkt, len);
+		g_size += len;
+		const int16_t *c = e->priv.last; // What the receiver has now
+		g_sent[g_packets++] = (gy521_frame_t){.seq = g_in[i].seq, .timestamp_us = g_in[i].timestamp_us,
+			.sample = {.accel = {c[0], c[1], c[2]}, .temp = c[3], .gyro = {c[4], c[5], c[6]}}};
+	}
+
+	// Decode, the receiver holds each packet's values until the next one
+	gy521_delta_decoder_t d;
+	gy521_delta_decoder_init(&d);
+	gy521_frame_t f, have = {0};
+	uint32_t k = 0, p = 0;
+	for(size_t b = 0; b < g_size; b++){
+		if(!gy521_delta_decode(&d, g_stream[b], &f)) continue;
+
+		const gy521_frame_t *sent = &g_sent[p++];
+		r.bad_packets += f.seq != sent->seq || f.timestamp_us != sent->timestamp_us || memcmp(&f.sample, &sent->sample, sizeof(f.sample));
+		bench_hold(&r, e, &have, &k, f.seq);
+		have = f;
+	}
+	bench_hold(&r, e, &have, &k, UINT32_MAX);
+	r.bad_packets += p != g_packets;
+	return r;
+}
+
+// ======================
+// === Damaged Stream ===
+// ======================
+static int bench_sent_cmp(const void *key, const void *elem){
+	const uint32_t seq = *(const uint32_t *)key, s = ((const gy521_frame_t *)elem)->seq;
+	return seq < s ? -1 : seq > s;
+}
+
+// Decoded packets that differ from the sent one (g_sent / g_stream of the last run)
+static uint32_t bench_damaged(uint32_t *decoded, gy521_delta_decoder_t *d){
+	gy521_delta_decoder_init(d);
+	gy521_frame_t f;
+	uint32_t wrong = 0;
+	*decoded = 0;
+	srand(521);
+	for(size_t b = 0; b < g_size; b++){
+		uint8_t byte = g_stream[b];
+		if(rand() % 2000 == 0) continue; // Dropped
+		if(rand() % 2000 == 0) byte ^= (uint8_t)(1 << (rand() % 8)); // Bit flip
+		if(!gy521_delta_decode(d, byte, &f)) continue;
+
+		(*decoded)++;
+		const gy521_frame_t *sent = bsearch(&f.seq, g_sent, g_packets, sizeof(*g_sent), bench_sent_cmp);
+		wrong += !sent || sent->timestamp_us != f.timestamp_us || memcmp(&sent->sample, &f.sample, sizeof(f.sample));
+	}
+	return wrong;
+}
+
+int main(int argc, char **argv){
+	const char *csv = NULL;
+	uint32_t seconds = 600;
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-r") && i + 1 < argc) csv = argv[++i];
+		else seconds = (uint32_t)strtoul(argv[i], NULL, 10);
+	}
+	if(!seconds) seconds = 1;
+	srand(521);
+	if(csv){
+		if(!bench_csv(csv)){
+			fprintf(stderr, "%s: no samples\n", csv);
+			return 2;
+		}
+	}else bench_synthetic(seconds);
+
+	g_stream = malloc((size_t)g_n * GY521_DELTA_MAX_SIZE);
+	g_sent = malloc((size_t)g_n * sizeof(*g_sent));
+	if(!g_stream || !g_sent) return 1;
+
+	const double t_s = (g_in[g_n - 1].timestamp_us - g_in[0].timestamp_us) / 1e6;
+	printf("gy521 change-only delta stream, %u samples over %.0f s (%s)\n\n", g_n, t_s, csv ? csv : "synthetic, still + 3 % motion");
+	printf("%-22s %9s %9s %8s %8s %9s %8s %10s\n", "deadband a/g/t LSB", "B/smp", "packets", "vs. tlm", "vs. txt",
+		"max err a", "g", "enc ns/smp");
+
+	const uint16_t bands[][3] = {{0, 0, 0}, {8, 4, 17}, {16, 8, 34}, {64, 32, 68}};
+	uint32_t bad = 0;
+	gy521_delta_encoder_t e;
+	for(uint8_t k = 0; k < 4; k++){
+		const bench_result_t r = bench_run(bands[k][0], bands[k][1], bands[k][2], &e);
+		const double bps = (double)g_size / g_n;
+		char name[24];
+		snprintf(name, sizeof(name), "%u / %u / %u", bands[k][0], bands[k][1], bands[k][2]);
+		uint32_t ea = 0, eg = 0;
+		for(uint8_t a = 0; a < 3; a++){
+			if(r.max_err[a] > ea) ea = r.max_err[a];
+			if(r.max_err[4 + a] > eg) eg = r.max_err[4 + a];
+		}
+		printf("%-22s %9.2f %8.1f%% %7.1fx %7.0fx %9u %8u %10.1f\n", name, bps, 100.0 * g_packets / g_n,
+			GY521_TELEMETRY_FRAME_SIZE / bps, BENCH_TEXT_BYTES / bps, ea, eg, (double)r.ns / g_n);
+
+		if(r.outside || r.bad_packets){
+			printf("  %u samples outside the deadband, %u packets decoded wrong\n", r.outside, r.bad_packets);
+			bad++;
+		}
+	}
+
+	// Damaged copy of the last stream
+	gy521_delta_decoder_t d;
+	uint32_t decoded;
+	const uint32_t wrong = bench_damaged(&decoded, &d);
+	printf("\ndamaged stream (1/2000 bytes dropped, 1/2000 flipped): %u of %u packets decoded, %u wrong,\n", decoded, g_packets, wrong);
+	printf("  crc errors %u, lost %u, dropped until keyframe %u, skipped bytes %u\n", d.stat.crc_errors, d.stat.lost,
+		d.stat.unsynced, d.stat.skipped);
+	if(wrong || decoded < g_packets / 2) bad++;
+
+	printf("\ndelta checks: %s\n", bad ? "FAILED" : "ok");
+	free(g_in);
+	free(g_stream);
+	free(g_sent);
+	return bad ? 1 : 0;
+}
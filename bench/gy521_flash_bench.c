@@ -0,0 +1,344 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_flash_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Calibration + configuration in flash (gy521_flash.h) on the
+ *  flash stand-in of the simulator:
+ *  - Boot: simulated time of commit + calibrate(1024) + save vs.
+ *    gy521_flash_restore(), chip registers after the restore
+ *  - Rejected: erased region, other tag, other version, a flipped
+ *    payload byte
+ *  - Wear: two devices (0x68 / 0x69) saving in turns, the newest
+ *    record of both loads after every save, erases per sector,
+ *    unchanged saves write nothing
+ *  - Power cuts: at every byte of a save (with and without sector
+ *    erase) the device loads the old or the new record, the other
+ *    device its record
+ *
+ *  Exit code 1 on any mismatch.
+ *
+ *  Usage: gy521_flash_bench [saves]
+ *
+ * ================================================================
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gy521_flash.h"
+#include "gy521_host.h"
+#include "gy521_sim.h"
+#include "gy521_regs.h"
+#include "gy521_telemetry.h"
+
+#define BENCH_SECTORS 4
+#define BENCH_SIZE (BENCH_SECTORS * GY521_FLASH_SECTOR)
+#define BENCH_CYCLES 100000 // Erase cycles a sector is good for (datasheet minimum)
+#define BENCH_SAVE_S 600 // One save per 10 minutes, as main.c
+
+static uint8_t g_mem[BENCH_SIZE], g_snap[BENCH_SIZE];
+static gy521_sim_flash_t g_sim_flash, g_sim_flash_snap;
+static gy521_flash_t g_flash, g_flash_snap;
+
+static gy521_sim_bus_t g_sim_bus;
+static gy521_sim_t g_sim[2];
+static gy521_bus_t g_bus;
+
+static void bench_snapshot(void){
+	memcpy(g_snap, g_mem, BENCH_SIZE);
+	g_sim_flash_snap = g_sim_flash;
+	g_flash_snap = g_flash;
+}
+
+static void bench_rollback(void){
+	memcpy(g_mem, g_snap, BENCH_SIZE);
+	g_sim_flash = g_sim_flash_snap;
+	g_flash = g_flash_snap;
+}
+
+// Fresh chips on a fresh bus, virtual time 0
+static void bench_power_up(void){
+	gy521_sim_bus_init(&g_sim_bus, &g_bus);
+	gy521_sim_init(&g_sim[0], GY521_I2C_ADDR_GND);
+	gy521_sim_init(&g_sim[1], GY521_I2C_ADDR_VCC);
+	gy521_sim_attach(&g_sim_bus, &g_sim[0]);
+	gy521_sim_attach(&g_sim_bus, &g_sim[1]);
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &g_sim_bus);
+}
+
+// Configuration as main.c sets it up
+static gy521_s bench_device(uint8_t addr){
+	gy521_s dev = gy521_init(&g_bus, addr);
+	dev.conf.sleep = false;
+	dev.conf.clksel = GY521_CLKSEL_GYRO_X;
+	dev.conf.accel.fsr = GY521_ACCEL_FSR_SEL_8G;
+	dev.conf.gyro.fsr = GY521_GYRO_FSR_SEL_2000DPS;
+	dev.conf.rate.dlpf = GY521_DLPF_184HZ;
+	dev.conf.rate.div = 9;
+	dev.conf.motion.threshold = 20;
+	dev.conf.motion.duration = 40;
+	return dev;
+}
+
+// Offsets as they come back from a record, stand-in for a calibration
+static void bench_offsets(gy521_s *dev, int32_t v){
+	dev->conf.gyro.offset = (gy521_offset_t){v, -v, v / 2};
+	dev->conf.accel.offset = (gy521_offset_t){2 * v, 100 - v, -2 * v};
+	dev->priv.offsets_known = true;
+}
+
+// Gyro offset x of the newest record of 'addr', INT32_MIN = none
+static int32_t bench_stored(uint8_t addr){
+	gy521_s dev = bench_device(addr);
+	if(!gy521_flash_load(&g_flash, &dev)) return INT32_MIN;
+	return dev.conf.gyro.offset.x;
+}
+
+// Registers the restore must have written, 0 = all there
+static uint32_t bench_registers(const gy521_sim_t *sim, const gy521_s *dev){
+	const uint8_t *reg = sim->reg;
+	uint32_t bad = 0;
+	bad += (reg[GY521_REG_ACCEL_CONFIG] & 0x18) != dev->conf.accel.fsr;
+	bad += (reg[GY521_REG_GYRO_CONFIG] & 0x18) != dev->conf.gyro.fsr;
+	bad += reg[GY521_REG_SMPLRT_DIV] != dev->conf.rate.div;
+	bad += (reg[GY521_REG_CONFIG] & 0x07) != dev->conf.rate.dlpf;
+	bad += (reg[GY521_REG_PWR_MGMT_1] & GY521_SLEEP) != 0;
+	bad += (reg[GY521_REG_PWR_MGMT_1] & 0x07) != dev->conf.clksel;
+	const int32_t *g = &dev->conf.gyro.offset.x;
+	for(uint8_t k = 0; k < 3; k++)
+		bad += (int16_t)((reg[GY521_REG_XG_OFFS_USRH + 2 * k] << 8) | reg[GY521_REG_XG_OFFS_USRH + 2 * k + 1]) != g[k];
+	return bad;
+}
+
+// ============
+// === Boot ===
+// ============
+static uint32_t bench_boot(void){
+	uint32_t bad = 0;
+	gy521_sim_flash_init(&g_sim_flash, &g_flash, g_mem, BENCH_SIZE);
+	g_sim_flash.clock = &g_sim_bus;
+
+	// First boot: nothing stored, configure + calibrate + save
+	bench_power_up();
+	gy521_s dev = bench_device(GY521_I2C_ADDR_GND);
+	if(gy521_flash_restore(&g_flash, &dev)){
+		printf("restore from an erased region succeeded\n");
+		bad++;
+	}
+	uint64_t t0 = gy521_sim_now(&g_sim_bus);
+	if(!dev.fn.commit(&dev) || !dev.fn.calibrate(&dev, 1024) || !gy521_flash_save(&g_flash, &dev)){
+		printf("first boot failed\n");
+		return bad + 1;
+	}
+	const uint64_t cold_us = gy521_sim_now(&g_sim_bus) - t0;
+	const gy521_s saved = dev;
+
+	// Second boot: chip at power-up, a device struct with other values
+	bench_power_up();
+	gy521_s next = gy521_init(&g_bus, GY521_I2C_ADDR_GND);
+	t0 = gy521_sim_now(&g_sim_bus);
+	if(!gy521_flash_restore(&g_flash, &next)){
+		printf("restore failed\n");
+		return bad + 1;
+	}
+	const uint64_t warm_us = gy521_sim_now(&g_sim_bus) - t0;
+
+	printf("boot, configure + calibrate(1024) + save  %8.1f ms\n", cold_us / 1000.0);
+	printf("boot, gy521_flash_restore()               %8.1f ms\n", warm_us / 1000.0);
+
+	if(memcmp(&next.conf.gyro.offset, &saved.conf.gyro.offset, sizeof(gy521_offset_t)) ||
+	   memcmp(&next.conf.accel.offset, &saved.conf.accel.offset, sizeof(gy521_offset_t)) ||
+	   next.conf.rate.div != saved.conf.rate.div || next.conf.motion.threshold != saved.conf.motion.threshold){
+		printf("restored conf differs from the saved one\n");
+		bad++;
+	}
+	const uint32_t regs = bench_registers(&g_sim[0], &next);
+	if(regs){
+		printf("%u registers not restored\n", regs);
+		bad++;
+	}
+	if(warm_us * 10 > cold_us){
+		printf("restore not 10x faster than calibrating\n");
+		bad++;
+	}
+	return bad;
+}
+
+// ================
+// === Rejected ===
+// ================
+static uint32_t bench_reject(void){
+	uint32_t bad = 0;
+	gy521_sim_flash_init(&g_sim_flash, &g_flash, g_mem, BENCH_SIZE);
+	bench_power_up();
+	gy521_s dev = bench_device(GY521_I2C_ADDR_GND);
+	bench_offsets(&dev, 77);
+	gy521_flash_save(&g_flash, &dev);
+	const uint16_t size = 11 + g_mem[10] + 2;
+
+	g_flash.tag = 1;
+	bad += bench_stored(GY521_I2C_ADDR_GND) != INT32_MIN;
+	g_flash.tag = 0;
+	bad += bench_stored(GY521_I2C_ADDR_GND) != 77;
+
+	// Other version with a good CRC
+	bench_snapshot();
+	g_mem[2]++;
+	const uint16_t crc = gy521_telemetry_crc16(g_mem, size - 2);
+	g_mem[size - 2] = (uint8_t)crc;
+	g_mem[size - 1] = (uint8_t)(crc >> 8);
+	bad += bench_stored(GY521_I2C_ADDR_GND) != INT32_MIN;
+	bench_rollback();
+
+	// Every single bit flip of the record
+	uint32_t accepted = 0;
+	for(uint16_t i = 0; i < size; i++){
+		for(uint8_t b = 0; b < 8; b++){
+			g_mem[i] ^= (uint8_t)(1u << b);
+			accepted += bench_stored(GY521_I2C_ADDR_GND) != INT32_MIN;
+			g_mem[i] ^= (uint8_t)(1u << b);
+		}
+	}
+	printf("rejected: erased / other tag / other version / %u of %u bit flips\n", size * 8 - accepted, size * 8);
+	if(bad) printf("tag or version not checked\n");
+	if(accepted){
+		printf("%u corrupted records accepted\n", accepted);
+		bad++;
+	}
+	return bad;
+}
+
+// ============
+// === Wear ===
+// ============
+static uint32_t bench_wear(uint32_t saves){
+	uint32_t bad = 0, lost = 0;
+	gy521_sim_flash_init(&g_sim_flash, &g_flash, g_mem, BENCH_SIZE);
+	bench_power_up();
+	gy521_s dev[2] = {bench_device(GY521_I2C_ADDR_GND), bench_device(GY521_I2C_ADDR_VCC)};
+	int32_t last[2] = {0, 0};
+
+	for(uint32_t i = 0; i < saves; i++){
+		// 0x68 changes every time, 0x69 every third
+		const uint8_t d = i % 3 == 2;
+		bench_offsets(&dev[d], (int32_t)(i % 20000) - 10000);
+		if(!gy521_flash_save(&g_flash, &dev[d])){
+			lost++;
+			continue;
+		}
+		last[d] = dev[d].conf.gyro.offset.x;
+		if(bench_stored(GY521_I2C_ADDR_GND) != last[0] || (i >= 2 && bench_stored(GY521_I2C_ADDR_VCC) != last[1])) lost++;
+	}
+
+	// Same conf again: no program
+	const uint32_t programs = g_sim_flash.stat.programs;
+	for(uint8_t i = 0; i < 10; i++) gy521_flash_save(&g_flash, &dev[0]);
+	if(g_sim_flash.stat.programs != programs){
+		printf("unchanged saves programmed %u pages\n", g_sim_flash.stat.programs - programs);
+		bad++;
+	}
+
+	uint32_t lo = UINT32_MAX, hi = 0;
+	for(uint8_t s = 0; s < BENCH_SECTORS; s++){
+		if(g_sim_flash.erases[s] < lo) lo = g_sim_flash.erases[s];
+		if(g_sim_flash.erases[s] > hi) hi = g_sim_flash.erases[s];
+	}
+	const double per_erase = (double)saves / (hi ? hi : 1);
+	printf("wear: %u saves, %u sectors, erases per sector %u..%u, %u pages, %u misaligned\n",
+		saves, BENCH_SECTORS, lo, hi, g_sim_flash.stat.programs, g_sim_flash.stat.misaligned);
+	printf("wear: %.0f saves until %u erases, %.0f years at one save per %u s\n",
+		per_erase * BENCH_CYCLES, BENCH_CYCLES, per_erase * BENCH_CYCLES * BENCH_SAVE_S / (365.25 * 86400), BENCH_SAVE_S);
+
+	if(lost){
+		printf("%u saves failed or did not load back\n", lost);
+		bad++;
+	}
+	if(hi - lo > 1 || g_sim_flash.stat.misaligned){
+		printf("erases not spread over the sectors\n");
+		bad++;
+	}
+	return bad;
+}
+
+// ==================
+// === Power cuts ===
+// ==================
+// Cuts the power at every byte the next save of 0x68 erases / programs
+static uint32_t bench_cut(const char *name){
+	gy521_s dev = bench_device(GY521_I2C_ADDR_GND);
+	const int32_t old = bench_stored(GY521_I2C_ADDR_GND), other = bench_stored(GY521_I2C_ADDR_VCC);
+	bench_offsets(&dev, old + 1);
+
+	// Bytes the save touches
+	bench_snapshot();
+	gy521_flash_save(&g_flash, &dev);
+	const uint32_t bytes = (g_sim_flash.stat.erases - g_sim_flash_snap.stat.erases) * GY521_FLASH_SECTOR +
+		(g_sim_flash.stat.programs - g_sim_flash_snap.stat.programs) * GY521_FLASH_PAGE;
+	bench_rollback();
+
+	uint32_t bad = 0, as_old = 0;
+	for(uint32_t cut = 1; cut <= bytes; cut++){
+		g_sim_flash.fault.cut = cut;
+		gy521_flash_save(&g_flash, &dev);
+		g_sim_flash.fault.cut = 0;
+		g_sim_flash.fault.off = false; // Next boot
+
+		const int32_t now = bench_stored(GY521_I2C_ADDR_GND);
+		as_old += now == old;
+		bad += (now != old && now != old + 1) || bench_stored(GY521_I2C_ADDR_VCC) != other;
+		bench_rollback();
+	}
+	printf("power cut, %-14s %5u positions: %u old record, %u new, %u broken\n", name, bytes, as_old, bytes - as_old - bad, bad);
+	return bad != 0;
+}
+
+static uint32_t bench_cuts(void){
+	gy521_sim_flash_init(&g_sim_flash, &g_flash, g_mem, BENCH_SIZE);
+	bench_power_up();
+	gy521_s dev[2] = {bench_device(GY521_I2C_ADDR_GND), bench_device(GY521_I2C_ADDR_VCC)};
+	bench_offsets(&dev[1], 500);
+	gy521_flash_save(&g_flash, &dev[1]);
+	bench_offsets(&dev[0], 0);
+	gy521_flash_save(&g_flash, &dev[0]);
+
+	uint32_t bad = bench_cut("page only");
+
+	// On to the save that starts the next sector (erase + carried record)
+	for(int32_t v = 1;; v++){
+		bench_snapshot();
+		bench_offsets(&dev[0], v);
+		gy521_flash_save(&g_flash, &dev[0]);
+		if(g_sim_flash.stat.erases != g_sim_flash_snap.stat.erases){
+			bench_rollback();
+			break;
+		}
+	}
+	return bad + bench_cut("sector erase");
+}
+
+// ============
+// === Main ===
+// ============
+int main(int argc, char **argv){
+	uint32_t saves = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 3000;
+	if(saves < 200) saves = 200;
+
+	printf("gy521 flash storage, %u sectors of %u bytes, %u byte pages\n\n", BENCH_SECTORS, GY521_FLASH_SECTOR, GY521_FLASH_PAGE);
+	uint32_t bad = bench_boot();
+	bad += bench_reject();
+	bad += bench_wear(saves);
+	bad += bench_cuts();
+
+	if(bad){
+		printf("\nFAILED\n");
+		return 1;
+	}
+	printf("\nOK\n");
+	return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_fusion_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Replays motion through every fusion algorithm (float and
+ *  fixed-point) and reports per update:
+ *  - CPU time (ns) and cycles
+ *  - Synthetic motion: time until the tilt error stays below
+ *    2°, RMS / max tilt error afterwards (the filter starts at
+ *    identity, the sensor at roll 30° / pitch -20°)
+ *  - Recorded motion: final roll / pitch / yaw
+ *
+ *  Exit code 1 if a filter does not converge on the synthetic
+ *  motion.
+ *
+ *  Usage: gy521_fusion_bench [seconds]
+ *         gy521_fusion_bench -r <file> [gyro_fsr_dps]
+ *         file: one sample per line, raw values
+ *         "timestamp_us ax ay az gx gy gz" (separated by space or comma)
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gy521_fusion.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GY521_BENCH_CYCLES() __rdtsc()
+#else
+#define GY521_BENCH_CYCLES() 0ull
+#endif
+
+#define BENCH_RATE_HZ 1000
+#define BENCH_ACCEL_LSB 8192.0 // ±4 g
+#define BENCH_GYRO_LSB 65.5 // ±500 °/s
+#define BENCH_TILT_OK_DEG 2.0
+#define BENCH_MAX_SAMPLES 2000000
+
+typedef struct{
+	uint32_t dt_us;
+	gy521_sample_t s;
+	double q[4]; // True orientation (synthetic only)
+} bench_sample_t;
+
+static bench_sample_t *g_samples;
+static uint32_t g_count;
+static uint8_t g_gyro_fsr = GY521_GYRO_FSR_SEL_500DPS;
+static bool g_synthetic;
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Gaussian noise (Box-Muller)
+static double bench_noise(double sigma){
+	double u1 = (rand() + 1.0) / (RAND_MAX + 2.0), u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+	return sigma * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static int16_t bench_raw(double v){
+	v = round(v);
+	return v > 32767 ? 32767 : v < -32768 ? -32768 : (int16_t)v;
+}
+
+// Gravity direction in the body frame for body -> world quaternion q
+static void bench_gravity(const double *q, double *g){
+	g[0] = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+	g[1] = 2.0 * (q[0] * q[1] + q[2] * q[3]);
+	g[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+// ========================
+// === Synthetic Motion ===
+// ========================
+// Tilted start, then rotation about all three axes (up to ~90 °/s)
+static void bench_synthetic(double seconds){
+	g_count = (uint32_t)(seconds * BENCH_RATE_HZ);
+	g_samples = calloc(g_count, sizeof(*g_samples));
+	g_synthetic = true;
+	srand(521);
+
+	double r = 30.0 * M_PI / 180.0 / 2.0, p = -20.0 * M_PI / 180.0 / 2.0;
+	double q[4] = {cos(r) * cos(p), sin(r) * cos(p), cos(r) * sin(p), -sin(r) * sin(p)};
+	double dt = 1.0 / BENCH_RATE_HZ;
+
+	for(uint32_t i = 0; i < g_count; i++){
+		double t = i * dt;
+		double w[3] = { // rad/s
+			1.2 * sin(2.0 * M_PI * 0.31 * t),
+			0.9 * sin(2.0 * M_PI * 0.17 * t + 1.0),
+			1.5 * cos(2.0 * M_PI * 0.11 * t)
+		};
+
+		// Exact rotation over one sample
+		double n = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+		if(n > 0.0){
+			double h = n * dt / 2.0, k = sin(h) / n;
+			double d[4] = {cos(h), w[0] * k, w[1] * k, w[2] * k};
+			double o[4] = {
+				q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3],
+				q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2],
+				q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1],
+				q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0]
+			};
+			memcpy(q, o, sizeof(o));
+		}
+
+		double g[3];
+		bench_gravity(q, g);
+		bench_sample_t *b = &g_samples[i];
+		b->dt_us = 1000000 / BENCH_RATE_HZ;
+		memcpy(b->q, q, sizeof(q));
+		for(uint8_t a = 0; a < 3; a++){
+			(&b->s.accel.x)[a] = bench_raw((g[a] + bench_noise(0.01)) * BENCH_ACCEL_LSB);
+			(&b->s.gyro.x)[a] = bench_raw((w[a] * 180.0 / M_PI + bench_noise(0.05)) * BENCH_GYRO_LSB);
+		}
+	}
+}
+
+// =======================
+// === Recorded Motion ===
+// =======================
+static bool bench_load(const char *path){
+	FILE *file = fopen(path, "r");
+	if(!file) return false;
+
+	g_samples = calloc(BENCH_MAX_SAMPLES, sizeof(*g_samples));
+	char line[256];
+	unsigned long long last = 0;
+	while(g_count < BENCH_MAX_SAMPLES && fgets(line, sizeof(line), file)){
+		for(char *c = line; *c; c++) if(*c == ',') *c = ' ';
+
+		unsigned long long ts;
+		int v[6];
+		if(sscanf(line, "%llu %d %d %d %d %d %d", &ts, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 7) continue;
+
+		bench_sample_t *b = &g_samples[g_count++];
+		b->dt_us = g_count > 1 ? (uint32_t)(ts - last) : 1000000 / BENCH_RATE_HZ;
+		b->s.accel = (gy521_axis_raw_t){(int16_t)v[0], (int16_t)v[1], (int16_t)v[2]};
+		b->s.gyro = (gy521_axis_raw_t){(int16_t)v[3], (int16_t)v[4], (int16_t)v[5]};
+		last = ts;
+	}
+	fclose(file);
+	return g_count > 0;
+}
+
+// ==============
+// === Replay ===
+// ==============
+static bool bench_run(const char *name, uint8_t algo, bool fixed){
+	gy521_fusion_t f;
+	gy521_fusion_init(&f, algo, fixed);
+
+	uint64_t ns = 0, cycles = 0;
+	double settle = -1.0, sum2 = 0.0, worst = 0.0;
+	uint32_t after = 0;
+
+	for(uint32_t i = 0; i < g_count; i++){
+		bench_sample_t *b = &g_samples[i];
+		uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+		gy521_fusion_update_sample(&f, &b->s, g_gyro_fsr, b->dt_us);
+		cycles += GY521_BENCH_CYCLES() - c0;
+		ns += bench_ns() - t0;
+		if(!g_synthetic) continue;
+
+		double q[4];
+		if(fixed){
+			q[0] = (double)f.v.q_fixed.w / GY521_FUSION_ONE;
+			q[1] = (double)f.v.q_fixed.x / GY521_FUSION_ONE;
+			q[2] = (double)f.v.q_fixed.y / GY521_FUSION_ONE;
+			q[3] = (double)f.v.q_fixed.z / GY521_FUSION_ONE;
+		}else{
+			q[0] = f.v.q.w;
+			q[1] = f.v.q.x;
+			q[2] = f.v.q.y;
+			q[3] = f.v.q.z;
+		}
+
+		// Tilt error = angle between estimated and true gravity direction
+		double ge[3], gt[3];
+		bench_gravity(q, ge);
+		bench_gravity(b->q, gt);
+		double dot = (ge[0] * gt[0] + ge[1] * gt[1] + ge[2] * gt[2]) / sqrt(ge[0] * ge[0] + ge[1] * ge[1] + ge[2] * ge[2]);
+		double err = acos(dot > 1.0 ? 1.0 : dot < -1.0 ? -1.0 : dot) * 180.0 / M_PI;
+
+		if(err > BENCH_TILT_OK_DEG){
+			settle = -1.0;
+			sum2 = worst = 0.0;
+			after = 0;
+		}else{
+			if(settle < 0.0) settle = (double)i / BENCH_RATE_HZ;
+			sum2 += err * err;
+			if(err > worst) worst = err;
+			after++;
+		}
+	}
+
+	double n = g_count ? g_count : 1;
+	printf("%-22s %10.1f %10.0f", name, ns / n, cycles / n);
+	if(!g_synthetic){
+		if(fixed) printf(" %9.2f %9.2f %9.2f\n", f.v.mdeg.roll / 1000.0, f.v.mdeg.pitch / 1000.0, f.v.mdeg.yaw / 1000.0);
+		else printf(" %9.2f %9.2f %9.2f\n", f.v.deg.roll, f.v.deg.pitch, f.v.deg.yaw);
+		return true;
+	}
+
+	if(settle < 0.0){
+		printf(" %10s %10s %10s\n", "never", "-", "-");
+		return false;
+	}
+	printf(" %10.2f %10.3f %10.3f\n", settle, sqrt(sum2 / after), worst);
+	return true;
+}
+
+int main(int argc, char **argv){
+	if(argc > 2 && !strcmp(argv[1], "-r")){
+		if(argc > 3){
+			int dps = atoi(argv[3]);
+			g_gyro_fsr = dps >= 2000 ? GY521_GYRO_FSR_SEL_2000DPS : dps >= 1000 ? GY521_GYRO_FSR_SEL_1000DPS
+				: dps >= 500 ? GY521_GYRO_FSR_SEL_500DPS : GY521_GYRO_FSR_SEL_250DPS;
+		}
+		if(!bench_load(argv[2])){
+			fprintf(stderr, "cannot read samples from %s\n", argv[2]);
+			return 2;
+		}
+		printf("gy521 fusion replay, %u samples from %s\n\n", g_count, argv[2]);
+		printf("%-22s %10s %10s %9s %9s %9s\n", "filter", "ns/upd", "cyc/upd", "roll", "pitch", "yaw");
+	}else{
+		double seconds = argc > 1 ? atof(argv[1]) : 20.0;
+		bench_synthetic(seconds);
+		printf("gy521 fusion benchmark, %.0f s synthetic motion at %d Hz (start tilted 30°/-20°, filter at identity)\n\n",
+			seconds, BENCH_RATE_HZ);
+		printf("%-22s %10s %10s %10s %10s %10s\n", "filter", "ns/upd", "cyc/upd", "settle s", "rms °", "max °");
+	}
+
+	bool ok = true;
+	ok &= bench_run("madgwick float", GY521_FUSION_MADGWICK, false);
+	ok &= bench_run("madgwick fixed", GY521_FUSION_MADGWICK, true);
+	ok &= bench_run("mahony float", GY521_FUSION_MAHONY, false);
+	ok &= bench_run("mahony fixed", GY521_FUSION_MAHONY, true);
+	ok &= bench_run("complementary float", GY521_FUSION_COMPLEMENTARY, false);
+	ok &= bench_run("complementary fixed", GY521_FUSION_COMPLEMENTARY, true);
+
+	free(g_samples);
+	return ok ? 0 : 1;
+}
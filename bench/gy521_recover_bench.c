@@ -0,0 +1,207 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_recover_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Bus faults injected into the register simulator while a 1 kHz
+ *  loop calls fn.read(), in virtual time:
+ *  - SDA stuck + brownout (device back at power-up), cleared by
+ *    the first recovery
+ *  - SDA stuck through two recoveries, cleared by the third
+ *  - Two NACKs (below conf.recover.after, no recovery)
+ *  Reports failed reads, recoveries, time lost and the worst
+ *  fn.read() latency for the driver defaults, without recovery
+ *  and without a timeout.
+ *
+ *  With the defaults the run is checked: recovery counts, the
+ *  device configuration restored after the brownout, every read
+ *  after the last fault succeeding and the worst latency within
+ *  timeout_us + 2 ms. Exit code 1 on a failed check.
+ *  Also checked: fn.reset() waits out the reset (the simulator
+ *  NACKs meanwhile) without failed transfers or a recovery, and
+ *  drops a calibration, so a later recovery does not write the
+ *  old offsets back.
+ *
+ *  Usage: gy521_recover_bench [loops]
+ *
+ * ================================================================
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "gy521.h"
+#include "gy521_host.h"
+#include "gy521_sim.h"
+#include "gy521_regs.h"
+
+#define BENCH_PERIOD_US 1000 // Control loop period
+
+static gy521_sim_bus_t g_sim_bus;
+static gy521_bus_t g_bus;
+static gy521_sim_t g_sim;
+static gy521_s g_dev;
+
+typedef struct{
+	const char *name;
+	uint32_t reads, failed; // fn.read() calls, calls that returned false
+	uint32_t recoveries, recover_failed;
+	uint64_t lost_us, worst_us; // Summed outage time, slowest fn.read()
+	uint32_t failed_after; // Failed reads after the last fault cleared
+	uint32_t bad_config; // Registers not matching conf at the end
+} bench_result_t;
+
+static void bench_print(const bench_result_t *r){
+	printf("%-14s %8u %8u %6u %6u %10.2f %12.1f\n", r->name, r->reads, r->failed, r->recoveries, r->recover_failed,
+		r->lost_us / 1000.0, r->worst_us / 1000.0);
+}
+
+// Registers the brownout wiped, compared against conf
+static uint32_t bench_config(void){
+	const uint8_t *reg = g_sim.reg;
+	uint32_t bad = 0;
+	bad += (reg[GY521_REG_ACCEL_CONFIG] & 0x18) != GY521_ACCEL_FSR_SEL_8G;
+	bad += reg[GY521_REG_GYRO_CONFIG] != GY521_GYRO_FSR_SEL_2000DPS;
+	bad += reg[GY521_REG_SMPLRT_DIV] != g_dev.conf.rate.div;
+	bad += (reg[GY521_REG_CONFIG] & 0x07) != g_dev.conf.rate.dlpf;
+	bad += (reg[GY521_REG_PWR_MGMT_1] & GY521_SLEEP) != 0;
+	bad += (reg[GY521_REG_PWR_MGMT_1] & 0x07) != GY521_CLKSEL_GYRO_X;
+	bad += (int16_t)((reg[GY521_REG_XG_OFFS_USRH] << 8) | reg[GY521_REG_XG_OFFS_USRH + 1]) != g_dev.conf.gyro.offset.x;
+	return bad;
+}
+
+// timeout_us / recover_after as the driver would be configured
+static bench_result_t bench_run(const char *name, uint32_t timeout_us, uint8_t recover_after, uint32_t loops){
+	bench_result_t r = {.name = name};
+
+	gy521_sim_bus_init(&g_sim_bus, &g_bus);
+	gy521_sim_init(&g_sim, GY521_I2C_ADDR_GND);
+	gy521_sim_attach(&g_sim_bus, &g_sim);
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &g_sim_bus);
+	g_bus.timeout_us = timeout_us;
+
+	g_dev = gy521_init(&g_bus, GY521_I2C_ADDR_GND);
+	g_dev.conf.recover.after = recover_after;
+	g_dev.conf.sleep = false;
+	g_dev.conf.accel.fsr = GY521_ACCEL_FSR_SEL_8G;
+	g_dev.conf.gyro.fsr = GY521_GYRO_FSR_SEL_2000DPS;
+	g_dev.conf.rate.dlpf = GY521_DLPF_184HZ;
+	g_dev.conf.rate.div = 0; // 1 kHz
+	g_dev.conf.gyro.offset.x = -42;
+	if(!g_dev.fn.commit(&g_dev) || !g_dev.fn.offsets.set(&g_dev)){
+		r.bad_config++;
+		return r;
+	}
+
+	const uint32_t fault_at[3] = {loops / 5, loops / 2, 4 * loops / 5};
+	uint32_t clear_at = loops;
+	for(uint32_t i = 0; i < loops; i++){
+		if(i == fault_at[0]){
+			g_sim_bus.fault.stuck = 1;
+			gy521_sim_brownout(&g_sim);
+		}else if(i == fault_at[1]){
+			g_sim_bus.fault.stuck = 3;
+		}else if(i == fault_at[2]){
+			g_sim_bus.fault.nack = 2;
+			clear_at = i + 2;
+		}
+
+		uint64_t t0 = gy521_sim_now(&g_sim_bus);
+		bool ok = g_dev.fn.read(&g_dev, GY521_ALL);
+		uint64_t dt = gy521_sim_now(&g_sim_bus) - t0;
+		if(dt > r.worst_us) r.worst_us = dt;
+
+		r.reads++;
+		if(!ok){
+			r.failed++;
+			if(i >= clear_at) r.failed_after++;
+		}
+		gy521_sim_advance(&g_sim_bus, BENCH_PERIOD_US);
+	}
+
+	r.recoveries = g_dev.v.recover.events;
+	r.recover_failed = g_dev.v.recover.failed;
+	r.lost_us = g_dev.v.recover.lost_us;
+	r.bad_config = bench_config();
+	return r;
+}
+
+// Calibrated offsets, fn.reset(), then a brownout + recovery: the chip keeps its power-on offsets
+static uint32_t bench_reset(void){
+	gy521_sim_bus_init(&g_sim_bus, &g_bus);
+	gy521_sim_init(&g_sim, GY521_I2C_ADDR_GND);
+	gy521_sim_attach(&g_sim_bus, &g_sim);
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &g_sim_bus);
+
+	g_dev = gy521_init(&g_bus, GY521_I2C_ADDR_GND);
+	g_dev.conf.sleep = false;
+	g_dev.conf.accel.offset.x = 200;
+	g_dev.conf.gyro.offset.x = -42;
+	if(!g_dev.fn.commit(&g_dev) || !g_dev.fn.offsets.set(&g_dev) || !g_dev.fn.reset(&g_dev)) return 1;
+
+	uint32_t bad = 0;
+	bad += g_dev.conf.accel.offset.x != 0 || g_dev.conf.gyro.offset.x != 0; // Sim factory trim is 0
+
+	g_dev.conf.sleep = false;
+	if(!g_dev.fn.commit(&g_dev)) return bad + 1;
+	bad += g_dev.priv.failures != 0 || g_dev.v.recover.events != 0; // Reset not mistaken for a bus fault
+	gy521_sim_brownout(&g_sim);
+	g_sim_bus.fault.stuck = 1;
+	for(uint32_t i = 0; i < 10; i++){
+		g_dev.fn.read(&g_dev, GY521_ALL);
+		gy521_sim_advance(&g_sim_bus, BENCH_PERIOD_US);
+	}
+
+	const uint8_t *reg = g_sim.reg;
+	bad += !g_dev.v.recover.events;
+	bad += reg[GY521_REG_XA_OFFS_H] || reg[GY521_REG_XA_OFFS_H + 1];
+	bad += reg[GY521_REG_XG_OFFS_USRH] || reg[GY521_REG_XG_OFFS_USRH + 1];
+	return bad;
+}
+
+int main(int argc, char **argv){
+	uint32_t loops = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 10000;
+	if(loops < 20) loops = 20;
+
+	printf("gy521 bus recovery, %u reads at 1 kHz, faults: stuck+brownout, stuck x3, 2 NACKs\n\n", loops);
+	printf("%-14s %8s %8s %6s %6s %10s %12s\n", "variant", "reads", "failed", "recov", "r.fail", "lost ms", "worst ms");
+
+	const bench_result_t def = bench_run("default", GY521_BUS_TIMEOUT_US, GY521_RECOVER_AFTER, loops);
+	bench_print(&def);
+	bench_result_t r = bench_run("no recovery", GY521_BUS_TIMEOUT_US, 0, loops);
+	bench_print(&r);
+	r = bench_run("no timeout", 0, GY521_RECOVER_AFTER, loops);
+	bench_print(&r);
+
+	// Stuck+brownout: 1 recovery; stuck x3: 2 failed + 1 good; NACKs: none
+	const uint32_t bound_us = GY521_BUS_TIMEOUT_US + 2000;
+	uint32_t bad = 0;
+	if(def.recoveries != 4 || def.recover_failed != 2){
+		printf("recoveries %u / failed %u, expected 4 / 2\n", def.recoveries, def.recover_failed);
+		bad++;
+	}
+	if(def.bad_config){
+		printf("%u registers not restored\n", def.bad_config);
+		bad++;
+	}
+	if(def.failed_after){
+		printf("%u failed reads after the last fault\n", def.failed_after);
+		bad++;
+	}
+	if(def.worst_us > bound_us){
+		printf("worst read %llu us > %u us\n", (unsigned long long)def.worst_us, bound_us);
+		bad++;
+	}
+	const uint32_t reset_bad = bench_reset();
+	if(reset_bad){
+		printf("%u fn.reset() checks failed (transfer errors or stale offsets after a recovery)\n", reset_bad);
+		bad++;
+	}
+	printf("\nrecovery checks (worst read <= %u us): %s\n", bound_us, bad ? "FAILED" : "ok");
+
+	return bad ? 1 : 0;
+}
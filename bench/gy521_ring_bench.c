@@ -0,0 +1,160 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_ring_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Stress test of the SPSC ring (gy521_ring.h) with two pthreads,
+ *  standing in for core 1 (producer) and core 0 (consumer):
+ *  - The producer pushes frames with a monotonic seq, the payload
+ *    derived from it; a full ring drops the frame (overrun)
+ *  - The consumer drains in batches of 1..64 frames and pauses
+ *    now and then, so the ring runs full as well as empty
+ *  - Checked: seq strictly increasing (no reordering, no
+ *    duplicates), the gaps add up to the overruns, every payload
+ *    intact, pushed == popped + overruns, high_water within
+ *    GY521_RING_SIZE
+ *
+ *  Exit code 1 on any mismatch.
+ *
+ *  Usage: gy521_ring_bench [frames]
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gy521_ring.h"
+
+static gy521_ring_t g_ring;
+static uint32_t g_frames = 10000000;
+static _Atomic bool g_done;
+
+typedef struct{
+	uint32_t popped, batches;
+	uint32_t last; // seq of the last frame popped
+	uint32_t reordered; // seq not above the previous one
+	uint32_t gaps; // Frames missing between consecutive seq
+	uint32_t torn; // Payload does not belong to its seq
+} bench_consumer_t;
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Payload from seq: a torn copy shows up as a mismatch
+static void bench_fill(gy521_frame_t *f, uint32_t seq){
+	f->seq = seq;
+	f->timestamp_us = (uint64_t)seq * 1000u;
+	f->sample.accel = (gy521_axis_raw_t){(int16_t)seq, (int16_t)(seq >> 16), (int16_t)~seq};
+	f->sample.temp = (int16_t)(seq * 7u);
+	f->sample.gyro = (gy521_axis_raw_t){(int16_t)(seq ^ 0x5a5a), (int16_t)(seq >> 3), (int16_t)(seq * 3u)};
+}
+
+static bool bench_intact(const gy521_frame_t *f){
+	gy521_frame_t want;
+	bench_fill(&want, f->seq);
+	return f->timestamp_us == want.timestamp_us && f->sample.accel.x == want.sample.accel.x &&
+		f->sample.accel.y == want.sample.accel.y && f->sample.accel.z == want.sample.accel.z &&
+		f->sample.temp == want.sample.temp && f->sample.gyro.x == want.sample.gyro.x &&
+		f->sample.gyro.y == want.sample.gyro.y && f->sample.gyro.z == want.sample.gyro.z;
+}
+
+// ================
+// === Producer ===
+// ================
+static void *bench_producer(void *arg){
+	uint32_t *pushed = arg;
+	gy521_frame_t f;
+	for(uint32_t seq = 1; seq <= g_frames; seq++){
+		bench_fill(&f, seq);
+		const bool ok = gy521_ring_push(&g_ring, &f);
+		(*pushed)++;
+
+		// Full: mostly hand the CPU over (one core hosts), some frames still overrun
+		if(!ok && (seq & 7) == 0) sched_yield();
+	}
+	atomic_store(&g_done, true);
+	return NULL;
+}
+
+// ================
+// === Consumer ===
+// ================
+static void bench_check(bench_consumer_t *c, const gy521_frame_t *buf, uint16_t n, uint32_t *last){
+	for(uint16_t i = 0; i < n; i++){
+		if(buf[i].seq <= *last) c->reordered++;
+		else c->gaps += buf[i].seq - *last - 1;
+		if(!bench_intact(&buf[i])) c->torn++;
+		*last = buf[i].seq;
+	}
+	c->popped += n;
+	if(n) c->batches++;
+}
+
+static void *bench_consumer(void *arg){
+	bench_consumer_t *c = arg;
+	gy521_frame_t buf[64];
+	uint32_t round = 0, pause = 0;
+
+	while(!atomic_load(&g_done)){
+		const uint16_t max = 1 + (round++ * 37u) % 64;
+		const uint16_t n = gy521_ring_pop(&g_ring, buf, max);
+		bench_check(c, buf, n, &c->last);
+		if(!n) sched_yield(); // Empty: let the producer run (one core hosts)
+
+		if(c->popped >> 18 != pause){
+			pause = c->popped >> 18;
+			struct timespec ts = {0, 100000}; // Ring runs full meanwhile
+			nanosleep(&ts, NULL);
+		}
+	}
+
+	// Producer finished: drain the rest
+	uint16_t n;
+	while((n = gy521_ring_pop(&g_ring, buf, 64))) bench_check(c, buf, n, &c->last);
+	return NULL;
+}
+
+// ============
+// === Main ===
+// ============
+int main(int argc, char **argv){
+	if(argc > 1) g_frames = (uint32_t)strtoul(argv[1], NULL, 10);
+	if(g_frames < 1000) g_frames = 1000;
+
+	gy521_ring_init(&g_ring);
+	uint32_t pushed = 0;
+	bench_consumer_t c = {0};
+	pthread_t prod, cons;
+
+	const uint64_t t0 = bench_ns();
+	if(pthread_create(&cons, NULL, &bench_consumer, &c) || pthread_create(&prod, NULL, &bench_producer, &pushed)){
+		printf("pthread_create failed\n");
+		return 1;
+	}
+	pthread_join(prod, NULL);
+	pthread_join(cons, NULL);
+	const uint64_t ns = bench_ns() - t0;
+
+	const uint32_t overruns = atomic_load(&g_ring.overruns), high_water = atomic_load(&g_ring.high_water);
+	printf("gy521 ring, %u frames, %u slots, 2 threads: %.1f ns per frame\n", g_frames, GY521_RING_SIZE, (double)ns / g_frames);
+	printf("pushed %u, popped %u in %u batches, overruns %u, high water %u\n", pushed, c.popped, c.batches, overruns, high_water);
+	printf("reordered / duplicated %u, missing %u (+%u at the end), torn %u\n", c.reordered, c.gaps, g_frames - c.last, c.torn);
+
+	// Frames dropped after the last one popped leave no gap
+	bool ok = pushed == g_frames && pushed == c.popped + overruns && c.gaps + (g_frames - c.last) == overruns &&
+		!c.reordered && !c.torn && high_water <= GY521_RING_SIZE && gy521_ring_count(&g_ring) == 0;
+	printf("\n%s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
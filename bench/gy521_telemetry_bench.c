@@ -0,0 +1,185 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_telemetry_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Binary telemetry vs. the printf text line of main.c:
+ *  - Bytes per sample and samples/s that fit a 1 MB/s USB link
+ *  - CPU time (ns) and cycles per encoded / decoded frame
+ *  Then a round trip through a damaged stream (dropped frames,
+ *  flipped bits, text in between, 16 bit seq wrap): every intact
+ *  frame must come back unchanged, every loss must be counted.
+ *
+ *  Exit code 1 if the round trip does not match.
+ *
+ *  Usage: gy521_telemetry_bench [frames]
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gy521_telemetry.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GY521_BENCH_CYCLES() __rdtsc()
+#else
+#define GY521_BENCH_CYCLES() 0ull
+#endif
+
+#define BENCH_LINK_BPS 1000000.0 // USB full speed CDC, roughly
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static gy521_frame_t bench_frame(uint32_t i){
+	gy521_frame_t f = {.seq = i + 60000, .timestamp_us = 4294000000ull + i * 125ull}; // Both wrap during the run
+	int16_t *v = &f.sample.accel.x;
+	for(uint8_t k = 0; k < 3; k++) v[k] = (int16_t)(rand() - RAND_MAX / 2);
+	f.sample.temp = (int16_t)rand();
+	v = &f.sample.gyro.x;
+	for(uint8_t k = 0; k < 3; k++) v[k] = (int16_t)(rand() - RAND_MAX / 2);
+	return f;
+}
+
+static bool bench_same(const gy521_frame_t *a, const gy521_frame_t *b){
+	return a->seq == b->seq && a->timestamp_us == b->timestamp_us && !memcmp(&a->sample, &b->sample, sizeof(a->sample));
+}
+
+// =========================
+// === Size + Throughput ===
+// =========================
+static void bench_speed(uint32_t frames){
+	gy521_frame_t f = bench_frame(0);
+	uint8_t frame[GY521_TELEMETRY_FRAME_SIZE];
+	char line[160];
+	volatile uint32_t sink = 0;
+
+	uint64_t t0 = bench_ns(), c0 = GY521_BENCH_CYCLES();
+	for(uint32_t i = 0; i < frames; i++){
+		f.seq = i;
+		sink += gy521_telemetry_encode(frame, &f);
+	}
+	double enc_cyc = (double)(GY521_BENCH_CYCLES() - c0) / frames, enc_ns = (double)(bench_ns() - t0) / frames;
+
+	gy521_telemetry_decoder_t d;
+	gy521_telemetry_decoder_init(&d);
+	gy521_frame_t out;
+	t0 = bench_ns();
+	c0 = GY521_BENCH_CYCLES();
+	for(uint32_t i = 0; i < frames; i++){
+		f.seq = i;
+		gy521_telemetry_encode(frame, &f);
+		for(uint8_t k = 0; k < GY521_TELEMETRY_FRAME_SIZE; k++) sink += gy521_telemetry_decode(&d, frame[k], &out);
+	}
+	double dec_cyc = (double)(GY521_BENCH_CYCLES() - c0) / frames - enc_cyc, dec_ns = (double)(bench_ns() - t0) / frames - enc_ns;
+
+	// Text line as printed by main.c
+	int text = 0;
+	t0 = bench_ns();
+	c0 = GY521_BENCH_CYCLES();
+	for(uint32_t i = 0; i < frames; i++){
+		text = snprintf(line, sizeof(line), "#%lu %llu us | G=X:%6.3f Y:%6.3f Z:%6.3f | °C=%6.2f | °/s=X:%9.3f Y:%9.3f Z:%9.3f\n",
+			(unsigned long)i, (unsigned long long)f.timestamp_us, f.sample.accel.x / 4096.0f, f.sample.accel.y / 4096.0f,
+			f.sample.accel.z / 4096.0f, f.sample.temp / 340.0f + 36.53f, f.sample.gyro.x / 16.4f, f.sample.gyro.y / 16.4f,
+			f.sample.gyro.z / 16.4f);
+		sink += text;
+	}
+	double txt_cyc = (double)(GY521_BENCH_CYCLES() - c0) / frames, txt_ns = (double)(bench_ns() - t0) / frames;
+	(void)sink;
+
+	printf("%-18s %8s %12s %10s %10s\n", "format", "B/smp", "smp/s @1MB/s", "ns/smp", "cyc/smp");
+	printf("%-18s %8d %12.0f %10.1f %10.0f\n", "printf text", text, BENCH_LINK_BPS / text, txt_ns, txt_cyc);
+	printf("%-18s %8d %12.0f %10.1f %10.0f\n", "binary encode", GY521_TELEMETRY_FRAME_SIZE,
+		BENCH_LINK_BPS / GY521_TELEMETRY_FRAME_SIZE, enc_ns, enc_cyc);
+	printf("%-18s %8d %12s %10.1f %10.0f\n", "binary decode", GY521_TELEMETRY_FRAME_SIZE, "-", dec_ns, dec_cyc);
+}
+
+// ==================================
+// === Round Trip, damaged stream ===
+// ==================================
+static bool bench_roundtrip(uint32_t frames){
+	gy521_frame_t *sent = malloc(frames * sizeof(*sent));
+	bool *intact = calloc(frames, sizeof(*intact));
+	uint8_t *stream = malloc((size_t)frames * (GY521_TELEMETRY_FRAME_SIZE + 32));
+	size_t len = 0;
+	uint32_t dropped = 0, damaged = 0;
+	static const char text[] = "GY-521 ready!\n";
+
+	for(uint32_t i = 0; i < frames; i++){
+		sent[i] = bench_frame(i);
+		if(i % 97 == 13){ // Lost on the link
+			dropped++;
+			continue;
+		}
+		if(i % 211 == 5){ // Text in between
+			memcpy(&stream[len], text, sizeof(text) - 1);
+			len += sizeof(text) - 1;
+		}
+		uint8_t *f = &stream[len];
+		len += gy521_telemetry_encode(f, &sent[i]);
+		if(i % 89 == 7){ // One flipped bit
+			f[2 + rand() % 22] ^= 1u << (rand() % 8);
+			damaged++;
+			continue;
+		}
+		intact[i] = true;
+	}
+
+	gy521_telemetry_decoder_t d;
+	gy521_telemetry_decoder_init(&d);
+	gy521_frame_t out;
+	uint32_t next = 0, bad = 0, lost = 0;
+
+	for(size_t i = 0; i < len; i++){
+		if(!gy521_telemetry_decode(&d, stream[i], &out)) continue;
+
+		uint32_t skip = 0;
+		while(next < frames && !intact[next]){
+			next++;
+			skip++;
+		}
+		if(next >= frames || !bench_same(&out, &sent[next]) || d.gap != skip) bad++;
+		lost += skip;
+		next++;
+	}
+	while(next < frames && !intact[next]){
+		next++;
+		lost++;
+	}
+
+	uint32_t good = frames - dropped - damaged;
+	bool ok = !bad && d.stat.frames == good && d.stat.lost == lost && lost == dropped + damaged && next == frames;
+	printf("\nround trip %u frames: %u decoded (expected %u), %u lost (dropped %u + damaged %u), %u CRC errors, %u bytes skipped, %u mismatches: %s\n",
+		frames, d.stat.frames, good, d.stat.lost, dropped, damaged, d.stat.crc_errors, d.stat.skipped, bad, ok ? "ok" : "FAILED");
+
+	free(sent);
+	free(intact);
+	free(stream);
+	return ok;
+}
+
+int main(int argc, char **argv){
+	uint32_t frames = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000;
+	srand(521);
+
+	bool ok = gy521_telemetry_crc16((const uint8_t *)"123456789", 9) == 0x29b1;
+	printf("gy521 telemetry benchmark, %u frames, CRC check value %s\n\n", frames, ok ? "ok" : "FAILED");
+
+	bench_speed(frames);
+	ok &= bench_roundtrip(frames);
+
+	return ok ? 0 : 1;
+}
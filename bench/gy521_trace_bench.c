@@ -0,0 +1,215 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_trace_bench.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Records a 1 kHz session against the register simulator
+ *  (commit ±8 g / ±2000 °/s, fn.read() with conf.fixed) through
+ *  gy521_trace_rec_t, then replays the trace as fast as possible
+ *  through the unmodified driver. FSR comes from the trace
+ *  (gy521_trace_regs()), not from the bench.
+ *  Reports trace bytes per sample, recording overhead and replay
+ *  time per sample. Every replayed sample (raw, mg / m°C / m°/s,
+ *  seq, timestamp) must equal the recorded one.
+ *  Halfway through the session the simulator NACKs one read: the
+ *  trace must hold it as a failed record (GY521_BUS_ERROR) and the
+ *  replayed read must fail at the same sample.
+ *
+ *  Exit code 1 on a mismatch.
+ *
+ *  Usage: gy521_trace_bench [samples] [trace file to write]
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gy521.h"
+#include "gy521_host.h"
+#include "gy521_sim.h"
+#include "gy521_trace.h"
+#include "gy521_regs.h"
+
+#define BENCH_PERIOD_US 1000 // Control loop period
+
+static gy521_sim_bus_t g_sim_bus;
+static gy521_bus_t g_bus;
+static gy521_sim_t g_sim;
+static gy521_trace_rec_t g_rec;
+static gy521_trace_play_t g_play;
+
+// Trace in RAM (sink)
+static uint8_t *g_trace;
+static size_t g_size, g_cap;
+
+// One driver output
+typedef struct{
+	int16_t raw[7];
+	int32_t fixed[7];
+	uint32_t seq;
+	uint64_t timestamp_us;
+	bool failed; // fn.read() returned false
+} bench_out_t;
+
+static uint64_t bench_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void bench_sink(void *user, const uint8_t *data, size_t len){
+	(void)user;
+	if(g_size + len > g_cap){
+		g_cap = (g_size + len) * 2;
+		g_trace = realloc(g_trace, g_cap);
+		if(!g_trace) exit(1);
+	}
+	memcpy(&g_trace[g_size], data, len);
+	g_size += len;
+}
+
+static bench_out_t bench_out(const gy521_s *dev){
+	const bench_out_t o = {
+		.raw = {dev->v.accel.raw.x, dev->v.accel.raw.y, dev->v.accel.raw.z, dev->v.temp.raw,
+			dev->v.gyro.raw.x, dev->v.gyro.raw.y, dev->v.gyro.raw.z},
+		.fixed = {dev->v.accel.mg.x, dev->v.accel.mg.y, dev->v.accel.mg.z, dev->v.temp.mcelsius,
+			dev->v.gyro.mdps.x, dev->v.gyro.mdps.y, dev->v.gyro.mdps.z},
+		.seq = dev->v.seq,
+		.timestamp_us = dev->v.timestamp_us,
+	};
+	return o;
+}
+
+static bool bench_same(const bench_out_t *a, const bench_out_t *b){
+	return !memcmp(a->raw, b->raw, sizeof(a->raw)) && !memcmp(a->fixed, b->fixed, sizeof(a->fixed)) &&
+		a->seq == b->seq && a->timestamp_us == b->timestamp_us && a->failed == b->failed;
+}
+
+static void bench_sim(void){
+	gy521_sim_bus_init(&g_sim_bus, &g_bus);
+	gy521_sim_init(&g_sim, GY521_I2C_ADDR_GND);
+	gy521_sim_attach(&g_sim_bus, &g_sim);
+	g_sim_bus.baud = 0; // CPU only
+	gy521_host_clock(&gy521_sim_now, &gy521_sim_sleep, &g_sim_bus);
+}
+
+// ==============
+// === Record ===
+// ==============
+// traced = false: the same session straight on the simulator, ns per sample
+static uint64_t bench_record(bench_out_t *out, uint32_t samples, bool traced){
+	bench_sim();
+	if(traced) gy521_trace_record(&g_rec, &g_bus, &bench_sink, NULL);
+
+	gy521_s dev = gy521_init(traced ? &g_rec.bus : &g_bus, GY521_I2C_ADDR_GND);
+	dev.conf.sleep = false;
+	dev.conf.accel.fsr = GY521_ACCEL_FSR_SEL_8G;
+	dev.conf.gyro.fsr = GY521_GYRO_FSR_SEL_2000DPS;
+	dev.conf.rate.div = 0; // 1 kHz
+	dev.conf.fixed = true;
+	if(!dev.fn.commit(&dev)) return 0;
+
+	uint64_t ns = 0;
+	for(uint32_t i = 0; i < samples; i++){
+		if(i == samples / 2) g_sim_bus.fault.nack = 1; // Recorded as a failed transfer
+
+		uint64_t t0 = bench_ns();
+		bool ok = dev.fn.read(&dev, GY521_ALL);
+		ns += bench_ns() - t0;
+		if(out) out[i] = ok ? bench_out(&dev) : (bench_out_t){.failed = true};
+		gy521_sim_advance(&g_sim_bus, BENCH_PERIOD_US);
+	}
+	return ns / samples;
+}
+
+// ==============
+// === Replay ===
+// ==============
+// Samples identical to 'ref', -1 on a trace the driver could not start on
+static int64_t bench_replay(const bench_out_t *ref, uint32_t samples, uint64_t *ns){
+	if(!gy521_trace_replay(&g_play, g_trace, g_size)) return -1;
+	gy521_host_clock(&gy521_trace_now, &gy521_trace_sleep, &g_play);
+
+	uint8_t regs[128] = {0};
+	gy521_trace_regs(g_trace, g_size, GY521_I2C_ADDR_GND, GY521_REG_ACCEL_XOUT_H, regs);
+
+	gy521_s dev = gy521_init(&g_play.bus, GY521_I2C_ADDR_GND);
+	dev.conf.sleep = false;
+	dev.conf.accel.fsr = regs[GY521_REG_ACCEL_CONFIG] & 0x18;
+	dev.conf.gyro.fsr = regs[GY521_REG_GYRO_CONFIG] & 0x18;
+	dev.conf.rate.div = regs[GY521_REG_SMPLRT_DIV];
+	dev.conf.fixed = true;
+	if(!dev.fn.commit(&dev)) return -1;
+
+	uint32_t n = 0, same = 0;
+	uint64_t t0 = bench_ns();
+	while(!gy521_trace_done(&g_play) && n < samples){
+		bench_out_t o = dev.fn.read(&dev, GY521_ALL) ? bench_out(&dev) : (bench_out_t){.failed = true};
+		if(bench_same(&o, &ref[n])) same++;
+		n++;
+	}
+	*ns = bench_ns() - t0;
+	return same;
+}
+
+// Failed records in the trace, each must carry GY521_BUS_ERROR (zigzag round trip)
+static uint32_t bench_failed(uint32_t *bad){
+	gy521_trace_record_t r;
+	size_t pos = GY521_TRACE_HEADER_SIZE;
+	uint64_t t = 0;
+	uint32_t failed = 0;
+	while(gy521_trace_next(g_trace, g_size, &pos, &t, &r)){
+		if(!(r.flags & GY521_TRACE_FAILED)) continue;
+		failed++;
+		if(r.ret != GY521_BUS_ERROR || r.data) (*bad)++;
+	}
+	return failed;
+}
+
+int main(int argc, char **argv){
+	uint32_t samples = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 100000;
+	if(!samples) samples = 1;
+	bench_out_t *ref = calloc(samples, sizeof(*ref));
+	if(!ref) return 1;
+
+	printf("gy521 record / replay, %u samples at 1 kHz, ±8 g / ±2000 °/s\n\n", samples);
+
+	const uint64_t plain_ns = bench_record(NULL, samples, false);
+	const uint64_t rec_ns = bench_record(ref, samples, true);
+	printf("trace            %10zu bytes, %u records, %.1f bytes/sample\n", g_size, g_rec.stat.records,
+		(double)g_size / samples);
+	printf("fn.read()        %10llu ns/sample, recording %llu ns/sample\n", (unsigned long long)plain_ns,
+		(unsigned long long)rec_ns);
+
+	if(argc > 2){
+		FILE *f = fopen(argv[2], "wb");
+		if(!f || fwrite(g_trace, 1, g_size, f) != g_size) return 1;
+		fclose(f);
+	}
+
+	uint32_t failed_bad = 0;
+	const uint32_t failed = bench_failed(&failed_bad);
+	printf("failed records   %10u, %u not GY521_BUS_ERROR\n", failed, failed_bad);
+
+	uint64_t ns = 0;
+	const int64_t same = bench_replay(ref, samples, &ns);
+	printf("replay           %10.1f ns/sample, %.0f samples/s (%.0fx real time)\n", (double)ns / samples,
+		ns ? samples * 1e9 / ns : 0.0, ns ? samples * (BENCH_PERIOD_US * 1000.0) / ns : 0.0);
+	printf("replay stats     reads %u, writes %u, skipped %u, mismatches %u, misses %u\n", g_play.stat.reads,
+		g_play.stat.writes, g_play.stat.skipped, g_play.stat.mismatches, g_play.stat.misses);
+
+	const bool ok = same == (int64_t)samples && !g_play.stat.misses && failed == 1 && !failed_bad;
+	printf("\nreplay: %lld of %u samples identical: %s\n", (long long)same, samples, ok ? "ok" : "FAILED");
+
+	free(ref);
+	free(g_trace);
+	return ok ? 0 : 1;
+}
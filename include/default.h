@@ -8,4 +8,20 @@
 #define USE_UART 0      // 1 = UART aktivieren, nur wenn USE_USB=0
 #endif
 
+#ifndef USE_TELEMETRY
+#define USE_TELEMETRY 1 // 1 = binäre Frames (tools/gy521_decode), 0 = printf-Text
+#endif
+
+#ifndef USE_DELTA
+#define USE_DELTA 0     // 1 = nur Änderungen über der Deadband senden (tools/gy521_decode -d), mit USE_TELEMETRY
+#endif
+
+#ifndef USE_BIAS
+#define USE_BIAS 1      // 1 = Gyro-Bias im Betrieb nachführen (Temperaturdrift), 0 = nur Kalibrierung beim Start
+#endif
+
+#ifndef USE_FLASH
+#define USE_FLASH 1     // 1 = Kalibrierung + Konfiguration im Flash sichern, Start ohne erneute Kalibrierung
+#endif
+
 void stdio_init_board(void);
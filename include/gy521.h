@@ -38,15 +38,31 @@
  * ================================================================
  */
 #pragma once
-#include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include "gy521_types.h"
+#include "gy521_bus.h"
+#include "gy521_instrument.h"
+
+// GY521_HOST = 1 builds the driver without the pico-sdk (simulator, tools)
+#ifndef GY521_HOST
+#define GY521_HOST 0
+#endif
+
+#if !GY521_HOST
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 // =============================
 // === Configurable Hardware ===
 // =============================
-#ifndef GY521_I2C_PORT
+#if !GY521_HOST && !defined(GY521_I2C_PORT)
 #define GY521_I2C_PORT i2c1 // Default I2C port
 #endif
 
@@ -58,6 +74,10 @@
 #define GY521_SCL_PIN 7   // Default SCL pin (can be overridden)
 #endif
 
+#ifndef GY521_I2C_BAUD
+#define GY521_I2C_BAUD GY521_BAUD_FAST // Bus clock of gy521_bus_init() in Hz
+#endif
+
 #ifndef GY521_USE_PULLUP
 #define GY521_USE_PULLUP 1 // 1 = enable internal pull-up, 0 = disabled
 #endif
@@ -70,6 +90,29 @@
 #define GY521_MAX_DEVICES 2
 #endif
 
+#ifndef GY521_FIFO_BURST_FRAMES
+#define GY521_FIFO_BURST_FRAMES 16 // Max. FIFO frames fetched per I2C transfer
+#endif
+
+#ifndef GY521_RESET_MS
+#define GY521_RESET_MS 100 // Device reset: NACKs until its registers are back at power-on
+#endif
+
+#ifndef GY521_CALIBRATE_SETTLE
+#define GY521_CALIBRATE_SETTLE 16 // FIFO frames dropped after switching to the calibration rate
+#endif
+
+#ifndef GY521_SPAN_GAP_MAX
+#define GY521_SPAN_GAP_MAX 4 // fn.read_mask(): unused bytes read through rather than a second transfer
+#endif
+
+#ifndef GY521_RECOVER_AFTER
+#define GY521_RECOVER_AFTER 3 // Failed transfers in a row before bus recovery (conf.recover.after)
+#endif
+
+#define GY521_AUX_BYTES 24 // EXT_SENS_DATA registers: external sensor bytes per read
+#define GY521_AUX_SLAVES 4 // I2C_SLV0..3 (SLV4 is used by fn.aux.read() / fn.aux.write())
+
 #define GY521_I2C_ADDR_GND 0x68 // Default I2C address for GY-521(MPU-6050) (AD0 pin -> Gnd)
 #define GY521_I2C_ADDR_VCC 0x69 // Default I2C address for GY-521(MPU-6050) (AD0 pin -> Vcc)
 
@@ -88,6 +131,21 @@
 #define GY521_TEMP 2
 #define GY521_GYRO 3
 
+/*
+ * Channel bitmask for gy521_read_mask(), bit = register order
+ */
+#define GY521_MASK_AUTO 0x00 // Channels not in standby / sleep (gy521_mask_default())
+#define GY521_MASK_ACCEL_X (1 << 0)
+#define GY521_MASK_ACCEL_Y (1 << 1)
+#define GY521_MASK_ACCEL_Z (1 << 2)
+#define GY521_MASK_TEMP (1 << 3)
+#define GY521_MASK_GYRO_X (1 << 4)
+#define GY521_MASK_GYRO_Y (1 << 5)
+#define GY521_MASK_GYRO_Z (1 << 6)
+#define GY521_MASK_ACCEL 0x07
+#define GY521_MASK_GYRO 0x70
+#define GY521_MASK_ALL 0x7F
+
 // ========================================
 // === Full Scale Range (FSR) bit masks ===
 // ========================================
@@ -102,6 +160,18 @@
 #define GY521_GYRO_FSR_SEL_1000DPS 0x10
 #define GY521_GYRO_FSR_SEL_2000DPS 0x18
 
+// ==========================================
+// === Digital Low Pass Filter (DLPF_CFG) ===
+// ==========================================
+// Bandwidth accel / gyro. 260 Hz runs the gyro at 8 kHz, all others at 1 kHz
+#define GY521_DLPF_260HZ 0x00 // 260 Hz / 256 Hz
+#define GY521_DLPF_184HZ 0x01 // 184 Hz / 188 Hz
+#define GY521_DLPF_94HZ 0x02 // 94 Hz / 98 Hz
+#define GY521_DLPF_44HZ 0x03 // 44 Hz / 42 Hz
+#define GY521_DLPF_21HZ 0x04 // 21 Hz / 20 Hz
+#define GY521_DLPF_10HZ 0x05 // 10 Hz / 10 Hz
+#define GY521_DLPF_5HZ 0x06 // 5 Hz / 5 Hz
+
 // ==============================================
 // === Clock Source Select (CLKSEL) bit masks ===
 // ==============================================
@@ -121,34 +191,46 @@
 #define GY521_LP_WAKE_CTRL_20HZ (0x02 << 6)
 #define GY521_LP_WAKE_CTRL_40HZ (0x03 << 6)
 
+// ================================================
+// === Auxiliary I2C Master Clock (I2C_MST_CLK) ===
+// ================================================
+#define GY521_AUX_CLK_258KHZ 8
+#define GY521_AUX_CLK_348KHZ 0
+#define GY521_AUX_CLK_400KHZ 13
+
+// ===================
+// === Power Modes ===
+// ===================
+// Index of v.power.time_us
+#define GY521_POWER_FULL 0 // Full-rate sampling
+#define GY521_POWER_CYCLE 1 // Accel-only low-power cycle mode
+
+// Configuration registers mirrored in priv.shadow (see gy521.c)
+#define GY521_SHADOW_REGS 10
+
 // =======================
 // === Data Structures ===
 // =======================
+// Plain sample types live in gy521_types.h
 
 /*
- * Raw axis values directly from registers
- * Signed 16-bit values from sensor
+ * One candidate clock of gy521_baud_test()
  */
 typedef struct{
-	int16_t x,y,z;
-} gy521_axis_raw_t;
+	uint32_t baud; // Requested clock
+	uint32_t actual; // Clock the backend set (0 = not possible, skipped)
+	uint16_t bursts; // WHO_AM_I + data read + configuration read back
+	uint16_t errors; // Bursts with a failed transfer or wrong WHO_AM_I / read back
+	uint32_t samples_per_s; // Good bursts per second
+} gy521_baud_result_t;
 
 /*
- * Axis offset as calculated from
- * the calibrate function
+ * Sample stamp, set by the data-ready IRQ or when a read starts
  */
 typedef struct{
-	int32_t x, y, z;
-} gy521_offset_t;
-
-/*
- * Scaled axis values
- * - Accel: g-force
- * - Gyro: degrees per second
- */
-typedef struct{
-	float x,y,z;
-} gy521_axis_scaled_t;
+	uint32_t seq;
+	uint64_t timestamp_us;
+} gy521_stamp_t;
 
 /*
  * Main device structure
@@ -157,8 +239,13 @@ typedef struct{
  * - Measured values
  * - Configuration state
  * - Function pointers (pseudo OOP style)
+ * - Driver internal state (priv)
+ *
+ * Every function takes the device it works on as first argument:
+ *   imu.fn.read(&imu, GY521_ALL);
  */
-typedef struct gy521_s{
+typedef struct gy521_s gy521_s;
+struct gy521_s{
 	// =====================
 	// === Sensor Values ===
 	// =====================
@@ -166,17 +253,63 @@ typedef struct gy521_s{
 		struct{
 			gy521_axis_raw_t raw; // Raw accelerometer values
 			gy521_axis_scaled_t g; // Converted acceleration in G
+			gy521_axis_fixed_t mg; // Converted acceleration in milli-g (conf.fixed)
 		} accel;
 
 		struct{
 			gy521_axis_raw_t raw; // Raw gyro values
 			gy521_axis_scaled_t dps; // Converted gyro in °/s
+			gy521_axis_fixed_t mdps; // Converted gyro in milli-°/s (conf.fixed)
 		} gyro;
 
 		struct{
 			int16_t raw; // Raw temperature values
 			float celsius; // Converted temperature in °C
+			int32_t mcelsius; // Converted temperature in milli-°C (conf.fixed)
 		} temp;
+
+		uint32_t seq; // Sequence number of the sample in v
+		uint64_t timestamp_us; // Data-ready (or read start) time of the sample in v
+
+		struct{
+			uint32_t missed; // Data-ready pulses not followed by a read
+		} interrupt;
+
+		struct{
+			uint32_t period_us; // Effective output data rate as period (set by fn.rate() / fn.commit())
+			uint32_t odr_mhz; // Effective output data rate in milli-Hz
+			uint32_t skipped; // Reads skipped by conf.rate.pace (no new sample due)
+		} rate;
+
+		struct{
+			uint8_t mode; // GY521_POWER_* the device is in
+			uint64_t time_us[2]; // Time spent per GY521_POWER_* (updated by fn.power.update())
+			uint32_t wakeups; // Cycle -> full transitions on motion
+		} power;
+
+		struct{
+			uint16_t count; // Bytes in FIFO at the last fifo.read()
+			uint32_t overflows; // FIFO overflows recovered so far
+		} fifo;
+
+		struct{
+			uint8_t data[GY521_AUX_BYTES]; // EXT_SENS_DATA, slave 0 first (conf.aux.ext_len bytes)
+		} aux;
+
+		struct{
+			volatile bool busy; // DMA transfer in flight
+			volatile bool ready; // Completed buffer waiting for fn.read()
+			volatile uint8_t ready_buf; // Half of the double buffer that completed
+			uint32_t completed; // Finished transfers
+			uint32_t errors; // Aborted transfers (NACK)
+		} async;
+
+		struct{
+			uint32_t events; // Recoveries run (bus sequence + configuration re-applied)
+			uint32_t failed; // Recoveries after which the device still did not answer
+			uint64_t lost_us; // First failed transfer -> recovered, summed over all events
+			uint32_t last_us; // Same, last successful recovery
+		} recover;
 	} v;
 
 	// =====================
@@ -186,12 +319,17 @@ typedef struct gy521_s{
 		bool sleep; // Device sleep state
 		uint8_t clksel; // Clock source
 		bool reset; // Device reset flag
-		bool scaled;
+		bool scaled; // Convert to float units (g, °/s, °C)
+		bool fixed; // Convert to integer milli-units (mg, m°/s, m°C), no float math
 		uint8_t addr; // Device Address
+		gy521_bus_t *bus; // I2C transport the device is connected to
+		int int_pin; // GPIO of the INT line (-1 = none)
 
 		struct{
 			uint8_t fsr; // Full scale range setting
 			float fsr_divider;
+			int32_t fixed_mul; // milli-g per LSB in Q16.16 (set with fsr_divider)
+			gy521_offset_t offset; // XA/YA/ZA_OFFS, ±16 g LSB (includes the factory trim)
 
 			struct{ bool stby; } x;
 			struct{ bool stby; } y;
@@ -205,48 +343,280 @@ typedef struct gy521_s{
 		struct{
 			uint8_t fsr;
 			float fsr_divider;
-			gy521_offset_t offset;
+			int32_t fixed_mul; // milli-°/s per LSB in Q16.16 (set with fsr_divider)
+			gy521_offset_t offset; // XG/YG/ZG_OFFS_USR, ±1000 °/s LSB
 
 			struct{ bool clksel, stby; } x;
 			struct{ bool clksel, stby; } y;
 			struct{ bool clksel, stby; } z;
 		} gyro;
+
+		struct{
+			uint8_t div; // SMPLRT_DIV: sample rate = gyro rate / (1 + div)
+			uint8_t dlpf; // GY521_DLPF_*, also selects the gyro rate (8 kHz / 1 kHz)
+			bool pace; // Blocking fn.read() skips the bus until the next sample is due
+		} rate;
+
+		struct{
+			bool cycle; // Accel-only low-power cycle mode (gyro + temp off, overrides sleep)
+			uint8_t lp_wake; // GY521_LP_WAKE_CTRL_*: accel wake-up rate in cycle mode
+			bool auto_cycle; // fn.power.update(): cycle mode when idle, full rate on motion
+			uint16_t idle_ms; // No motion for this long -> cycle mode
+		} power;
+
+		struct{
+			uint8_t threshold; // MOT_THR, 2 mg/LSB (also the idle threshold of the auto policy)
+			uint8_t duration; // MOT_DUR, 1 ms/LSB
+		} motion;
+
+		struct{
+			bool enable; // Stream samples through the 1024 byte FIFO
+			bool accel, temp, gyro; // Channels written into the FIFO
+			uint8_t frame_size; // Bytes per FIFO frame (set by fn.fifo.set())
+		} fifo;
+
+		struct{
+			bool enable; // Auxiliary I2C master on: slaves are read with every sample
+			bool bypass; // Master off, host reaches the auxiliary bus directly (I2C_BYPASS_EN)
+			uint8_t clk; // GY521_AUX_CLK_*
+			uint8_t ext_len; // External bytes appended to every fn.read() (set by fn.aux.set())
+
+			struct{
+				uint8_t addr; // 7 bit address, 0 = slot unused
+				uint8_t reg; // First register
+				uint8_t len; // Bytes read into v.aux.data (0 = write 'out' to 'reg' every sample)
+				uint8_t out; // I2C_SLVx_DO
+				bool swap; // Swap byte pairs (little endian slave -> big endian)
+			} slv[GY521_AUX_SLAVES];
+		} aux;
+
+		struct{
+			bool enable; // fn.read() starts DMA transfers and returns without blocking
+			void (*callback)(gy521_s *); // Optional, called from DMA IRQ on completion
+		} async;
+
+		struct{
+			bool data_ready; // fn.read() only reads after a DATA_RDY pulse on conf.int_pin
+			bool motion; // Motion interrupt on conf.int_pin (always on while auto_cycle cycles)
+		} interrupt;
+
+		struct{
+			uint8_t after; // Failed transfers in a row before bus recovery (0 = never)
+		} recover;
 	} conf;
 
 	// =========================
 	// === Function Pointers ===
 	// =========================
 	struct{
-		bool (*test_connection)(void);
-		bool (*reset)(void);
-		bool (*sleep)(void);
-		bool (*read)(uint8_t);
-		bool (*fsr)(void);
-		bool (*stby)(void);
-		bool (*clk_sel)(void);
+		bool (*test_connection)(gy521_s *);
+		bool (*reset)(gy521_s *);
+		bool (*sleep)(gy521_s *);
+		bool (*read)(gy521_s *, uint8_t);
+		bool (*read_mask)(gy521_s *, uint8_t); // Only the channels in GY521_MASK_* (0 = from conf)
+		bool (*fsr)(gy521_s *);
+		bool (*stby)(gy521_s *);
+		bool (*clk_sel)(gy521_s *);
+		bool (*rate)(gy521_s *); // Apply conf.rate (SMPLRT_DIV + DLPF)
+		bool (*motion)(gy521_s *); // Apply conf.motion (MOT_THR + MOT_DUR)
+		bool (*interrupt)(gy521_s *);
+		bool (*commit)(gy521_s *); // Write every changed conf register at once
+		bool (*recover)(gy521_s *); // Bus recovery + configuration re-applied (also automatic)
+		bool (*calibrate)(gy521_s *, uint16_t); // Accel + gyro offsets into the chip, device still and level
 
 		struct{
-			//bool (*sleep)(void);
+			bool (*calibrate)(gy521_s *, uint16_t);
+			//bool (*sleep)(gy521_s *);
 		} accel;
 
 		struct{
-			//bool (*sleep)(void);
+			//bool (*sleep)(gy521_s *);
 		} temp;
 
 		struct{
-			bool (*calibrate)(uint8_t);
-			//bool (*sleep)(void);
+			bool (*calibrate)(gy521_s *, uint16_t);
+			//bool (*sleep)(gy521_s *);
 		} gyro;
+
+		struct{
+			bool (*get)(gy521_s *); // Offset registers -> conf.accel/gyro.offset
+			bool (*set)(gy521_s *); // conf.accel/gyro.offset -> offset registers
+		} offsets;
+
+		struct{
+			bool (*set)(gy521_s *); // Apply conf.fifo and reset the FIFO
+			bool (*reset)(gy521_s *); // Flush the FIFO
+			uint16_t (*read)(gy521_s *, gy521_sample_t *, uint16_t); // Burst-read up to n samples
+			uint16_t (*read_raw)(gy521_s *, uint8_t *, uint16_t); // Same, frames left undecoded (gy521_batch.h)
+		} fifo;
+
+		struct{
+			bool (*poll)(gy521_s *); // true while a DMA read is in flight
+		} async;
+
+		struct{
+			bool (*set)(gy521_s *); // Apply conf.aux (master, slots, bypass)
+			bool (*read)(gy521_s *, uint8_t, uint8_t, uint8_t *); // One byte from a slave register (SLV4)
+			bool (*write)(gy521_s *, uint8_t, uint8_t, uint8_t); // One byte to a slave register (SLV4)
+		} aux;
+
+		struct{
+			bool (*set)(gy521_s *); // Apply conf.power (cycle mode, wake-up rate)
+			bool (*update)(gy521_s *); // Auto policy step + time accounting, call after fn.read()
+		} power;
 	} fn;
-} gy521_s;
+
+#if GY521_INSTRUMENT
+	// =======================
+	// === Instrumentation ===
+	// =======================
+	gy521_instrument_t inst; // Transfer counters + latency histograms (gy521_instrument.h)
+#endif
+
+	// =============================
+	// === Driver internal state ===
+	// =============================
+	// Owned by the driver and its IRQ handlers, do not touch
+	struct{
+		volatile bool drdy_pending; // New sample signalled, not yet read
+		volatile gy521_stamp_t drdy_stamp; // Stamp of the pending sample
+		uint32_t seq; // Sequence counter without data-ready interrupt
+		uint64_t next_read_us; // conf.rate.pace: next sample due
+
+		volatile bool motion_pending; // Motion pulse not yet handled by fn.power.update()
+		uint64_t power_since; // Start of the current v.power.time_us interval
+		uint64_t last_motion_us; // Last time the accel moved more than conf.motion.threshold
+		gy521_axis_raw_t idle_ref; // Accel reference of the idle detection
+
+		struct{
+			uint8_t mask, ext_len; // Plan below is for this mask + conf.aux.ext_len
+			uint8_t count; // Register spans (1 or 2, 0 = not planned)
+			uint8_t reg[2], len[2];
+		} span;
+
+		uint8_t shadow[GY521_SHADOW_REGS]; // Last written configuration register values
+		bool shadow_valid; // shadow matches the device (else read on first use)
+		bool offsets_known; // conf offsets match the chip (restored after a recovery)
+
+		uint8_t failures; // Failed transfers since the last success / recovery
+		bool outage; // Transfers failing since fail_since, no successful recovery yet
+		uint64_t fail_since; // First failed transfer of the outage
+		bool recovering; // gy521_recover() running, its own transfers do not recurse
+		uint64_t dma_start_us; // Start of the DMA transfer in flight (bus timeout_us)
+
+		int dma_tx, dma_rx; // DMA channels (-1 = not claimed)
+		uint32_t dma_cmd[1 + 14 + GY521_AUX_BYTES]; // Register address + one read command per byte
+		uint8_t dma_buf[2][14 + GY521_AUX_BYTES]; // Double buffer
+		volatile uint8_t dma_fill; // Buffer the DMA writes into
+		volatile uint8_t dma_mode; // accel_temp_gyro of the transfer
+		gy521_stamp_t dma_stamp[2]; // Stamp of the sample in each buffer half
+	} priv;
+};
 
 // ============================
 // === Function declaration ===
 // ============================
+#if !GY521_HOST
+/*
+ * gy521_bus_init();
+ * Initializes an I²C port (GY521_I2C_BAUD) and its pins once and
+ * returns its transport. gy521_init(NULL, ...) does this itself
+ * for GY521_I2C_PORT with GY521_SDA_PIN / GY521_SCL_PIN.
+ */
+gy521_bus_t *gy521_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin);
+#endif
+
 /*
  * gy521_init();
- * Initializes the I²C connection and default configuration.
- * Returns a fully initialized gy521_s struct with function pointers and default values.
+ * Returns a device struct for 'addr' on 'bus' with function pointers
+ * and default values. bus = NULL selects the default RP2040 port.
+ */
+gy521_s gy521_init(gy521_bus_t *bus, uint8_t addr);
+
+bool gy521_read_register(gy521_s *dev, uint8_t reg, uint8_t *out, uint16_t how_many);
+bool gy521_write_register(gy521_s *dev, uint8_t reg, const uint8_t *data, uint8_t how_many);
+bool gy521_test_connection(gy521_s *dev);
+bool gy521_reset(gy521_s *dev);
+bool gy521_sleep(gy521_s *dev); // Set sleep configuration
+bool gy521_set_fsr(gy521_s *dev);
+bool gy521_set_clksel(gy521_s *dev);
+bool gy521_set_stby(gy521_s *dev);
+bool gy521_set_rate(gy521_s *dev); // Apply conf.rate, updates v.rate
+bool gy521_set_motion(gy521_s *dev); // Apply conf.motion
+bool gy521_set_power(gy521_s *dev); // Apply conf.power
+bool gy521_power_update(gy521_s *dev); // Auto cycle policy, time per power mode
+bool gy521_commit(gy521_s *dev); // Apply sleep, clksel, stby, fsr, rate, motion and power of conf in as few writes as possible
+bool gy521_calibrate(gy521_s *dev, uint16_t samples); // Accel + gyro offsets into the chip (samples=1024, ~0.5 s)
+bool gy521_calibrate_accel(gy521_s *dev, uint16_t samples);
+bool gy521_calibrate_gyro(gy521_s *dev, uint16_t samples);
+bool gy521_get_offsets(gy521_s *dev); // Read the offset registers into conf
+bool gy521_set_offsets(gy521_s *dev); // Write conf offsets (accel bit 0 kept)
+bool gy521_read(gy521_s *dev, uint8_t accel_temp_gyro); // 0=all 1=accel 2=temp 3=gyro
+
+/*
+ * gy521_read_mask();
+ * Blocking read of only the channels in 'mask' (GY521_MASK_*),
+ * in the smallest register span, or two spans if they would
+ * otherwise read more than GY521_SPAN_GAP_MAX unused bytes.
+ * Channels outside the mask keep their last value.
+ * GY521_MASK_AUTO = gy521_mask_default().
+ */
+bool gy521_read_mask(gy521_s *dev, uint8_t mask);
+uint8_t gy521_mask_default(const gy521_s *dev); // Channels not in standby, temp sleep or cycle mode
+bool gy521_fifo_set(gy521_s *dev); // Apply conf.fifo
+bool gy521_fifo_reset(gy521_s *dev); // Flush FIFO
+uint16_t gy521_fifo_read(gy521_s *dev, gy521_sample_t *samples, uint16_t max); // Burst-read FIFO frames
+uint16_t gy521_fifo_read_raw(gy521_s *dev, uint8_t *bytes, uint16_t max); // Burst-read FIFO frames undecoded
+bool gy521_async_poll(gy521_s *dev); // true while a DMA read is in flight
+bool gy521_aux_set(gy521_s *dev); // Apply conf.aux
+bool gy521_aux_read(gy521_s *dev, uint8_t addr, uint8_t reg, uint8_t *value); // Slave register via SLV4 (master on)
+bool gy521_aux_write(gy521_s *dev, uint8_t addr, uint8_t reg, uint8_t value);
+bool gy521_set_interrupt(gy521_s *dev); // Apply conf.interrupt
+
+/*
+ * gy521_recover();
+ * Runs bus->recover() and re-applies the configuration (conf
+ * registers, interrupt, FIFO, auxiliary master, known offsets),
+ * read back from the device first, as it may have been reset.
+ * Called by the driver after conf.recover.after failed transfers
+ * in a row; counted in v.recover.
  */
-gy521_s gy521_init(uint8_t addr);
-bool gy521_use(gy521_s *device);
+bool gy521_recover(gy521_s *dev);
+
+/*
+ * gy521_bus_baud();
+ * Sets the clock of 'bus', returns the clock actually set
+ * (0 = not possible). A timeout_us shorter than twice the longest
+ * read at that clock is raised.
+ */
+uint32_t gy521_bus_baud(gy521_bus_t *bus, uint32_t hz);
+
+/*
+ * gy521_baud_test();
+ * Runs 'bursts' x (WHO_AM_I + data read + configuration read back)
+ * at each clock in 'bauds' (NULL = 100 kHz, 400 kHz, 1 MHz) and
+ * leaves the bus at the fastest one without errors. Returns that
+ * clock, 0 = none was reliable (previous clock restored).
+ * 'results' (optional) gets one entry per candidate.
+ */
+uint32_t gy521_baud_test(gy521_s *dev, const uint32_t *bauds, uint8_t count, uint16_t bursts, gy521_baud_result_t *results);
+
+/*
+ * gy521_data_ready();
+ * INT line event for 'dev' (GPIO IRQ on the RP2040, the
+ * simulator's INT line on the host). Counts as motion while
+ * the auto policy cycles (or with only conf.interrupt.motion),
+ * else as data-ready. Safe from IRQ context.
+ */
+void gy521_data_ready(gy521_s *dev);
+
+/*
+ * gy521_read_batch();
+ * Reads several devices back to back (e.g. 0x68 + 0x69 on one bus).
+ * Returns true if every device delivered a new sample.
+ */
+bool gy521_read_batch(gy521_s **devices, uint8_t count, uint8_t accel_temp_gyro);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,146 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521.hpp
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Header-only C++ wrapper with the configuration fixed at
+ *  compile time:
+ *
+ *    gy521::Device<GY521_I2C_ADDR_GND, GY521_ACCEL_FSR_SEL_8G,
+ *                  GY521_GYRO_FSR_SEL_2000DPS> imu(bus);
+ *
+ *  - Scale factors are constexpr: no fsr_divider, no divide
+ *  - read() is one direct burst read with inlined decoding,
+ *    no call goes through gy521_s.fn
+ *  - Template arguments are checked with static_assert
+ *
+ *  The C device sits inside (c()), so every C function still
+ *  works on it (calibration, FIFO, interrupts, ...). Its FSR and
+ *  clock source belong to the template: commit() restores them.
+ *
+ *  C++17, no exceptions, no heap.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include "gy521.h"
+
+namespace gy521{
+
+// =======================
+// === Register Values ===
+// =======================
+namespace reg{
+	constexpr uint8_t accel_xout_h = 0x3B; // First of the 14 data registers
+}
+
+constexpr uint8_t fs_bits(uint8_t fsr){ return (fsr >> 3) & 0x03; } // FS_SEL bits 4:3
+
+constexpr int32_t accel_lsb_per_g(uint8_t fsr){ return 16384 >> fs_bits(fsr); }
+constexpr float gyro_lsb_per_dps(uint8_t fsr){ return 131.0f / (1 << fs_bits(fsr)); }
+
+// ====================================
+// === Fixed-point scaling (Q16.16) ===
+// ====================================
+// Same rounded multipliers and split multiply as the C driver (bit-identical results)
+constexpr int32_t accel_mg_q16(uint8_t fsr){ return 4000 << fs_bits(fsr); }
+constexpr int32_t gyro_mdps_q16(uint8_t fsr){ return (int32_t)((2 * 65536000LL * (1 << fs_bits(fsr)) + 131) / 262); }
+constexpr int32_t temp_mc_q16 = (2 * 65536000LL + 340) / 680;
+constexpr int32_t temp_mc_offset = 36530;
+
+constexpr int32_t fixed_mul(int32_t raw, int32_t mul){
+	return raw * (mul >> 16) + ((raw * (mul & 0xffff) + (1 << 15)) >> 16);
+}
+
+static_assert(accel_lsb_per_g(GY521_ACCEL_FSR_SEL_2G) == 16384 && accel_lsb_per_g(GY521_ACCEL_FSR_SEL_16G) == 2048, "Accel LSB/g");
+static_assert(accel_mg_q16(GY521_ACCEL_FSR_SEL_2G) == 4000 && accel_mg_q16(GY521_ACCEL_FSR_SEL_16G) == 32000, "Accel Q16");
+static_assert(gyro_mdps_q16(GY521_GYRO_FSR_SEL_250DPS) == 500275 && gyro_mdps_q16(GY521_GYRO_FSR_SEL_500DPS) == 1000550 &&
+	gyro_mdps_q16(GY521_GYRO_FSR_SEL_1000DPS) == 2001099 && gyro_mdps_q16(GY521_GYRO_FSR_SEL_2000DPS) == 4002198, "Gyro Q16");
+static_assert(temp_mc_q16 == 192753, "Temp Q16");
+static_assert(fixed_mul(-32768, accel_mg_q16(GY521_ACCEL_FSR_SEL_2G)) == -2000 && fixed_mul(32767, temp_mc_q16) == 96374, "fixed_mul");
+
+// ==============
+// === Device ===
+// ==============
+template<uint8_t Addr, uint8_t AccelFsr, uint8_t GyroFsr, uint8_t Clksel = GY521_CLKSEL_GYRO_X>
+class Device{
+	static_assert(Addr == GY521_I2C_ADDR_GND || Addr == GY521_I2C_ADDR_VCC, "Addr: GY521_I2C_ADDR_GND / _VCC");
+	static_assert((AccelFsr & ~0x18) == 0, "AccelFsr: GY521_ACCEL_FSR_SEL_*");
+	static_assert((GyroFsr & ~0x18) == 0, "GyroFsr: GY521_GYRO_FSR_SEL_*");
+	static_assert(Clksel <= GY521_CLKSEL_EXT_19_2MHZ || Clksel == GY521_CLKSEL_STOP, "Clksel: GY521_CLKSEL_*");
+
+public:
+	static constexpr uint8_t addr = Addr;
+	static constexpr uint8_t accel_config = AccelFsr; // ACCEL_CONFIG AFS_SEL
+	static constexpr uint8_t gyro_config = GyroFsr; // GYRO_CONFIG FS_SEL
+	static constexpr uint8_t clksel = Clksel; // PWR_MGMT_1 CLKSEL
+
+	static constexpr float g_per_lsb = 1.0f / accel_lsb_per_g(AccelFsr);
+	static constexpr float dps_per_lsb = 1.0f / gyro_lsb_per_dps(GyroFsr);
+	static constexpr int32_t mg_q16 = accel_mg_q16(AccelFsr);
+	static constexpr int32_t mdps_q16 = gyro_mdps_q16(GyroFsr);
+
+	// bus = nullptr selects the default RP2040 port (as gy521_init())
+	explicit Device(gy521_bus_t *bus = nullptr) : dev_(gy521_init(bus, Addr)){ pin(); }
+
+	// Wake up with the template configuration, other conf.* may be set through c() first
+	bool begin(){
+		dev_.conf.sleep = false;
+		return commit();
+	}
+
+	// gy521_commit() with FSR and clock source from the template
+	bool commit(){
+		pin();
+		return gy521_commit(&dev_);
+	}
+
+	// One burst of all 14 data registers. No stamp, pacing or
+	// data-ready handling: use c().fn.read() for those.
+	bool read(gy521_sample_t &s){
+		uint8_t b[14];
+		if(!gy521_read_register(&dev_, reg::accel_xout_h, b, 14)) return false;
+		decode(b, s);
+		return true;
+	}
+
+	static void decode(const uint8_t *b, gy521_sample_t &s){
+		s.accel.x = be16(b + 0);
+		s.accel.y = be16(b + 2);
+		s.accel.z = be16(b + 4);
+		s.temp = be16(b + 6);
+		s.gyro.x = be16(b + 8);
+		s.gyro.y = be16(b + 10);
+		s.gyro.z = be16(b + 12);
+	}
+
+	// Units
+	static constexpr float g(int16_t raw){ return raw * g_per_lsb; }
+	static constexpr float dps(int16_t raw){ return raw * dps_per_lsb; }
+	static constexpr float celsius(int16_t raw){ return raw * (1.0f / 340.0f) + 36.53f; }
+	static constexpr int32_t mg(int16_t raw){ return fixed_mul(raw, mg_q16); }
+	static constexpr int32_t mdps(int16_t raw){ return fixed_mul(raw, mdps_q16); }
+	static constexpr int32_t mcelsius(int16_t raw){ return fixed_mul(raw, temp_mc_q16) + temp_mc_offset; }
+
+	gy521_s &c(){ return dev_; } // The C device, for every gy521_* / fn.* call
+	const gy521_s &c() const{ return dev_; }
+
+private:
+	static constexpr int16_t be16(const uint8_t *p){ return (int16_t)((p[0] << 8) | p[1]); }
+
+	void pin(){
+		dev_.conf.accel.fsr = AccelFsr;
+		dev_.conf.gyro.fsr = GyroFsr;
+		dev_.conf.clksel = Clksel;
+		dev_.conf.gyro.x.clksel = dev_.conf.gyro.y.clksel = dev_.conf.gyro.z.clksel = false;
+	}
+
+	gy521_s dev_;
+};
+
+} // namespace gy521
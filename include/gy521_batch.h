@@ -0,0 +1,59 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_batch.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Bulk conversion of raw big-endian frames (14 byte register
+ *  frames or FIFO bytes from fn.fifo.read_raw()) into
+ *  structure-of-arrays outputs, one array per channel.
+ *
+ *  Scaling uses the device's current FSR (conf.*.fsr_divider /
+ *  conf.*.fixed_mul); offsets are already applied by the chip
+ *  (fn.calibrate). Fixed results are bit-identical to fn.read()
+ *  with conf.fixed, float results within a few rounding steps of
+ *  conf.scaled (multiply by the reciprocal instead of a divide).
+ *
+ *  Output pointers left NULL are skipped, as are channels the
+ *  layout does not contain.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include "gy521.h"
+
+/*
+ * Where each channel sits in a frame, -1 = not present
+ */
+typedef struct{
+	uint8_t stride; // Bytes per frame
+	int8_t accel, temp, gyro; // Byte offset of the channel
+} gy521_layout_t;
+
+// 14 byte frames as read from ACCEL_XOUT_H .. GYRO_ZOUT_L
+#define GY521_LAYOUT_REGS ((gy521_layout_t){14, 0, 6, 8})
+
+typedef struct{
+	int16_t *accel[3], *temp, *gyro[3]; // Raw values
+} gy521_soa_raw_t;
+
+typedef struct{
+	int32_t *accel[3], *temp, *gyro[3]; // milli-g, milli-°C, milli-°/s
+} gy521_soa_fixed_t;
+
+typedef struct{
+	float *accel[3], *temp, *gyro[3]; // g, °C, °/s
+} gy521_soa_float_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+gy521_layout_t gy521_layout_fifo(const gy521_s *dev); // Frame layout of conf.fifo (after fn.fifo.set())
+
+void gy521_batch_raw(const uint8_t *bytes, uint16_t n, gy521_layout_t layout, const gy521_soa_raw_t *out);
+void gy521_batch_fixed(const gy521_s *dev, const uint8_t *bytes, uint16_t n, gy521_layout_t layout, const gy521_soa_fixed_t *out);
+void gy521_batch_float(const gy521_s *dev, const uint8_t *bytes, uint16_t n, gy521_layout_t layout, const gy521_soa_float_t *out);
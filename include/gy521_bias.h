@@ -0,0 +1,133 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_bias.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Online gyro bias tracking: keeps the gyro offset registers
+ *  (conf.gyro.offset) right while the temperature drifts, without
+ *  stopping the stream like fn.gyro.calibrate() does.
+ *
+ *  The stream is cut into windows of conf.window samples. A window
+ *  is still when every accel and gyro axis stays within its noise
+ *  limit (standard deviation) and the remaining gyro rate is small.
+ *  After conf.hold still windows in a row each still window is a
+ *  bias measurement: the estimate moves 1/2^conf.shift of the way
+ *  to it. Every measurement also goes into a least-squares fit of
+ *  bias vs. v.temp.raw (forgetting 1/2^conf.forget per window).
+ *  In motion the estimate follows the fitted slope from the last
+ *  measurement on, so the correction keeps up with the temperature.
+ *
+ *  Per sample 7 adds and 6 multiply-adds, integer only. Once per
+ *  window 7 divisions and the fit (a few float operations), at
+ *  most one 6 byte register write.
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521.h"
+
+#ifndef GY521_BIAS_WINDOW
+#define GY521_BIAS_WINDOW 128 // Samples per stillness window
+#endif
+
+#define GY521_BIAS_SETTLE 2 // Samples dropped after an offset change (still from the old offset)
+
+// gy521_bias_update() result bits
+#define GY521_BIAS_DONE (1 << 0) // A window completed, v.still is new
+#define GY521_BIAS_OFFSET (1 << 1) // v.offset changed (and was written by gy521_bias_update)
+
+typedef struct{
+	// =====================
+	// === Configuration ===
+	// =====================
+	// Change, then call gy521_bias_reset()
+	struct{
+		uint16_t window; // Samples per window (default GY521_BIAS_WINDOW)
+		uint8_t hold; // Still windows in a row before measuring (default 4)
+		uint8_t shift; // Estimate moves 1/2^shift towards each measurement (default 3)
+		uint8_t forget; // Fit forgets 1/2^forget per measurement, 0 = never (default 12)
+		uint16_t gyro_noise_mdps; // Still: gyro std per axis at most (default 300)
+		uint16_t accel_noise_mg; // Still: accel std per axis at most (default 20)
+		uint16_t max_rate_mdps; // Still: remaining gyro rate per axis at most (default 10000)
+		uint16_t min_spread_mc; // Temperature std in m°C before a slope is fitted (default 1000)
+		bool model; // Follow the fitted slope between measurements
+	} conf;
+
+	// ==============
+	// === Output ===
+	// ==============
+	struct{
+		gy521_offset_t offset; // XG/YG/ZG_OFFS_USR values the estimate asks for, ±1000 °/s LSB
+		float slope[3]; // Fitted drift, offset LSB per °C
+		bool fitted; // slope valid
+		bool still; // Last window was still
+		uint32_t windows, still_windows;
+		uint32_t measurements; // Still windows used for the estimate
+		uint32_t changes; // v.offset changes
+	} v;
+
+	// ======================
+	// === Internal state ===
+	// ======================
+	struct{
+		int64_t sum[7]; // ax ay az gx gy gz temp
+		uint64_t sumsq[6];
+		uint16_t count;
+		uint8_t skip; // Samples still to drop after an offset change
+		uint8_t run; // Still windows in a row
+
+		int32_t est[3]; // Bias estimate, offset LSB in Q8, at temperature t_est
+		int32_t t_est; // Raw temperature of the last measurement
+		bool has_est;
+
+		int32_t t0; // Raw temperature the fit is centered on
+		float n, t, tt, b[3], tb[3]; // Fit sums, t in °C from t0
+
+		bool synced; // v.offset taken over from dev (gy521_bias_update)
+	} priv;
+} gy521_bias_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+/*
+ * gy521_bias_init();
+ * Defaults, no estimate yet, v.offset = 0.
+ */
+void gy521_bias_init(gy521_bias_t *b);
+
+/*
+ * gy521_bias_reset();
+ * Drops the estimate, the fit and the current window,
+ * keeps conf and v.offset.
+ */
+void gy521_bias_reset(gy521_bias_t *b);
+
+/*
+ * gy521_bias_update();
+ * Feeds the sample in dev->v after fn.read(dev, GY521_ALL). On a
+ * v.offset change it is copied to conf.gyro.offset and written
+ * to the gyro offset registers (after a failed write the next
+ * call reads them back and restarts). The first call takes
+ * conf.gyro.offset over (reads it from the chip if not known), so
+ * do fn.gyro.calibrate() first; a later calibrate is noticed and
+ * restarts the estimate.
+ * Returns GY521_BIAS_* bits.
+ */
+uint8_t gy521_bias_update(gy521_bias_t *b, gy521_s *dev);
+
+/*
+ * gy521_bias_update_sample();
+ * Estimator only, for one raw sample (FIFO, replay). The data must
+ * have been taken with v.offset applied, the caller applies changes.
+ * 'accel_fsr' / 'gyro_fsr' = GY521_*_FSR_SEL_* of the data.
+ */
+uint8_t gy521_bias_update_sample(gy521_bias_t *b, const gy521_sample_t *s, uint8_t accel_fsr, uint8_t gyro_fsr);
@@ -0,0 +1,80 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_bus.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Pluggable I²C transport.
+ *
+ *  The driver never calls the pico-sdk I²C functions directly,
+ *  it goes through a gy521_bus_t. Backends:
+ *  - RP2040 hardware I²C (gy521_bus_init(), gy521_pico.c)
+ *  - MPU-6050 register simulator (gy521_sim.h, host builds)
+ *
+ *  set_baud() changes the bus clock (gy521_bus_baud(),
+ *  gy521_baud_test() picks the fastest reliable one).
+ *  timeout_us bounds every transfer, recover() frees a stuck bus
+ *  (SDA held low): the driver calls it after conf.recover.after
+ *  failed transfers in a row.
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define GY521_BUS_ERROR -1 // NACK (PICO_ERROR_GENERIC)
+#define GY521_BUS_TIMEOUT -2 // Deadline passed (PICO_ERROR_TIMEOUT)
+
+#define GY521_BAUD_STANDARD 100000 // Standard-mode
+#define GY521_BAUD_FAST 400000 // Fast-mode, the MPU-6050 datasheet maximum
+#define GY521_BAUD_FAST_PLUS 1000000 // Fast-mode Plus (RP2040 maximum, short traces + strong pull-ups)
+
+#ifndef GY521_BUS_TIMEOUT_US
+#define GY521_BUS_TIMEOUT_US 2000 // Default timeout_us: 38 byte read at 400 kHz ~ 0.9 ms
+#endif
+
+/*
+ * Transfer callbacks follow the pico-sdk i2c_*_blocking() convention:
+ * return the number of bytes transferred, < 0 on error (NACK).
+ * nostop = true keeps the bus for a repeated start.
+ * A backend honouring timeout_us returns GY521_BUS_TIMEOUT when
+ * the transfer has not finished within it.
+ */
+typedef int (*gy521_bus_write_fn)(void *ctx, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+typedef int (*gy521_bus_read_fn)(void *ctx, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+/*
+ * Bus recovery: clock SCL until the slave releases SDA, STOP,
+ * re-init the peripheral. true = bus idle again.
+ */
+typedef bool (*gy521_bus_recover_fn)(void *ctx);
+
+// Sets the bus clock, returns the clock actually set (dividers round), 0 = not possible
+typedef uint32_t (*gy521_bus_baud_fn)(void *ctx, uint32_t hz);
+
+typedef struct gy521_bus_s{
+	void *ctx; // Backend context (i2c_inst_t *, simulator, ...)
+	gy521_bus_write_fn write;
+	gy521_bus_read_fn read;
+	gy521_bus_recover_fn recover; // NULL = no recovery sequence (config is still re-applied)
+	uint32_t timeout_us; // Deadline per transfer, 0 = wait forever
+	gy521_bus_baud_fn set_baud; // NULL = fixed clock
+	uint32_t baud; // Current bus clock in Hz
+
+	void *owner; // Device whose non-blocking transfer currently holds the bus, NULL once it ends
+
+	struct{
+		uint32_t transactions; // Register reads/writes (one address phase each)
+		uint32_t bytes; // Payload bytes incl. register address
+		uint32_t errors; // Failed or short transfers
+		uint32_t timeouts; // Failed by timeout_us (also in errors)
+		uint32_t recoveries; // recover() runs
+	} stat;
+} gy521_bus_t;
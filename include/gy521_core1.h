@@ -0,0 +1,43 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_core1.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Acquisition engine on core 1.
+ *
+ *  Core 1 owns the I2C bus and the device while the engine
+ *  runs: it reads samples and pushes timestamped frames into
+ *  a gy521_ring_t. Core 0 drains them with gy521_ring_pop()
+ *  and must not call any fn.* of the device until
+ *  gy521_core1_stop() returned.
+ *  The data-ready GPIO IRQ moves to core 1 with the engine
+ *  (off on core 0) and back to core 0 on stop.
+ *
+ * ================================================================
+ */
+#pragma once
+#include "gy521.h"
+#include "gy521_ring.h"
+
+// ============================
+// === Function declaration ===
+// ============================
+/*
+ * gy521_core1_start();
+ * Launches core 1 reading 'device' with fn.read(accel_temp_gyro)
+ * and pushing every new sample into 'ring'. Respects the
+ * device configuration (data-ready interrupt, async DMA, ...).
+ */
+bool gy521_core1_start(gy521_s *device, gy521_ring_t *ring, uint8_t accel_temp_gyro);
+
+/*
+ * gy521_core1_stop();
+ * Stops the engine after the current read and resets core 1.
+ */
+void gy521_core1_stop(void);
+
+bool gy521_core1_running(void);
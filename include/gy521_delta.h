@@ -0,0 +1,135 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_delta.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Change-only output: a sample is sent only when a channel
+ *  moved more than its deadband (conf.deadband) away from the
+ *  last sent value, as delta against that value. A receiver's
+ *  copy is therefore never further off than the deadband.
+ *  Every conf.keyframe-th packet is a keyframe with absolute
+ *  values, a receiver (re)starts there. Without motion a delta
+ *  packet goes out every conf.heartbeat_us anyway.
+ *
+ *  Packet, little endian:
+ *    0  sync     0xA5
+ *    1  mask     bit 0..6 = channel ax ay az temp gx gy gz
+ *                present, bit 7 = keyframe (all present)
+ *    2  count    uint8, packet counter (loss detection)
+ *    key:   seq uint32, time uint32 (µs, low 32 bits),
+ *           7 x int16 raw
+ *    delta: seq step varint, µs step varint,
+ *           per present channel: zigzag varint delta
+ *    crc  uint16, CRC-16/CCITT-FALSE over bytes 1..crc-1
+ *  varint = 7 bits per byte, low first, bit 7 = more follows.
+ *  A still sensor costs one 10 byte packet per heartbeat, a
+ *  moving one 10..22 bytes per sample (telemetry frame: 24).
+ *
+ *  The decoder takes one byte at a time, resynchronizes on sync
+ *  + CRC and drops deltas after a lost packet until the next
+ *  keyframe.
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521.h"
+
+#define GY521_DELTA_SYNC 0xA5
+#define GY521_DELTA_KEY (1 << 7)
+#define GY521_DELTA_MAX_SIZE (3 + 5 + 5 + 7 * 3 + 2) // Largest packet (delta with every channel)
+
+#ifndef GY521_DELTA_KEYFRAME
+#define GY521_DELTA_KEYFRAME 64 // Packets per keyframe
+#endif
+
+#ifndef GY521_DELTA_HEARTBEAT_US
+#define GY521_DELTA_HEARTBEAT_US 1000000 // Longest silence without motion
+#endif
+
+typedef struct{
+	// =====================
+	// === Configuration ===
+	// =====================
+	struct{
+		uint16_t deadband[7]; // Raw LSB per channel (ax ay az temp gx gy gz), 0 = every change
+		uint16_t keyframe; // Every n-th packet is a keyframe, 0/1 = all
+		uint32_t heartbeat_us; // Send after this long without a packet, 0 = only on change
+	} conf;
+
+	// ======================
+	// === Internal state ===
+	// ======================
+	struct{
+		int16_t last[7]; // Values the receiver has
+		uint32_t seq;
+		uint64_t timestamp_us;
+		uint16_t since_key; // Packets since the last keyframe
+		uint8_t count;
+		bool started;
+	} priv;
+
+	struct{
+		uint32_t samples; // Fed in
+		uint32_t packets, keyframes;
+		uint32_t bytes;
+	} stat;
+} gy521_delta_encoder_t;
+
+typedef struct{
+	uint8_t buf[GY521_DELTA_MAX_SIZE];
+	uint8_t len;
+
+	int16_t last[7];
+	uint32_t seq;
+	uint64_t timestamp_us;
+	uint8_t count; // Packet counter of the last valid packet
+	bool started; // count valid
+	bool synced; // Keyframe seen, no packet lost since
+	uint32_t gap; // Packets lost right before the last decoded one
+
+	struct{
+		uint32_t packets, keyframes; // Valid packets decoded
+		uint32_t lost; // Missing packet counts
+		uint32_t unsynced; // Valid deltas dropped while waiting for a keyframe
+		uint32_t crc_errors;
+		uint32_t skipped; // Bytes dropped while searching for sync
+	} stat;
+} gy521_delta_decoder_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+/*
+ * gy521_delta_init();
+ * Same deadband for the accel / gyro axes (temp: 34 LSB = 0.1 °C),
+ * GY521_DELTA_KEYFRAME and GY521_DELTA_HEARTBEAT_US.
+ */
+void gy521_delta_init(gy521_delta_encoder_t *e, uint16_t accel_lsb, uint16_t gyro_lsb);
+
+/*
+ * gy521_delta_encode();
+ * Feeds the sample in dev->v (raw fields, v.seq, v.timestamp_us)
+ * after fn.read(). Writes a packet to 'out' (GY521_DELTA_MAX_SIZE
+ * bytes) if one is due, returns its size, 0 = nothing to send.
+ */
+uint8_t gy521_delta_encode(gy521_delta_encoder_t *e, const gy521_s *dev, uint8_t *out);
+uint8_t gy521_delta_encode_frame(gy521_delta_encoder_t *e, const gy521_frame_t *frame, uint8_t *out); // FIFO, ring buffer
+void gy521_delta_key(gy521_delta_encoder_t *e); // Next packet is a keyframe (e.g. receiver connected)
+
+void gy521_delta_decoder_init(gy521_delta_decoder_t *d);
+
+/*
+ * gy521_delta_decode();
+ * Feeds one byte. Returns true when it completes a packet that
+ * could be applied, 'out' = the sender's values at that sample
+ * (seq / timestamp unwrapped).
+ */
+bool gy521_delta_decode(gy521_delta_decoder_t *d, uint8_t byte, gy521_frame_t *out);
@@ -0,0 +1,127 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_flash.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Calibration + configuration in flash, for a boot without
+ *  recalibration.
+ *
+ *  gy521_flash_save() stores the offsets and the persistent part
+ *  of conf (everything but the bus, callbacks and derived values)
+ *  as one record, keyed by conf.addr. gy521_flash_restore() loads
+ *  the newest valid record of the device and applies it in one go.
+ *
+ *  The region (flash->sectors, at least 2) is a log of one page
+ *  slots. A save goes into the next erased slot; entering a sector
+ *  erases it and first copies the newest record of every other
+ *  device over, so the previous sector keeps a valid copy until
+ *  it is erased itself. Erases rotate over all sectors, an
+ *  unchanged conf is not written at all.
+ *
+ *  Record, little endian, one page:
+ *    0  magic    "GY"
+ *    2  version  GY521_FLASH_VERSION (payload layout)
+ *    3  addr     I2C address (key)
+ *    4  tag      flash->tag of the writer (e.g. build options)
+ *    6  seq      uint32, newest wins
+ *   10  len      payload bytes
+ *   11  payload
+ *    .  crc      uint16, CRC-16/CCITT-FALSE over bytes 0..crc-1
+ *  A torn write (power loss) fails the CRC, the previous record
+ *  stays valid.
+ *
+ *  Backends: RP2040 flash (gy521_flash_init(), gy521_pico.c) and
+ *  the RAM stand-in of the simulator (gy521_sim_flash_init()).
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GY521_FLASH_VERSION 1
+#define GY521_FLASH_SECTOR 4096 // Erase unit (FLASH_SECTOR_SIZE)
+#define GY521_FLASH_PAGE 256 // Program unit (FLASH_PAGE_SIZE) = one record slot
+
+#ifndef GY521_FLASH_SECTORS
+#define GY521_FLASH_SECTORS 2 // Reserved at the end of flash by gy521_flash_init()
+#endif
+
+#ifndef GY521_FLASH_KEYS
+#define GY521_FLASH_KEYS 4 // Devices (addresses) one region holds
+#endif
+
+// Reads 'len' bytes at 'offset' (from the start of flash)
+typedef bool (*gy521_flash_read_fn)(void *ctx, uint32_t offset, uint8_t *dst, uint32_t len);
+// Erases the sector at 'offset' (all bytes 0xFF)
+typedef bool (*gy521_flash_erase_fn)(void *ctx, uint32_t offset);
+// Programs the page at 'offset' (bits can only go 1 -> 0)
+typedef bool (*gy521_flash_program_fn)(void *ctx, uint32_t offset, const uint8_t *src);
+
+typedef struct{
+	void *ctx; // Backend context
+	gy521_flash_read_fn read;
+	gy521_flash_erase_fn erase;
+	gy521_flash_program_fn program;
+	uint32_t offset; // Region start, sector aligned
+	uint16_t sectors; // Region size, >= 2
+	uint16_t tag; // Written into every record, records with another tag are ignored
+
+	struct{
+		uint32_t erases, programs; // Sectors erased, pages programmed
+		uint32_t unchanged; // Saves skipped: conf equal to the stored record
+		uint32_t invalid; // Used slots that failed the checks in the last scan
+	} stat;
+} gy521_flash_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+#if !GY521_HOST
+/*
+ * gy521_flash_init();
+ * Transport for the last GY521_FLASH_SECTORS sectors of the
+ * RP2040 flash. Erase / program run through flash_safe_execute():
+ * interrupts off, core 1 parked (the core-1 engine allows this).
+ */
+gy521_flash_t *gy521_flash_init(void);
+#endif
+
+/*
+ * gy521_flash_save();
+ * Stores the offsets + persistent conf of 'dev' (offsets read
+ * from the chip first if not known). Nothing is written if the
+ * newest record already holds the same. An erase takes ~50 ms.
+ */
+bool gy521_flash_save(gy521_flash_t *flash, gy521_s *dev);
+
+/*
+ * gy521_flash_load();
+ * conf from the newest valid record of conf.addr, nothing applied.
+ * false = no record with this version + tag + a good CRC.
+ */
+bool gy521_flash_load(gy521_flash_t *flash, gy521_s *dev);
+
+/*
+ * gy521_flash_restore();
+ * gy521_flash_load() + applied to the chip: commit, offsets,
+ * FIFO / aux / interrupt if enabled. false = calibrate instead.
+ */
+bool gy521_flash_restore(gy521_flash_t *flash, gy521_s *dev);
+
+bool gy521_flash_erase(gy521_flash_t *flash); // Wipes the region (all devices)
+
+#ifdef __cplusplus
+}
+#endif
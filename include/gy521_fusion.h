@@ -0,0 +1,127 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_fusion.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  On-device sensor fusion: accel + gyro -> orientation
+ *  (quaternion and roll/pitch/yaw) once per sample.
+ *
+ *  Algorithms (conf.algo):
+ *  - GY521_FUSION_MADGWICK      gradient descent, gain conf.beta
+ *  - GY521_FUSION_MAHONY        PI feedback, gains conf.kp / conf.ki
+ *  - GY521_FUSION_COMPLEMENTARY roll/pitch blended with the accel
+ *                               tilt (time constant conf.tau),
+ *                               yaw from the gyro only
+ *
+ *  conf.fixed = true runs everything in Q8.24 integer math
+ *  (no float, for the FPU-less Cortex-M0+).
+ *
+ *  Yaw has no absolute reference (no magnetometer) and drifts
+ *  with the residual gyro bias.
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521.h"
+
+#define GY521_FUSION_MADGWICK 0
+#define GY521_FUSION_MAHONY 1
+#define GY521_FUSION_COMPLEMENTARY 2
+
+#define GY521_FUSION_ONE (1 << 24) // 1.0 in Q8.24
+
+typedef struct{
+	float w, x, y, z;
+} gy521_quat_t;
+
+typedef struct{
+	int32_t w, x, y, z; // Q8.24
+} gy521_quat_fixed_t;
+
+typedef struct{
+	float roll, pitch, yaw; // Degrees
+} gy521_euler_t;
+
+typedef struct{
+	int32_t roll, pitch, yaw; // Milli-degrees
+} gy521_euler_fixed_t;
+
+typedef struct{
+	// =====================
+	// === Configuration ===
+	// =====================
+	// Change, then call gy521_fusion_set()
+	struct{
+		uint8_t algo; // GY521_FUSION_*
+		bool fixed; // Q8.24 integer math, fills v.q_fixed / v.mdeg instead of v.q / v.deg
+		float beta; // Madgwick gain (default 0.1)
+		float kp, ki; // Mahony gains in 1/s (default 1.0 / 0.0)
+		float tau; // Complementary time constant in s (default 0.5)
+		uint32_t dt_us; // Sample period, 0 = from the sample timestamps
+	} conf;
+
+	// ===================
+	// === Orientation ===
+	// ===================
+	struct{
+		gy521_quat_t q; // Body -> world rotation (float mode)
+		gy521_euler_t deg;
+		gy521_quat_fixed_t q_fixed; // Same in fixed mode
+		gy521_euler_fixed_t mdeg;
+		uint32_t updates; // Samples fused
+	} v;
+
+	// =============================
+	// === Filter internal state ===
+	// =============================
+	struct{
+		float q[4], integral[3], angle[3]; // angle = complementary roll/pitch/yaw in rad
+		int32_t qf[4], integralf[3], anglef[3];
+		int32_t beta, kp, ki, inv_tau; // conf gains in Q8.24
+		uint64_t last_us; // Timestamp of the previous sample
+		uint32_t last_seq;
+		bool started;
+	} priv;
+} gy521_fusion_t;
+
+/*
+ * gy521_fusion_init();
+ * Identity orientation with the default gains for 'algo'.
+ */
+void gy521_fusion_init(gy521_fusion_t *f, uint8_t algo, bool fixed);
+
+/*
+ * gy521_fusion_set();
+ * Applies conf (precomputes the fixed-point gains).
+ */
+void gy521_fusion_set(gy521_fusion_t *f);
+
+/*
+ * gy521_fusion_reset();
+ * Back to identity, keeps conf.
+ */
+void gy521_fusion_reset(gy521_fusion_t *f);
+
+/*
+ * gy521_fusion_update();
+ * Fuses the sample in dev->v after fn.read(dev, GY521_ALL)
+ * (bias removed in the chip by fn.calibrate). dt comes from the
+ * sample timestamps unless conf.dt_us is set. Returns false if
+ * there is no new sample (or it is the first one without dt).
+ */
+bool gy521_fusion_update(gy521_fusion_t *f, const gy521_s *dev);
+
+/*
+ * gy521_fusion_update_sample();
+ * Fuses one raw sample (FIFO, replay). 'gyro_fsr' = GY521_GYRO_FSR_SEL_*
+ * of the data, dt_us = time since the previous sample.
+ */
+void gy521_fusion_update_sample(gy521_fusion_t *f, const gy521_sample_t *s, uint8_t gyro_fsr, uint32_t dt_us);
@@ -0,0 +1,41 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_host.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Host (GY521_HOST) specific API.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * gy521_host_clock();
+ * Replaces CLOCK_MONOTONIC as time base of the driver
+ * (timestamps, calibration delays). NULL restores it.
+ * The simulator provides gy521_sim_now() / gy521_sim_sleep().
+ */
+void gy521_host_clock(uint64_t (*now_us)(void *ctx), void (*sleep_us)(void *ctx, uint64_t us), void *ctx);
+
+/*
+ * gy521_host_dma();
+ * Fake DMA engine for conf.async.enable: a transfer copies the
+ * registers through the transport at its start and completes
+ * 'transfer_us' later, at the next fn.read() / gy521_async_poll()
+ * (conf.async.callback runs there). Same double buffer hand-off as
+ * the RP2040. 0 (default) = blocking reads.
+ */
+void gy521_host_dma(uint32_t transfer_us);
+
+#ifdef __cplusplus
+}
+#endif
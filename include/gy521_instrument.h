@@ -0,0 +1,87 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_instrument.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Optional hot-path instrumentation, one per device (dev->inst).
+ *  Compiled in with GY521_INSTRUMENT=1, otherwise the driver
+ *  contains no trace of it.
+ *
+ *  - Transfer counters: transfers, bytes, NACKs, short reads/writes
+ *  - Per sample: first / last timestamp, min / max interval
+ *  - log2 histograms in µs: read duration, sample age (stamp ->
+ *    decoded) and jitter (|interval - v.rate.period_us|)
+ *
+ *  Bucket k holds values < 2^k (k = 0: exactly 0), the last
+ *  bucket everything above. Recording is a few adds and one clz.
+ *
+ *  Written by the context that calls fn.read(); read it from
+ *  there too (or stop the core-1 engine first).
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GY521_INSTRUMENT
+#define GY521_INSTRUMENT 0 // 1 = per-device counters + histograms (dev->inst)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GY521_HIST_BUCKETS 16 // 0 .. >= 16.4 ms
+
+typedef struct{
+	uint32_t bucket[GY521_HIST_BUCKETS];
+} gy521_hist_t;
+
+typedef struct{
+	struct{
+		uint32_t transfers; // bus->write / bus->read calls
+		uint32_t bytes; // Bytes actually moved
+		uint32_t nacks; // Transfers that returned an error
+		uint32_t short_reads; // Fewer bytes than requested
+		uint32_t short_writes;
+	} bus;
+
+	struct{
+		uint32_t count; // Samples delivered by fn.read()
+		uint32_t gaps; // Sequence number jumps (samples never read)
+		uint32_t last_seq;
+		uint64_t first_us, last_us; // Sample timestamps
+		uint32_t interval_min_us, interval_max_us; // Between consecutive samples
+	} sample;
+
+	gy521_hist_t read_us; // Duration of a blocking read
+	gy521_hist_t age_us; // Sample stamp -> decoded
+	gy521_hist_t jitter_us; // |interval - nominal period|
+} gy521_instrument_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+void gy521_instrument_reset(gy521_instrument_t *in);
+
+// Recording, called by the driver
+void gy521_instrument_xfer(gy521_instrument_t *in, bool read, int ret, uint16_t len);
+void gy521_instrument_sample(gy521_instrument_t *in, uint32_t seq, uint64_t stamp_us, uint64_t start_us, uint64_t end_us, uint32_t period_us);
+
+/*
+ * gy521_instrument_dump();
+ * Formats the counters and non-empty histogram buckets into 'buf'
+ * (integers only, no float). Returns the length written.
+ */
+uint16_t gy521_instrument_dump(const gy521_instrument_t *in, char *buf, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
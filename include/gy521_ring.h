@@ -0,0 +1,56 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_ring.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Lock-free single-producer / single-consumer ring buffer
+ *  for gy521_frame_t.
+ *
+ *  - Producer (core 1) only writes 'head' and the statistics
+ *  - Consumer (core 0) only writes 'tail'
+ *  - Only atomic loads/stores are used (no read-modify-write),
+ *    so it works on the Cortex-M0+ and on any host with C11 atomics
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521_types.h"
+
+#ifndef GY521_RING_SIZE
+#define GY521_RING_SIZE 256 // Frames, must be a power of two
+#endif
+
+#if (GY521_RING_SIZE & (GY521_RING_SIZE - 1)) != 0
+#error "GY521_RING_SIZE must be a power of two"
+#endif
+
+typedef struct{
+	_Atomic uint32_t head; // Next slot to write (producer)
+	_Atomic uint32_t tail; // Next slot to read (consumer)
+	_Atomic uint32_t overruns; // Frames dropped because the ring was full (producer)
+	_Atomic uint32_t high_water; // Max. fill level seen (producer)
+	gy521_frame_t buf[GY521_RING_SIZE];
+} gy521_ring_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+void gy521_ring_init(gy521_ring_t *ring);
+
+// Producer side: false (and overruns++) if the ring is full
+bool gy521_ring_push(gy521_ring_t *ring, const gy521_frame_t *frame);
+
+// Consumer side: copies up to 'max' frames, returns how many
+uint16_t gy521_ring_pop(gy521_ring_t *ring, gy521_frame_t *out, uint16_t max);
+
+// Frames currently queued (safe from either side)
+uint32_t gy521_ring_count(gy521_ring_t *ring);
@@ -0,0 +1,206 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_sim.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Register-level MPU-6050 simulator + gy521_bus_t backend.
+ *
+ *  Covers WHO_AM_I, PWR_MGMT_1/2 (reset, sleep, cycle mode,
+ *  standby), SMPLRT_DIV, CONFIG (DLPF -> sample rate),
+ *  GYRO/ACCEL_CONFIG, MOT_THR/MOT_DUR, INT_ENABLE, INT_STATUS,
+ *  the accel / gyro offset registers (added to every sample),
+ *  the data registers and the 1024 byte FIFO (USER_CTRL,
+ *  FIFO_EN, FIFO_COUNT, FIFO_R_W, overflow).
+ *
+ *  Slave devices (gy521_sim_slave_t) can hang on the auxiliary
+ *  bus: the I2C master (I2C_SLV0..4, EXT_SENS_DATA,
+ *  I2C_MST_STATUS) serves them once per sample, in bypass mode
+ *  (I2C_BYPASS_EN, master off) they answer on the main bus.
+ *
+ *  Bus faults can be injected (sim_bus.fault): NACKs, SDA
+ *  stuck low so that every transfer runs into bus.timeout_us
+ *  until the driver has recovered the bus (bus.recover) often
+ *  enough, or bit errors in read bytes above a maximum clock.
+ *  gy521_sim_brownout() resets a device's registers.
+ *
+ *  Time is virtual: it advances with gy521_sim_advance() and by
+ *  the duration of every bus transfer at sim_bus.baud.
+ *  New samples are produced at the configured sample rate.
+ *
+ *  gy521_sim_flash_t stands in for the RP2040 flash behind a
+ *  gy521_flash_t: NOR semantics (erase to 0xFF, programming only
+ *  clears bits), erase counts per sector, power cuts mid-write.
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521_types.h"
+#include "gy521_bus.h"
+#include "gy521_flash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GY521_SIM_MAX_DEVICES
+#define GY521_SIM_MAX_DEVICES 4 // Devices per simulated bus
+#endif
+
+#ifndef GY521_SIM_HANG_US
+#define GY521_SIM_HANG_US 1000000 // Stuck transfer with timeout_us = 0: gives up here instead of never
+#endif
+
+#ifndef GY521_SIM_FLIP_EVERY
+#define GY521_SIM_FLIP_EVERY 64 // Above fault.max_baud one read byte in this many has a bit flipped
+#endif
+
+#ifndef GY521_SIM_FLASH_SECTORS
+#define GY521_SIM_FLASH_SECTORS 64 // Largest stand-in flash (erase counters)
+#endif
+
+#define GY521_SIM_RESET_US 100000 // DEVICE_RESET in progress (worst case): the device NACKs meanwhile
+#define GY521_SIM_FLASH_ERASE_US 45000 // Sector erase, typical QSPI NOR
+#define GY521_SIM_FLASH_PROGRAM_US 700 // Page program
+
+#ifndef GY521_SIM_MAX_AUX
+#define GY521_SIM_MAX_AUX 4 // Slaves per auxiliary bus
+#endif
+
+/*
+ * Sample source: fills sample number 'index'.
+ * Default source: accel.x/y = index low/high word, accel.z = 1 g,
+ * temp = 0 (36.53 °C), gyro = 0.
+ */
+typedef void (*gy521_sim_source_fn)(void *user, uint32_t index, gy521_sample_t *out);
+
+/*
+ * Generic slave on the auxiliary bus: 256 byte register file with
+ * auto increment. 'update' (optional) refreshes its registers for
+ * sample number 'index' before the master reads it.
+ */
+typedef struct gy521_sim_slave_s gy521_sim_slave_t;
+struct gy521_sim_slave_s{
+	uint8_t addr; // 7 bit I2C address
+	uint8_t reg[256];
+	uint8_t ptr; // Register pointer
+
+	void (*update)(void *user, uint32_t index, gy521_sim_slave_t *slave);
+	void *user;
+
+	struct{
+		uint32_t reads, writes; // Bytes transferred
+	} stat;
+};
+
+typedef struct gy521_sim_s{
+	uint8_t addr; // I2C address (0x68 / 0x69)
+	uint8_t reg[128]; // Register file
+	uint8_t ptr; // Register pointer
+
+	uint8_t fifo[1024];
+	uint16_t fifo_head; // Oldest byte
+	uint16_t fifo_count; // Bytes queued
+
+	uint64_t next_sample_ns; // Virtual time of the next sample
+	uint64_t reset_until_ns; // DEVICE_RESET busy: every transfer NACKed until then
+	uint32_t index; // Samples produced so far
+
+	gy521_sim_source_fn source; // NULL = default pattern
+	void *source_user;
+
+	void (*int_line)(void *user); // Pulse on INT (DATA_RDY_EN, or MOT_EN on motion)
+	void *int_user;
+
+	gy521_axis_raw_t last_accel; // Motion detection reference
+	uint8_t motion_count; // Consecutive samples above MOT_THR
+
+	gy521_sim_slave_t *aux[GY521_SIM_MAX_AUX]; // Auxiliary bus
+	uint8_t aux_count;
+
+	struct{
+		uint32_t samples; // Samples produced
+		uint32_t fifo_overflows; // Samples that pushed out old FIFO data
+	} stat;
+} gy521_sim_t;
+
+typedef struct{
+	uint64_t now_ns; // Virtual time
+	uint32_t baud; // Bus clock for transfer time, 0 = transfers take no time
+	gy521_sim_t *devices[GY521_SIM_MAX_DEVICES];
+	uint8_t count;
+	gy521_bus_t *bus; // Transport set up by gy521_sim_bus_init() (timeout_us)
+
+	struct{
+		uint32_t nack; // NACK the next n transfers
+		uint32_t stuck; // SDA held low: transfers time out until this many recoveries ran
+		uint32_t max_baud; // Fastest clock the wiring carries cleanly (0 = any)
+	} fault;
+
+	struct{
+		uint32_t timeouts; // Transfers that ran into the timeout (or GY521_SIM_HANG_US)
+		uint32_t recoveries; // Recovery sequences clocked out
+		uint32_t bytes_read; // Bytes the masters read
+		uint32_t flipped; // Of these, corrupted above fault.max_baud
+	} stat;
+} gy521_sim_bus_t;
+
+typedef struct{
+	uint8_t *mem; // Flash contents
+	uint32_t size; // Bytes, whole sectors
+	gy521_sim_bus_t *clock; // Erase / program take simulated time here (NULL = none)
+	uint32_t erases[GY521_SIM_FLASH_SECTORS]; // Per sector (wear)
+
+	struct{
+		uint32_t cut; // Power lost at the n-th byte erased / programmed from now (0 = never)
+		bool off; // Power is gone: every operation fails until cleared
+	} fault;
+
+	struct{
+		uint32_t erases, programs;
+		uint32_t misaligned; // Operations rejected like the hardware would
+	} stat;
+} gy521_sim_flash_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+void gy521_sim_init(gy521_sim_t *sim, uint8_t addr); // Power-up state
+void gy521_sim_brownout(gy521_sim_t *sim); // Registers + FIFO back to power-up, source and slaves stay
+
+/*
+ * gy521_sim_bus_init();
+ * Prepares a simulated bus (400 kHz) and the transport 'bus' for it
+ * (timeout_us = GY521_BUS_TIMEOUT_US, recover = 9 SCL pulses + STOP,
+ * set_baud = any clock).
+ */
+void gy521_sim_bus_init(gy521_sim_bus_t *sim_bus, gy521_bus_t *bus);
+bool gy521_sim_attach(gy521_sim_bus_t *sim_bus, gy521_sim_t *sim);
+
+void gy521_sim_slave_init(gy521_sim_slave_t *slave, uint8_t addr); // All registers 0
+bool gy521_sim_aux_attach(gy521_sim_t *sim, gy521_sim_slave_t *slave); // Hang on the auxiliary bus
+
+void gy521_sim_advance(gy521_sim_bus_t *sim_bus, uint64_t us); // Let time pass
+uint32_t gy521_sim_sample_period_us(const gy521_sim_t *sim); // From SMPLRT_DIV + DLPF_CFG
+
+/*
+ * gy521_sim_flash_init();
+ * Erased stand-in over 'mem' (size bytes, whole sectors) and the
+ * transport 'flash' for all of it (offset 0).
+ */
+bool gy521_sim_flash_init(gy521_sim_flash_t *sim_flash, gy521_flash_t *flash, uint8_t *mem, uint32_t size);
+
+// Clock hooks matching gy521_host_clock(), ctx = gy521_sim_bus_t *
+uint64_t gy521_sim_now(void *sim_bus);
+void gy521_sim_sleep(void *sim_bus, uint64_t us);
+
+#ifdef __cplusplus
+}
+#endif
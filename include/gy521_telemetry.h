@@ -0,0 +1,68 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_telemetry.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Compact binary telemetry frames (instead of printf over USB).
+ *
+ *  Frame, 24 bytes, little endian:
+ *    0  sync     0xA5 0x5A
+ *    2  seq      uint16, sample sequence number (low 16 bits)
+ *    4  time     uint32, timestamp in µs (low 32 bits)
+ *    8  raw      int16 ax ay az temp gx gy gz
+ *   22  crc      uint16, CRC-16/CCITT-FALSE over bytes 2..21
+ *
+ *  The decoder takes one byte at a time, resynchronizes on the
+ *  sync word + CRC, unwraps seq / time and reports lost frames.
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521_types.h"
+
+#define GY521_TELEMETRY_FRAME_SIZE 24
+#define GY521_TELEMETRY_SYNC0 0xA5
+#define GY521_TELEMETRY_SYNC1 0x5A
+
+typedef struct{
+	uint8_t buf[GY521_TELEMETRY_FRAME_SIZE];
+	uint8_t len; // Bytes collected for the current frame
+
+	uint32_t seq; // Unwrapped seq of the last frame
+	uint64_t timestamp_us; // Unwrapped time of the last frame
+	bool started;
+	uint32_t gap; // Frames lost right before the last decoded frame
+
+	struct{
+		uint32_t frames; // Valid frames
+		uint32_t lost; // Missing sequence numbers
+		uint32_t crc_errors;
+		uint32_t skipped; // Bytes dropped while searching for sync
+	} stat;
+} gy521_telemetry_decoder_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+uint16_t gy521_telemetry_crc16(const uint8_t *data, uint16_t len);
+
+// Writes one frame (GY521_TELEMETRY_FRAME_SIZE bytes) to 'out', returns its size
+uint8_t gy521_telemetry_encode(uint8_t *out, const gy521_frame_t *frame);
+
+void gy521_telemetry_decoder_init(gy521_telemetry_decoder_t *d);
+
+/*
+ * gy521_telemetry_decode();
+ * Feeds one byte. Returns true when it completes a valid frame,
+ * written to 'out' with seq / timestamp unwrapped (d->gap = frames
+ * lost right before it).
+ */
+bool gy521_telemetry_decode(gy521_telemetry_decoder_t *d, uint8_t byte, gy521_frame_t *out);
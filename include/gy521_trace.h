@@ -0,0 +1,156 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_trace.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Record and replay of bus transfers.
+ *
+ *  Record: gy521_trace_rec_t wraps a transport, every transfer
+ *  goes through to it and is appended to a trace (sink callback:
+ *  USB, flash, RAM buffer, file).
+ *  Replay: gy521_trace_play_t is a transport answering from a
+ *  trace, so the unmodified driver (fn.read(), scaling, FIFO,
+ *  ...) runs against captured data on the host. Its clock
+ *  (gy521_trace_now / _sleep for gy521_host_clock()) is the
+ *  recorded time.
+ *
+ *  Trace, little endian:
+ *    header  "GY5T", version, 3 reserved bytes
+ *    record  flags   bit 0 read, bit 1 nostop, bit 2 failed
+ *            addr    7 bit I2C address
+ *            dt      varint, µs since the previous record's
+ *                    start (first record: since boot)
+ *            len     varint, bytes requested
+ *            data    len bytes written / read,
+ *                    or failed: zigzag varint return value
+ *  varint = 7 bits per byte, low first, bit 7 = more follows.
+ *  A register read is 2 records (register address, data),
+ *  ~24 bytes per 14 byte sample at 1 kHz.
+ *
+ *  Replay matches, it does not require the same call sequence:
+ *  a read is answered by the next recorded read of the same
+ *  address, register and length (records in between are
+ *  skipped), writes are compared with the next record and
+ *  otherwise ignored. The DMA path (conf.async) bypasses the
+ *  transport and is not recorded.
+ *
+ *  Does not depend on the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gy521_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GY521_TRACE_VERSION 1
+#define GY521_TRACE_HEADER_SIZE 8
+
+#define GY521_TRACE_READ (1 << 0)
+#define GY521_TRACE_NOSTOP (1 << 1)
+#define GY521_TRACE_FAILED (1 << 2)
+
+/*
+ * One parsed record
+ */
+typedef struct{
+	uint8_t flags; // GY521_TRACE_*
+	uint8_t addr;
+	uint64_t time_us; // Start of the transfer
+	uint16_t len; // Bytes requested
+	int ret; // Transfer result (len, or < 0 / short when failed)
+	const uint8_t *data; // len bytes inside the trace, NULL when failed
+} gy521_trace_record_t;
+
+typedef void (*gy521_trace_sink_fn)(void *user, const uint8_t *data, size_t len);
+
+/*
+ * Recorder: hand 'bus' to gy521_init() instead of the traced one
+ */
+typedef struct{
+	gy521_bus_t bus; // Transport recording into the trace
+	gy521_bus_t *inner; // Traced transport
+	gy521_trace_sink_fn sink;
+	void *user;
+	uint64_t last_us; // Start of the previous record
+
+	struct{
+		uint32_t records;
+		uint32_t bytes; // Trace bytes incl. header
+	} stat;
+} gy521_trace_rec_t;
+
+/*
+ * Replay transport over a trace in memory
+ */
+typedef struct{
+	gy521_bus_t bus; // Hand to gy521_init()
+	const uint8_t *trace;
+	size_t size;
+	size_t pos; // Next record
+	uint64_t time_us; // Start of the record before pos (varint dt base)
+	uint64_t pos_us; // Start of the record at pos (= replay clock)
+	uint8_t rec_reg; // Register address the recording had set at pos
+	uint64_t slept_us; // gy521_trace_sleep() since the last consumed record
+	uint8_t reg; // Register address of the driver's last write
+
+	void (*pace)(void *user, uint64_t time_us); // Optional, before a record is used: real-time replay
+	void *pace_user;
+
+	struct{
+		uint32_t reads, writes; // Transfers answered
+		uint32_t skipped; // Records passed over to find a matching read
+		uint32_t mismatches; // Writes that differ from the next record
+		uint32_t misses; // Reads with no matching record left
+	} stat;
+} gy521_trace_play_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+/*
+ * gy521_trace_record();
+ * Sets up 'rec' around 'inner' (timeout, recovery and clock of
+ * 'inner' stay in use) and writes the header to 'sink'.
+ */
+void gy521_trace_record(gy521_trace_rec_t *rec, gy521_bus_t *inner, gy521_trace_sink_fn sink, void *user);
+
+/*
+ * gy521_trace_replay();
+ * Replays 'trace' (header included). false = no valid header.
+ */
+bool gy521_trace_replay(gy521_trace_play_t *play, const uint8_t *trace, size_t size);
+bool gy521_trace_done(const gy521_trace_play_t *play); // No record left
+
+// Clock hooks matching gy521_host_clock(), ctx = gy521_trace_play_t *
+uint64_t gy521_trace_now(void *play);
+void gy521_trace_sleep(void *play, uint64_t us);
+
+/*
+ * gy521_trace_next();
+ * Parses the record at *pos (after the header: pos = GY521_TRACE_HEADER_SIZE,
+ * *time_us = 0) and advances both. false at the end or on a damaged record.
+ */
+bool gy521_trace_next(const uint8_t *trace, size_t size, size_t *pos, uint64_t *time_us, gy521_trace_record_t *rec);
+
+/*
+ * gy521_trace_regs();
+ * Register values of device 'addr' as written up to its first
+ * read of register 'until' (e.g. ACCEL_XOUT_H: the configuration
+ * the samples were taken with). Registers never written stay
+ * as they are in 'regs'.
+ */
+void gy521_trace_regs(const uint8_t *trace, size_t size, uint8_t addr, uint8_t until, uint8_t regs[128]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_types.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Plain sample data types shared by the driver and the
+ *  SDK independent parts (ring buffer, host tools).
+ *  Must not include any pico-sdk header.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Raw axis values directly from registers
+ * Signed 16-bit values from sensor
+ */
+typedef struct{
+	int16_t x,y,z;
+} gy521_axis_raw_t;
+
+/*
+ * Axis offset as programmed into the
+ * offset registers by the calibrate functions
+ */
+typedef struct{
+	int32_t x, y, z;
+} gy521_offset_t;
+
+/*
+ * One decoded sample (e.g. a FIFO frame)
+ * Channels not enabled in the FIFO stay 0
+ */
+typedef struct{
+	gy521_axis_raw_t accel;
+	int16_t temp;
+	gy521_axis_raw_t gyro;
+} gy521_sample_t;
+
+/*
+ * Scaled axis values
+ * - Accel: g-force
+ * - Gyro: degrees per second
+ */
+typedef struct{
+	float x,y,z;
+} gy521_axis_scaled_t;
+
+/*
+ * Fixed-point axis values (no FPU needed)
+ * - Accel: milli-g
+ * - Gyro: milli-degrees per second
+ */
+typedef struct{
+	int32_t x,y,z;
+} gy521_axis_fixed_t;
+
+/*
+ * Timestamped sample as queued by the acquisition engine
+ */
+typedef struct{
+	uint64_t timestamp_us; // Data-ready (or read start) time
+	uint32_t seq; // Sample sequence number
+	gy521_sample_t sample;
+} gy521_frame_t;
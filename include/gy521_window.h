@@ -0,0 +1,133 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_window.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Windowed statistics and decimation of the sample stream, for
+ *  consumers that do not need every sample.
+ *
+ *  Statistics: per window of conf.window input samples, mean,
+ *  variance, min, max and RMS of each accel and gyro axis, in raw
+ *  LSB (scale like v.*.raw). 64 bit sum / sum of squares: exact
+ *  for every window length up to 65535 samples.
+ *
+ *  Decimation (conf.filter), every conf.ratio input samples one
+ *  filtered sample out:
+ *  - GY521_DECIM_PICK    every ratio-th sample, no filter (aliases)
+ *  - GY521_DECIM_BOXCAR  mean of the ratio samples
+ *  - GY521_DECIM_CIC     CIC of conf.order stages (sinc^order,
+ *                        nulls at multiples of the output rate)
+ *  Integer only, 32 bit wrap-around accumulators, gain
+ *  ratio^order limited to 2^15 (e.g. ratio 32 at order 3).
+ *
+ *  Both run side by side on the same input. Does not depend on
+ *  the pico-sdk.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521.h"
+
+#define GY521_DECIM_PICK 0
+#define GY521_DECIM_BOXCAR 1
+#define GY521_DECIM_CIC 2
+
+#define GY521_CIC_ORDER_MAX 3
+#define GY521_CIC_GAIN_MAX 32768 // ratio^order
+
+// gy521_window_update() result bits
+#define GY521_WINDOW_STATS (1 << 0) // v.stats holds a new window
+#define GY521_WINDOW_DECIM (1 << 1) // v.sample holds a new decimated sample
+
+/*
+ * Statistics of one axis over a window, raw LSB
+ */
+typedef struct{
+	int16_t mean; // Rounded
+	int16_t min, max;
+	uint16_t rms; // Rounded
+	uint32_t var; // Population variance in LSB²
+} gy521_stat_t;
+
+typedef struct{
+	gy521_stat_t accel[3], gyro[3]; // x, y, z
+	uint16_t count; // Samples in the window
+	uint32_t seq; // Window number, from 1
+	uint64_t timestamp_us; // Timestamp of the window's first sample
+} gy521_window_stats_t;
+
+typedef struct{
+	// =====================
+	// === Configuration ===
+	// =====================
+	// Change, then call gy521_window_set()
+	struct{
+		uint16_t window; // Samples per statistics window, 0 = off
+		uint8_t filter; // GY521_DECIM_*
+		uint8_t ratio; // Input samples per decimated sample, 0 = off
+		uint8_t order; // CIC stages, 1..GY521_CIC_ORDER_MAX
+	} conf;
+
+	// ==============
+	// === Output ===
+	// ==============
+	struct{
+		gy521_window_stats_t stats; // Last completed window
+		gy521_frame_t sample; // Last decimated sample, timestamp of its last input, seq from 1
+		uint32_t windows, decimated;
+	} v;
+
+	// ======================
+	// === Internal state ===
+	// ======================
+	struct{
+		int64_t sum[6];
+		uint64_t sumsq[6];
+		int16_t min[6], max[6];
+		uint16_t count;
+		uint64_t first_us;
+
+		uint32_t integ[GY521_CIC_ORDER_MAX][7]; // Boxcar: sum in integ[0]
+		uint32_t comb[GY521_CIC_ORDER_MAX][7]; // Comb delay line (CIC)
+		uint8_t phase; // Input samples into the current decimated one
+		uint8_t settle; // CIC outputs still to drop after a reset
+		uint32_t gain; // ratio^order
+	} priv;
+} gy521_window_t;
+
+// ============================
+// === Function declaration ===
+// ============================
+/*
+ * gy521_window_init();
+ * Statistics over 'window' samples and decimation by 'ratio'
+ * with 'filter' (CIC: order 3).
+ */
+bool gy521_window_init(gy521_window_t *w, uint16_t window, uint8_t filter, uint8_t ratio);
+
+/*
+ * gy521_window_set();
+ * Applies conf and restarts both stages. false = ratio^order above
+ * GY521_CIC_GAIN_MAX or an unknown filter / order.
+ */
+bool gy521_window_set(gy521_window_t *w);
+void gy521_window_reset(gy521_window_t *w); // Drops partial windows, keeps conf
+
+/*
+ * gy521_window_update();
+ * Feeds the sample in dev->v after fn.read(dev, GY521_ALL).
+ * Returns GY521_WINDOW_* bits for what completed.
+ */
+uint8_t gy521_window_update(gy521_window_t *w, const gy521_s *dev);
+
+/*
+ * gy521_window_update_sample();
+ * Same for one sample (FIFO, ring buffer, replay).
+ */
+uint8_t gy521_window_update_sample(gy521_window_t *w, const gy521_sample_t *s, uint64_t timestamp_us);
@@ -12,12 +12,21 @@
  *  based on the MPU-6050 6-axis IMU sensor.
  *
  *  This file implements:
- *  - I²C communication
- *  - Register-level configuration
+ *  - Register access through a pluggable I²C transport (gy521_bus_t)
+ *  - Register-level configuration (shadowed, batched commit)
  *  - Sensor data acquisition
- *  - Automatic scaling (raw -> physical units)
- *  - Gyroscope zero-point calibration
- *  - Power management features
+ *  - Automatic scaling (raw -> physical units, float or fixed-point)
+ *  - Fast accel / gyro calibration into the hardware offset registers
+ *  - Power management features (low-power cycle mode, wake-on-motion)
+ *  - FIFO burst streaming
+ *  - Auxiliary I²C master (external sensor in the same burst) / bypass
+ *  - Data-ready interrupt sampling
+ *  - Bus recovery after repeated transfer failures (timeouts)
+ *  - Bus clock per transport + self-test for the fastest reliable one
+ *  - Optional transfer counters + latency histograms (GY521_INSTRUMENT)
+ *
+ *  Platform independent: everything that needs the pico-sdk
+ *  lives in gy521_pico.c (host builds: gy521_host.c).
  *
  *  The driver is written in a lightweight embedded style
  *  and uses function pointers inside a device structure
@@ -25,351 +34,1376 @@
  *
  * ================================================================
  */
-#include "pico/stdlib.h"
-#include "hardware/i2c.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include "gy521.h"
+#include "gy521_regs.h"
+#include "gy521_port.h"
+#include "gy521_scale.h"
 
-// ==========================================
-// === GY521(MPU-6050) register addresses ===
-// ==========================================
-#define GY521_REG_ACCEL_XOUT_H 0x3B
-#define GY521_REG_ACCEL_CONFIG 0x1c
-#define GY521_REG_TEMP_OUT_H 0x41
-#define GY521_REG_GYRO_XOUT_H  0x43
-#define GY521_REG_GYRO_CONFIG 0x1b
-#define GY521_REG_SIGNAL_PATH_RESET 0x68
-#define GY521_REG_USER_CTRL 0x6A
-#define GY521_REG_PWR_MGMT_1 0x6B
-#define GY521_REG_PWR_MGMT_2 0x6C
-#define GY521_REG_WHO_AM_I 0x75
-
-// =============================================
-// === Bitmasks for reset, FIFO, sleep, etc. ===
-// =============================================
-#define GY521_GYRO_RESET (1 << 2)
-#define GY521_ACCEL_RESET (1 << 1)
-#define GY521_TEMP_RESET 0x01
-
-#define GY521_FIFO_EN (1 << 6)
-#define GY521_I2C_MST_EN (1 << 5)
-#define GY521_I2C_IF_DIS (1 << 4)
-#define GY521_FIFO_RESET (1 << 2)
-#define GY521_I2C_MST_RESET (1 << 1)
-#define GY521_SIG_COND_RESET 0x01
-
-#define GY521_DEVICE_RESET (1 << 7)
-#define GY521_SLEEP (1 << 6) // Sleep mode enable/disable
-#define GY521_CYCLE (1 << 5)
-#define GY521_TEMP_DIS (1 << 3)
-
-#define GY521_STBY_XA (1 << 5)
-#define GY521_STBY_YA (1 << 4)
-#define GY521_STBY_ZA (1 << 3)
-#define GY521_STBY_XG (1 << 2)
-#define GY521_STBY_YG (1 << 1)
-#define GY521_STBY_ZG 0x01
-
-// ===========================
-// === Function prototypes ===
-// ===========================
-bool gy521_test_connection(void);
-bool gy521_read_reg(uint8_t reg, uint8_t *out, uint8_t how_many);
-bool gy521_reset(void);
-bool gy521_sleep(void); // Set sleep configuration
-bool gy521_set_fsr(void);
-bool gy521_set_clksel(void);
-bool gy521_set_stby(void);
-bool gy521_calibrate_gyro(uint8_t sample); // calibrate gyro offsets (sample=10)
-bool gy521_read(uint8_t accel_temp_gyro); // 0=all 1=accel 2=temp 3=gyro
-
-// ========================
-// === Global Variables ===
-// ========================
-static gy521_s *g_gy521 = NULL; // Global pointer to the aktiv GY521-Device
-static uint8_t g_gy521_cache[14] = {0}; // Temporary buffer for I2C reads
-static int g_gy521_ret_cache = 0; // Temporary buffer for return values
-
-// =========================
-// === Set device to use ===
-// =========================
-// to set device as used device for fn.*
-bool gy521_use(gy521_s *device){
-	if (device == NULL) return false; // Check if device is set
-
-	g_gy521 = device;
-
-	return true;
-}
+// ====================================
+// === Fixed-point scaling (Q16.16) ===
+// ====================================
+// Reciprocal multipliers (gy521_scale.h), gyro per FSR = bits 4:3
+static const int32_t g_gy521_gyro_mdps_q16[4] = {500275, 1000550, 2001099, 4002198}; // Rounded per FSR
 
 // ========================
 // === Initialize GY521 ===
 // ========================
-gy521_s gy521_init(uint8_t addr){
-	i2c_init(GY521_I2C_PORT, 400 * 1000); // 400 kHz I2C
-	gpio_set_function(GY521_SDA_PIN, GPIO_FUNC_I2C);
-	gpio_set_function(GY521_SCL_PIN, GPIO_FUNC_I2C);
-
-#if GY521_USE_PULLUP
-	gpio_pull_up(GY521_SDA_PIN);
-	gpio_pull_up(GY521_SCL_PIN);
-#endif
-
-	// Configure optional interrupt pin
-	if (GY521_INT_PIN >= 0){
-		gpio_init(GY521_INT_PIN);
-		gpio_set_dir(GY521_INT_PIN, GPIO_IN);
-	}
-
+gy521_s gy521_init(gy521_bus_t *bus, uint8_t addr){
 	gy521_s gy521 = {0}; // Initalize device struct and function pointers
 
 	if(!addr) gy521.conf.addr = GY521_I2C_ADDR_GND;
 	else gy521.conf.addr = addr;
+	gy521.conf.bus = bus ? bus : gy521_port_default_bus();
+	gy521.conf.int_pin = GY521_INT_PIN;
 
-	gy521.conf.accel.fsr_divider = 131.0f;
-	gy521.conf.gyro.fsr_divider = 16384.0f;
+	gy521.conf.accel.fsr_divider = 16384.0f; // ±2 g after power-up
+	gy521.conf.gyro.fsr_divider = 131.0f; // ±250 °/s after power-up
+	gy521.conf.accel.fixed_mul = GY521_ACCEL_MG_Q16;
+	gy521.conf.gyro.fixed_mul = GY521_GYRO_MDPS_Q16;
 	gy521.conf.gyro.x.clksel = true;
+	gy521.conf.power.lp_wake = GY521_LP_WAKE_CTRL_5HZ;
+	gy521.conf.power.idle_ms = 2000;
+	gy521.conf.motion.threshold = 20; // 40 mg
+	gy521.conf.motion.duration = 1;
+	gy521.conf.aux.clk = GY521_AUX_CLK_400KHZ;
+	gy521.conf.recover.after = GY521_RECOVER_AFTER;
+	gy521.v.rate.period_us = 125; // 8 kHz after power-up (DLPF off, div 0)
+	gy521.v.rate.odr_mhz = 8000000;
+
+	gy521.priv.power_since = gy521_port_time_us();
+#if GY521_INSTRUMENT
+	gy521_instrument_reset(&gy521.inst);
+#endif
+
+	gy521.priv.dma_tx = -1;
+	gy521.priv.dma_rx = -1;
 
 	gy521.fn.reset = &gy521_reset;
 	gy521.fn.sleep = &gy521_sleep;
 	gy521.fn.test_connection = &gy521_test_connection;
 	gy521.fn.read = &gy521_read;
+	gy521.fn.read_mask = &gy521_read_mask;
+	gy521.fn.calibrate = &gy521_calibrate;
+	gy521.fn.accel.calibrate = &gy521_calibrate_accel;
 	gy521.fn.gyro.calibrate = &gy521_calibrate_gyro;
+	gy521.fn.offsets.get = &gy521_get_offsets;
+	gy521.fn.offsets.set = &gy521_set_offsets;
 	gy521.fn.fsr = &gy521_set_fsr;
 	gy521.fn.stby = &gy521_set_stby;
 	gy521.fn.clk_sel = &gy521_set_clksel;
-
-	g_gy521 = &gy521;
+	gy521.fn.rate = &gy521_set_rate;
+	gy521.fn.motion = &gy521_set_motion;
+	gy521.fn.power.set = &gy521_set_power;
+	gy521.fn.power.update = &gy521_power_update;
+	gy521.fn.fifo.set = &gy521_fifo_set;
+	gy521.fn.fifo.reset = &gy521_fifo_reset;
+	gy521.fn.fifo.read = &gy521_fifo_read;
+	gy521.fn.fifo.read_raw = &gy521_fifo_read_raw;
+	gy521.fn.async.poll = &gy521_async_poll;
+	gy521.fn.aux.set = &gy521_aux_set;
+	gy521.fn.aux.read = &gy521_aux_read;
+	gy521.fn.aux.write = &gy521_aux_write;
+	gy521.fn.interrupt = &gy521_set_interrupt;
+	gy521.fn.commit = &gy521_commit;
+	gy521.fn.recover = &gy521_recover;
 
 	return gy521;
 }
 
+// ==========================================
+// === Wait for a DMA transfer on the bus ===
+// ==========================================
+void gy521_bus_wait(gy521_bus_t *bus){
+	while(bus->owner && gy521_async_poll((gy521_s *)bus->owner));
+}
+
+// ========================
+// === Transfer Failure ===
+// ========================
+// A stuck SDA times every transfer out (bus->timeout_us): after
+// conf.recover.after failures in a row the bus is recovered.
+void gy521_bus_fault(gy521_s *dev, int ret){
+	gy521_bus_t *bus = dev->conf.bus;
+	bus->stat.errors++;
+	if(ret == GY521_BUS_TIMEOUT) bus->stat.timeouts++;
+
+	if(!dev->priv.outage){
+		dev->priv.outage = true;
+		dev->priv.fail_since = gy521_port_time_us();
+	}
+	if(dev->priv.failures < 255) dev->priv.failures++;
+	if(!dev->priv.recovering && dev->conf.recover.after && dev->priv.failures >= dev->conf.recover.after) gy521_recover(dev);
+}
+
+void gy521_bus_ok(gy521_s *dev){
+	dev->priv.failures = 0;
+	if(!dev->priv.recovering) dev->priv.outage = false;
+}
+
+// =======================
+// === Register Shadow ===
+// =======================
+// Configuration registers are cached in priv.shadow, so setters need
+// no read-modify-write and unchanged registers are never written.
+// Index into priv.shadow:
+enum{
+	GY521_SH_SMPLRT_DIV,
+	GY521_SH_CONFIG,
+	GY521_SH_GYRO_CONFIG,
+	GY521_SH_ACCEL_CONFIG,
+	GY521_SH_MOT_THR,
+	GY521_SH_MOT_DUR,
+	GY521_SH_INT_PIN_CFG,
+	GY521_SH_INT_ENABLE,
+	GY521_SH_PWR_MGMT_1,
+	GY521_SH_PWR_MGMT_2
+};
+
+// Ascending, adjacent addresses are written in one burst
+static const uint8_t g_gy521_shadow_reg[GY521_SHADOW_REGS] = {
+	GY521_REG_SMPLRT_DIV, GY521_REG_CONFIG, GY521_REG_GYRO_CONFIG, GY521_REG_ACCEL_CONFIG,
+	GY521_REG_MOT_THR, GY521_REG_MOT_DUR, GY521_REG_INT_PIN_CFG, GY521_REG_INT_ENABLE,
+	GY521_REG_PWR_MGMT_1, GY521_REG_PWR_MGMT_2
+};
+
+// Power-on values, the device starts in sleep mode
+static const uint8_t g_gy521_shadow_default[GY521_SHADOW_REGS] = {0, 0, 0, 0, 0, 0, 0, 0, GY521_SLEEP, 0};
+
+// Write-through: keep the shadow in step with every register write
+static void gy521_shadow_update(gy521_s *dev, uint8_t reg, const uint8_t *data, uint8_t how_many){
+	for(uint8_t i = 0; i < GY521_SHADOW_REGS; i++){
+		uint8_t off = (uint8_t)(g_gy521_shadow_reg[i] - reg); // Wraps above how_many if below reg
+		if(off < how_many) dev->priv.shadow[i] = data[off];
+	}
+}
+
+// Copy of the shadow, read from the device (one burst per run) if unknown
+static bool gy521_shadow_image(gy521_s *dev, uint8_t *image){
+	if(!dev) return false;
+	if(!dev->priv.shadow_valid){
+		for(uint8_t i = 0, n; i < GY521_SHADOW_REGS; i += n){
+			for(n = 1; i + n < GY521_SHADOW_REGS && g_gy521_shadow_reg[i + n] == g_gy521_shadow_reg[i] + n; n++);
+			if(!gy521_read_register(dev, g_gy521_shadow_reg[i], &dev->priv.shadow[i], n)) return false;
+		}
+		dev->priv.shadow_valid = true;
+	}
+
+	memcpy(image, dev->priv.shadow, GY521_SHADOW_REGS);
+	return true;
+}
+
+// Writes the registers where 'image' differs from the shadow. Changed
+// registers of one run go out as a single burst, unchanged ones in
+// between are rewritten with their shadow value (1 byte < 1 transaction).
+static bool gy521_shadow_apply(gy521_s *dev, const uint8_t *image){
+	for(uint8_t i = 0; i < GY521_SHADOW_REGS; i++){
+		if(image[i] == dev->priv.shadow[i]) continue;
+
+		uint8_t last = i;
+		for(uint8_t j = i + 1; j < GY521_SHADOW_REGS && g_gy521_shadow_reg[j] == g_gy521_shadow_reg[i] + (j - i); j++)
+			if(image[j] != dev->priv.shadow[j]) last = j;
+
+		if(!gy521_write_register(dev, g_gy521_shadow_reg[i], &image[i], last - i + 1)) return false;
+		i = last;
+	}
+	return true;
+}
+
+// =======================
+// === Instrumentation ===
+// =======================
+// Compile to nothing without GY521_INSTRUMENT
+static inline void gy521_inst_xfer(gy521_s *dev, bool read, int ret, uint16_t len){
+#if GY521_INSTRUMENT
+	gy521_instrument_xfer(&dev->inst, read, ret, len);
+#else
+	(void)dev; (void)read; (void)ret; (void)len;
+#endif
+}
+
+static inline uint64_t gy521_inst_now(void){
+#if GY521_INSTRUMENT
+	return gy521_port_time_us();
+#else
+	return 0;
+#endif
+}
+
+static inline void gy521_inst_sample(gy521_s *dev, const gy521_stamp_t *stamp, uint64_t start_us){
+#if GY521_INSTRUMENT
+	gy521_instrument_sample(&dev->inst, stamp->seq, stamp->timestamp_us, start_us, gy521_port_time_us(), dev->v.rate.period_us);
+#else
+	(void)dev; (void)stamp; (void)start_us;
+#endif
+}
+
 // =========================
 // === I2C Register Read ===
 // =========================
-bool gy521_read_register(uint8_t reg, uint8_t *out, uint8_t how_many){
-	if(!g_gy521) return false;
+bool gy521_read_register(gy521_s *dev, uint8_t reg, uint8_t *out, uint16_t how_many){
+	if(!dev || !dev->conf.bus) return false;
+	gy521_bus_t *bus = dev->conf.bus;
+	gy521_bus_wait(bus); // Bus may be owned by a DMA transfer
+
+	bus->stat.transactions++;
+	bus->stat.bytes += 1 + how_many;
+
+	int ret = bus->write(bus->ctx, dev->conf.addr, &reg, 1, true);
+	gy521_inst_xfer(dev, false, ret, 1);
+	if(ret != 1){
+		gy521_bus_fault(dev, ret);
+		return false;
+	}
+
+	ret = bus->read(bus->ctx, dev->conf.addr, out, how_many, false);
+	gy521_inst_xfer(dev, true, ret, how_many);
+	if(ret != how_many){
+		gy521_bus_fault(dev, ret);
+		return false;
+	}
 
-	uint8_t g_gy521_ret_cache = i2c_write_blocking(GY521_I2C_PORT, g_gy521->conf.addr, (uint8_t[]){reg}, 1, true);
-	if(g_gy521_ret_cache!= 1) return false;
+	gy521_bus_ok(dev);
+	return true;
+}
 
-	g_gy521_ret_cache = i2c_read_blocking(GY521_I2C_PORT, g_gy521->conf.addr, out, how_many, false);
-	if(g_gy521_ret_cache!= how_many) return false;
+// ==========================
+// === I2C Register Write ===
+// ==========================
+// Writes 'how_many' bytes starting at 'reg' (auto increment)
+bool gy521_write_register(gy521_s *dev, uint8_t reg, const uint8_t *data, uint8_t how_many){
+	if(!dev || !dev->conf.bus || how_many > 14) return false;
+	gy521_bus_t *bus = dev->conf.bus;
+	gy521_bus_wait(bus);
+
+	uint8_t buf[1 + 14];
+	buf[0] = reg;
+	for(uint8_t i = 0; i < how_many; i++) buf[1 + i] = data[i];
+
+	bus->stat.transactions++;
+	bus->stat.bytes += 1 + how_many;
+
+	int ret = bus->write(bus->ctx, dev->conf.addr, buf, 1 + how_many, false);
+	gy521_inst_xfer(dev, false, ret, 1 + how_many);
+	if(ret != 1 + how_many){
+		dev->priv.shadow_valid = false; // Unknown how much reached the device
+		gy521_bus_fault(dev, ret);
+		return false;
+	}
 
+	gy521_bus_ok(dev);
+	gy521_shadow_update(dev, reg, data, how_many);
 	return true;
 }
 
 // =======================
 // === Test Connection ===
 // =======================
-bool gy521_test_connection(void){
+bool gy521_test_connection(gy521_s *dev){
 	uint8_t who_am_i;
-	if(!gy521_read_register(GY521_REG_WHO_AM_I, &who_am_i, 1)) return false;
+	if(!gy521_read_register(dev, GY521_REG_WHO_AM_I, &who_am_i, 1)) return false;
 	return who_am_i == 0x68 ? true : false;
 }
 
 // ==========================
 // === Reset GY521 device ===
 // ==========================
-bool gy521_reset(void){
-	if(!g_gy521) return false;
+bool gy521_reset(gy521_s *dev){
+	uint8_t reg = GY521_DEVICE_RESET; // All other bits return to their defaults anyway
+	if(!gy521_write_register(dev, GY521_REG_PWR_MGMT_1, &reg, 1)) return false;
+
+	// Device is back at its power-on values
+	memcpy(dev->priv.shadow, g_gy521_shadow_default, GY521_SHADOW_REGS);
+	dev->priv.shadow_valid = true;
+
+	// So are the offsets: gyro 0, accel the factory trim (read back once the
+	// reset is done, else left unknown so recovery / bias / flash read them)
+	memset(&dev->conf.gyro.offset, 0, sizeof(dev->conf.gyro.offset));
+	dev->priv.offsets_known = false;
+	gy521_port_sleep_ms(GY521_RESET_MS);
+	return gy521_get_offsets(dev);
+}
 
-	if(!gy521_read_register(GY521_REG_PWR_MGMT_1, g_gy521_cache, 1)) return false;
-	g_gy521_cache[0] |= GY521_DEVICE_RESET;
+// =====================================
+// === Configuration register values ===
+// =====================================
+// Each helper replaces the bits conf owns and keeps the rest of 'reg'
+static uint8_t gy521_bits_stby(const gy521_s *dev, uint8_t reg){
+	reg &= ~0x3f;
+	if(dev->conf.gyro.x.stby) reg |= GY521_STBY_XG;
+	if(dev->conf.gyro.y.stby) reg |= GY521_STBY_YG;
+	if(dev->conf.gyro.z.stby) reg |= GY521_STBY_ZG;
+
+	if(dev->conf.accel.x.stby) reg |= GY521_STBY_XA;
+	if(dev->conf.accel.y.stby) reg |= GY521_STBY_YA;
+	if(dev->conf.accel.z.stby) reg |= GY521_STBY_ZA;
+	return reg;
+}
 
-	g_gy521_ret_cache = i2c_write_blocking(GY521_I2C_PORT, g_gy521->conf.addr, (uint8_t[]){GY521_REG_PWR_MGMT_1, g_gy521_cache[0]}, 2, false);
-	if(g_gy521_ret_cache!= 2) return false;
+static uint8_t gy521_bits_clksel(gy521_s *dev, uint8_t reg){
+	if(dev->conf.gyro.x.clksel) dev->conf.clksel = GY521_CLKSEL_GYRO_X;
+	else if(dev->conf.gyro.y.clksel) dev->conf.clksel = GY521_CLKSEL_GYRO_Y;
+	else if (dev->conf.gyro.z.clksel) dev->conf.clksel = GY521_CLKSEL_GYRO_Z;
 
-	return true;
+	reg &= ~0x47; // clear sleep & CLK_SEL
+	return reg | dev->conf.clksel;
 }
 
-// ==========================================
-// === Set Standby in Register PWR_MGMT_2 ===
-// ==========================================
-bool gy521_set_stby(void){
-	if(!g_gy521) return false;
-	if(!gy521_read_register(GY521_REG_PWR_MGMT_2, g_gy521_cache, 1)) return false;
+static uint8_t gy521_bits_sleep(const gy521_s *dev, uint8_t reg){
+	// Sleep Bit
+	if(dev->conf.sleep) reg |= GY521_SLEEP;
+	else reg &= ~GY521_SLEEP;
 
-	g_gy521_cache[0] &= ~0x3f;
-	if(g_gy521->conf.gyro.x.stby) g_gy521_cache[0] |= GY521_STBY_XG;
-	if(g_gy521->conf.gyro.y.stby) g_gy521_cache[0] |= GY521_STBY_YG;
-	if(g_gy521->conf.gyro.z.stby) g_gy521_cache[0] |= GY521_STBY_ZG;
+	// Temperature disable Bit
+	if(dev->conf.temp.sleep) reg |= GY521_TEMP_DIS;
+	else reg &= ~GY521_TEMP_DIS;
+	return reg;
+}
 
-	if(g_gy521->conf.accel.x.stby) g_gy521_cache[0] |= GY521_STBY_XA;
-	if(g_gy521->conf.accel.y.stby) g_gy521_cache[0] |= GY521_STBY_YA;
-	if(g_gy521->conf.accel.z.stby) g_gy521_cache[0] |= GY521_STBY_ZA;
+// FSR bits 4:3 plus the matching scaling factors
+static void gy521_bits_fsr(gy521_s *dev, uint8_t *gyro_reg, uint8_t *accel_reg){
+	*gyro_reg = (*gyro_reg & ~0x18) | dev->conf.gyro.fsr;
+	*accel_reg = (*accel_reg & ~0x18) | dev->conf.accel.fsr;
 
-	g_gy521_ret_cache = i2c_write_blocking(GY521_I2C_PORT, g_gy521->conf.addr, (uint8_t[]){ GY521_REG_PWR_MGMT_2, g_gy521_cache[0]}, 2, false);
-	if(g_gy521_ret_cache!= 2) return false;
+	// Automatic scaling calculation:
+	// 131 / 2^bits → sensitivity in °/s
+	dev->conf.gyro.fsr_divider = 131.0f / (1 << ((dev->conf.gyro.fsr >> 3) & 0x03));
+	dev->conf.gyro.fixed_mul = g_gy521_gyro_mdps_q16[(dev->conf.gyro.fsr >> 3) & 0x03];
 
-	return true;
+	// Automatic scaling calculation (raw / divider = G)
+	dev->conf.accel.fsr_divider = 16384.0f / (1 << ((dev->conf.accel.fsr >> 3) & 0x03));
+	dev->conf.accel.fixed_mul = GY521_ACCEL_MG_Q16 << ((dev->conf.accel.fsr >> 3) & 0x03);
+}
+
+// Effective output data rate of conf.rate, or the wake-up rate in cycle mode
+static void gy521_rate_update(gy521_s *dev){
+	static const uint32_t lp_wake_us[4] = {800000, 200000, 50000, 25000}; // 1.25, 5, 20, 40 Hz
+
+	if(dev->conf.power.cycle){
+		dev->v.rate.period_us = lp_wake_us[(dev->conf.power.lp_wake >> 6) & 0x03];
+	}else{
+		// Gyro output rate 8 kHz without DLPF, else 1 kHz (accel is always 1 kHz)
+		uint32_t base_us = (dev->conf.rate.dlpf == 0 || dev->conf.rate.dlpf == 7) ? 125 : 1000;
+		dev->v.rate.period_us = base_us * (1u + dev->conf.rate.div);
+	}
+	dev->v.rate.odr_mhz = 1000000000u / dev->v.rate.period_us;
+}
+
+// SMPLRT_DIV + DLPF_CFG (EXT_SYNC_SET is kept) plus the resulting output data rate
+static void gy521_bits_rate(gy521_s *dev, uint8_t *div_reg, uint8_t *config_reg){
+	dev->conf.rate.dlpf &= 0x07;
+	*div_reg = dev->conf.rate.div;
+	*config_reg = (*config_reg & ~0x07) | dev->conf.rate.dlpf;
+
+	gy521_rate_update(dev);
+}
+
+// Cycle mode: accel only, woken at conf.power.lp_wake (overrides sleep, temp and gyro standby)
+static void gy521_bits_power(const gy521_s *dev, uint8_t *pwr1, uint8_t *pwr2){
+	*pwr2 &= ~GY521_LP_WAKE_MASK;
+	if(!dev->conf.power.cycle){
+		*pwr1 &= ~GY521_CYCLE;
+		return;
+	}
+
+	*pwr1 = (*pwr1 & ~GY521_SLEEP) | GY521_CYCLE | GY521_TEMP_DIS;
+	*pwr2 |= (dev->conf.power.lp_wake & GY521_LP_WAKE_MASK) | GY521_STBY_XG | GY521_STBY_YG | GY521_STBY_ZG;
+}
+
+// MOT_THR, MOT_DUR and the accel high-pass filter in front of the motion detector
+static void gy521_bits_motion(const gy521_s *dev, uint8_t *thr, uint8_t *dur, uint8_t *accel_reg){
+	*thr = dev->conf.motion.threshold;
+	*dur = dev->conf.motion.duration;
+	*accel_reg = (*accel_reg & ~0x07) | GY521_ACCEL_HPF_5HZ;
+}
+
+// INT pin: active high, push-pull, 50 us pulse (no INT_STATUS read needed).
+// While the auto policy cycles only motion raises INT, data-ready would fire at the wake-up rate.
+static void gy521_bits_interrupt(const gy521_s *dev, uint8_t *pin_cfg, uint8_t *enable){
+	bool cycling = dev->conf.power.cycle && dev->conf.power.auto_cycle;
+	*pin_cfg = (dev->conf.aux.bypass && !dev->conf.aux.enable) ? GY521_I2C_BYPASS_EN : 0x00;
+	*enable = 0x00;
+	if(dev->conf.interrupt.data_ready && !cycling) *enable |= GY521_DATA_RDY_EN;
+	if(dev->conf.interrupt.motion || cycling) *enable |= GY521_MOT_EN;
 }
 
 // ==========================================
-// === Set CLK_SEL in Register PWR_MGMT_1 ===
+// === Set Standby in Register PWR_MGMT_2 ===
 // ==========================================
-bool gy521_set_clksel(void){
-	if(!g_gy521) return false;
-	if(g_gy521->conf.gyro.x.clksel) g_gy521->conf.clksel = GY521_CLKSEL_GYRO_X;
-	else if(g_gy521->conf.gyro.y.clksel) g_gy521->conf.clksel = GY521_CLKSEL_GYRO_Y;
-	else if (g_gy521->conf.gyro.z.clksel) g_gy521->conf.clksel = GY521_CLKSEL_GYRO_Z;
+bool gy521_set_stby(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
 
-	if(!gy521_read_register(GY521_REG_PWR_MGMT_1, g_gy521_cache, 1)) return false;
-	g_gy521_cache[0] &= ~0x47; // clear sleep & CLK_SEL
-	g_gy521_cache[0] |= g_gy521->conf.clksel;
+	image[GY521_SH_PWR_MGMT_2] = gy521_bits_stby(dev, image[GY521_SH_PWR_MGMT_2]);
+	gy521_bits_power(dev, &image[GY521_SH_PWR_MGMT_1], &image[GY521_SH_PWR_MGMT_2]);
+	return gy521_shadow_apply(dev, image);
+}
 
-	g_gy521_ret_cache = i2c_write_blocking(GY521_I2C_PORT, g_gy521->conf.addr, (uint8_t[]){ GY521_REG_PWR_MGMT_1, g_gy521_cache[0]}, 2, false);
-	if(g_gy521_ret_cache!= 2) return false;
+// ==========================================
+// === Set CLK_SEL in Register PWR_MGMT_1 ===
+// ==========================================
+bool gy521_set_clksel(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
 
-	return true;
+	image[GY521_SH_PWR_MGMT_1] = gy521_bits_clksel(dev, image[GY521_SH_PWR_MGMT_1]);
+	gy521_bits_power(dev, &image[GY521_SH_PWR_MGMT_1], &image[GY521_SH_PWR_MGMT_2]);
+	return gy521_shadow_apply(dev, image);
 }
 
 // ==================
 // === Sleep Mode ===
 // ==================
-bool gy521_sleep(void){
-	if(!g_gy521) return false;
-	if(!gy521_read_register(GY521_REG_PWR_MGMT_1, g_gy521_cache, 1)) return false;
-
-	// Sleep Bit
-	if(g_gy521->conf.sleep) g_gy521_cache[0] |= GY521_SLEEP;
-	else g_gy521_cache[0] &= ~GY521_SLEEP;
-
-	// Temperature disable Bit
-	if(g_gy521->conf.temp.sleep) g_gy521_cache[0] |= GY521_TEMP_DIS;
-	else g_gy521_cache[0] &= ~GY521_TEMP_DIS;
+bool gy521_sleep(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
 
-	g_gy521_ret_cache = i2c_write_blocking(GY521_I2C_PORT, g_gy521->conf.addr, (uint8_t[]){GY521_REG_PWR_MGMT_1, g_gy521_cache[0]}, 2, false);
-	if(g_gy521_ret_cache != 2) return false;
-
-	return true;
+	image[GY521_SH_PWR_MGMT_1] = gy521_bits_sleep(dev, image[GY521_SH_PWR_MGMT_1]);
+	gy521_bits_power(dev, &image[GY521_SH_PWR_MGMT_1], &image[GY521_SH_PWR_MGMT_2]);
+	return gy521_shadow_apply(dev, image);
 }
 
 // ===================================
 // ===  Set Full-Scale Range (FSR) ===
 // === & Calculate Scaling Factors ===
 // ===================================
-bool gy521_set_fsr(void){
-	if(!g_gy521) return false;
-	// Read FSR Register
-	if(!gy521_read_register(GY521_REG_GYRO_CONFIG, g_gy521_cache, 2)) return false;
+bool gy521_set_fsr(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
 
-	// Gyro FSR bits
-	g_gy521_cache[0] &= ~0x18; // Delete bits 4:3
-	g_gy521_cache[0] |= g_gy521->conf.gyro.fsr; // Set FSR Bits
+	gy521_bits_fsr(dev, &image[GY521_SH_GYRO_CONFIG], &image[GY521_SH_ACCEL_CONFIG]);
+	return gy521_shadow_apply(dev, image); // One burst for 0x1B + 0x1C
+}
 
-	// Automatic scaling calculation:
-	// 131 / 2^bits → sensitivity in °/s
-	g_gy521->conf.gyro.fsr_divider = 131.0f / (1 << ((g_gy521->conf.gyro.fsr >> 3) & 0x03));
+// ==================================
+// === Sample Rate Divider & DLPF ===
+// ==================================
+bool gy521_set_rate(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
 
-	// Accel FSR bits
-	g_gy521_cache[1] &= ~0x18;
-	g_gy521_cache[1] |= g_gy521->conf.accel.fsr;
+	gy521_bits_rate(dev, &image[GY521_SH_SMPLRT_DIV], &image[GY521_SH_CONFIG]);
+	return gy521_shadow_apply(dev, image); // One burst for 0x19 + 0x1A
+}
 
-	// Automatic scaling calculation (raw / divider = G)
-	g_gy521->conf.accel.fsr_divider = 16384.0f / (1 << ((g_gy521->conf.accel.fsr >> 3) & 0x03));
+// ==============================
+// === Motion Detection Setup ===
+// ==============================
+bool gy521_set_motion(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
+
+	gy521_bits_motion(dev, &image[GY521_SH_MOT_THR], &image[GY521_SH_MOT_DUR], &image[GY521_SH_ACCEL_CONFIG]);
+	return gy521_shadow_apply(dev, image);
+}
+
+// ===========================================
+// === Low-power Cycle Mode (PWR_MGMT_1/2) ===
+// ===========================================
+// Book the time of the old mode once conf.power.cycle reached the device
+static void gy521_power_mode(gy521_s *dev){
+	uint64_t now = gy521_port_time_us();
+	dev->v.power.time_us[dev->v.power.mode] += now - dev->priv.power_since;
+	dev->priv.power_since = now;
+	dev->v.power.mode = dev->conf.power.cycle ? GY521_POWER_CYCLE : GY521_POWER_FULL;
+	gy521_rate_update(dev); // conf.rate.pace follows the wake-up rate
+}
+
+// Leaving cycle mode restores sleep, temp and standby from conf
+static bool gy521_power_apply(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
+
+	image[GY521_SH_PWR_MGMT_1] = gy521_bits_sleep(dev, image[GY521_SH_PWR_MGMT_1]);
+	image[GY521_SH_PWR_MGMT_2] = gy521_bits_stby(dev, image[GY521_SH_PWR_MGMT_2]);
+	gy521_bits_power(dev, &image[GY521_SH_PWR_MGMT_1], &image[GY521_SH_PWR_MGMT_2]);
+	gy521_bits_interrupt(dev, &image[GY521_SH_INT_PIN_CFG], &image[GY521_SH_INT_ENABLE]);
+	if(!gy521_shadow_apply(dev, image)) return false; // INT_ENABLE + one PWR_MGMT burst
 
-	// Write back to registers
-	 g_gy521_ret_cache = i2c_write_blocking(GY521_I2C_PORT, g_gy521->conf.addr, (uint8_t[]){GY521_REG_GYRO_CONFIG, g_gy521_cache[0], g_gy521_cache[1]}, 3, false);
-	if(g_gy521_ret_cache!= 3) return false;
+	gy521_power_mode(dev);
 
+	if(dev->conf.int_pin >= 0) gy521_port_interrupt(dev, image[GY521_SH_INT_ENABLE] != 0);
 	return true;
 }
 
-// ====================================================
-// === Calibrate gyro (determine zero-point offset) ===
-// ====================================================
-bool gy521_calibrate_gyro(uint8_t samples){
-	if(!g_gy521) return false;
-	gy521_axis_raw_t raw;
-	
-	int64_t sum_gx = 0;
-	int64_t sum_gy = 0;
-	int64_t sum_gz = 0;
+bool gy521_set_power(gy521_s *dev){
+	if(!dev) return false;
+	return gy521_power_apply(dev);
+}
 
-	for (uint8_t i = 0; i < samples; i++){
-		if(!gy521_read_register(GY521_REG_GYRO_XOUT_H, g_gy521_cache, 6)) return false;
+// =========================
+// === Auto Power Policy ===
+// =========================
+// Full rate: idle (no axis moved more than conf.motion.threshold) for
+// conf.power.idle_ms -> cycle mode. Cycle mode: motion interrupt -> full rate.
+// Without INT line (int_pin < 0) MOT_INT is polled in INT_STATUS.
+bool gy521_power_update(gy521_s *dev){
+	if(!dev) return false;
+
+	uint64_t now = gy521_port_time_us();
+	dev->v.power.time_us[dev->v.power.mode] += now - dev->priv.power_since;
+	dev->priv.power_since = now;
+	if(!dev->conf.power.auto_cycle) return true;
+
+	if(!dev->conf.power.cycle){
+		// MOT_THR (2 mg/LSB) in raw accel LSB at the current FSR
+		int32_t thr = (int32_t)dev->conf.motion.threshold * 2 * (16384 >> ((dev->conf.accel.fsr >> 3) & 0x03)) / 1000;
+		gy521_axis_raw_t *ref = &dev->priv.idle_ref, *a = &dev->v.accel.raw;
+		if(abs(a->x - ref->x) > thr || abs(a->y - ref->y) > thr || abs(a->z - ref->z) > thr || !dev->priv.last_motion_us){
+			*ref = *a;
+			dev->priv.last_motion_us = now;
+		}
+		if(now - dev->priv.last_motion_us < (uint64_t)dev->conf.power.idle_ms * 1000u) return true;
+
+		dev->conf.power.cycle = true;
+	}else{
+		bool motion = dev->priv.motion_pending;
+		if(!motion && dev->conf.int_pin < 0){
+			uint8_t status;
+			if(!gy521_read_register(dev, GY521_REG_INT_STATUS, &status, 1)) return false;
+			motion = status & GY521_MOT_INT;
+		}
+		if(!motion) return true;
 
-		raw.x = (g_gy521_cache[0]  << 8) | g_gy521_cache[1];
-		raw.y = (g_gy521_cache[2]  << 8) | g_gy521_cache[3];
-		raw.z = (g_gy521_cache[4]  << 8) | g_gy521_cache[5];
+		dev->conf.power.cycle = false;
+		dev->v.power.wakeups++;
+		dev->priv.last_motion_us = now;
+	}
 
-		sum_gx += raw.x;
-		sum_gy += raw.y;
-		sum_gz += raw.z;
+	dev->priv.motion_pending = false;
+	return gy521_power_apply(dev);
+}
 
-		sleep_ms(5); // small delay between measurements
+// ============================
+// === Commit Configuration ===
+// ============================
+// Builds every register from conf and writes only the changed ones:
+// set conf.* first, then one commit instead of sleep()/fsr()/clk_sel()/stby()/rate()/motion()/power.set()
+bool gy521_commit(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
+
+	gy521_bits_rate(dev, &image[GY521_SH_SMPLRT_DIV], &image[GY521_SH_CONFIG]);
+	gy521_bits_fsr(dev, &image[GY521_SH_GYRO_CONFIG], &image[GY521_SH_ACCEL_CONFIG]);
+	gy521_bits_motion(dev, &image[GY521_SH_MOT_THR], &image[GY521_SH_MOT_DUR], &image[GY521_SH_ACCEL_CONFIG]);
+	image[GY521_SH_PWR_MGMT_1] = gy521_bits_sleep(dev, gy521_bits_clksel(dev, image[GY521_SH_PWR_MGMT_1]));
+	image[GY521_SH_PWR_MGMT_2] = gy521_bits_stby(dev, image[GY521_SH_PWR_MGMT_2]);
+	gy521_bits_power(dev, &image[GY521_SH_PWR_MGMT_1], &image[GY521_SH_PWR_MGMT_2]);
+
+	if(!gy521_shadow_apply(dev, image)) return false;
+
+	gy521_power_mode(dev);
+	return true;
+}
+
+// =================================
+// === Hardware Offset Registers ===
+// =================================
+// Added to every sample inside the chip, so fn.read() needs no correction.
+// Gyro in ±1000 °/s LSB, accel in ±16 g LSB (bit 0 is reserved, always kept).
+bool gy521_get_offsets(gy521_s *dev){
+	if(!dev) return false;
+	uint8_t a[6], g[6];
+	if(!gy521_read_register(dev, GY521_REG_XA_OFFS_H, a, 6)) return false;
+	if(!gy521_read_register(dev, GY521_REG_XG_OFFS_USRH, g, 6)) return false;
+
+	int32_t *ao = &dev->conf.accel.offset.x, *go = &dev->conf.gyro.offset.x;
+	for(uint8_t i = 0; i < 3; i++){
+		ao[i] = (int16_t)((a[2 * i] << 8) | a[2 * i + 1]);
+		go[i] = (int16_t)((g[2 * i] << 8) | g[2 * i + 1]);
 	}
+	dev->priv.offsets_known = true;
+	return true;
+}
+
+static int16_t gy521_clamp16(int64_t v){
+	return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
 
-	// Store averages as offsets
-	g_gy521->conf.gyro.offset.x = sum_gx / samples;
-	g_gy521->conf.gyro.offset.y = sum_gy / samples;
-	g_gy521->conf.gyro.offset.z = sum_gz / samples;
+bool gy521_set_offsets(gy521_s *dev){
+	if(!dev) return false;
+	uint8_t a[6], g[6];
+	if(!gy521_read_register(dev, GY521_REG_XA_OFFS_H, a, 6)) return false;
+
+	const int32_t *ao = &dev->conf.accel.offset.x, *go = &dev->conf.gyro.offset.x;
+	for(uint8_t i = 0; i < 3; i++){
+		uint16_t av = (uint16_t)((gy521_clamp16(ao[i]) & ~1) | (a[2 * i + 1] & 1));
+		uint16_t gv = (uint16_t)gy521_clamp16(go[i]);
+		a[2 * i] = av >> 8;
+		a[2 * i + 1] = (uint8_t)av;
+		g[2 * i] = gv >> 8;
+		g[2 * i + 1] = (uint8_t)gv;
+	}
 
+	if(!gy521_write_register(dev, GY521_REG_XA_OFFS_H, a, 6)) return false;
+	if(!gy521_write_register(dev, GY521_REG_XG_OFFS_USRH, g, 6)) return false;
+	dev->priv.offsets_known = true;
 	return true;
 }
 
-// ===========================================
-// === Read Sensor Data + Optional Scaling ===
-// ===========================================
-bool gy521_read(uint8_t accel_temp_gyro){
-	if(!g_gy521) return false;
+// Signed division, rounded to nearest
+static int64_t gy521_div_round(int64_t num, int64_t den){
+	return (num < 0) ? (num - den / 2) / den : (num + den / 2) / den;
+}
+
+// ============================================
+// === Calibrate (program offset registers) ===
+// ============================================
+// Averages 'samples' frames streamed through the FIFO at 2 kHz (DLPF off,
+// 12 byte frames fit a 400 kHz bus), so 1024 samples take ~0.5 s.
+// Slower buses stream slower (100 kHz: 615 Hz, ~1.7 s), see gy521_calibrate_div().
+// The data already contains the current offsets: the residual is added
+// to them. Accel: the axis closest to ±1 g is the gravity axis and keeps
+// its 1 g. Rate and FIFO conf are restored afterwards (FIFO contents lost).
+// Sample rate divider for calibration: 2 kHz, or slower so the frames
+// take at most ~2/3 of the bus (12 bytes * 9 bits = 108 bits per frame)
+static uint8_t gy521_calibrate_div(const gy521_s *dev){
+	const uint32_t baud = dev->conf.bus ? dev->conf.bus->baud : 0;
+	if(!baud) return 3; // Unknown clock: assume 400 kHz
+
+	const uint32_t div = (8000u * 162u + baud - 1) / baud; // 1 + div = 8 kHz / max. frame rate
+	return div <= 4 ? 3 : div > 256 ? 255 : (uint8_t)(div - 1);
+}
+
+static bool gy521_calibrate_run(gy521_s *dev, uint16_t samples, bool accel, bool gyro){
+	if(!dev || !samples || dev->conf.sleep || dev->v.power.mode == GY521_POWER_CYCLE) return false;
+	if(!gy521_get_offsets(dev)) return false;
+
+	const uint8_t rate_div = dev->conf.rate.div, rate_dlpf = dev->conf.rate.dlpf;
+	const bool fifo_enable = dev->conf.fifo.enable, fifo_accel = dev->conf.fifo.accel;
+	const bool fifo_temp = dev->conf.fifo.temp, fifo_gyro = dev->conf.fifo.gyro;
+
+	dev->conf.rate.div = gy521_calibrate_div(dev); // 8 kHz / (1 + div)
+	dev->conf.rate.dlpf = GY521_DLPF_260HZ;
+	dev->conf.fifo.enable = dev->conf.fifo.accel = dev->conf.fifo.gyro = true;
+	dev->conf.fifo.temp = false;
+
+	int64_t sum[6] = {0};
+	uint16_t got = 0, skip = GY521_CALIBRATE_SETTLE;
+	bool ok = gy521_set_rate(dev) && gy521_fifo_set(dev);
+
+	// Twice the nominal time before giving up
+	const uint32_t period_us = 125u * (1u + dev->conf.rate.div);
+	const uint64_t deadline = gy521_port_time_us() + (uint64_t)(samples + skip) * 2u * period_us + 100000u;
+	gy521_sample_t buf[GY521_FIFO_BURST_FRAMES];
+
+	while(ok && got < samples){
+		uint16_t n = gy521_fifo_read(dev, buf, GY521_FIFO_BURST_FRAMES);
+		for(uint16_t i = 0; i < n && got < samples; i++){
+			if(skip){
+				skip--;
+				continue;
+			}
+			const int16_t *a = &buf[i].accel.x, *g = &buf[i].gyro.x;
+			for(uint8_t k = 0; k < 3; k++){
+				sum[k] += a[k];
+				sum[3 + k] += g[k];
+			}
+			got++;
+		}
+
+		if(gy521_port_time_us() > deadline) ok = false;
+		else if(n < GY521_FIFO_BURST_FRAMES) gy521_port_sleep_ms(GY521_FIFO_BURST_FRAMES * period_us / 1000u); // One burst
+	}
+
+	dev->conf.rate.div = rate_div;
+	dev->conf.rate.dlpf = rate_dlpf;
+	dev->conf.fifo.enable = fifo_enable;
+	dev->conf.fifo.accel = fifo_accel;
+	dev->conf.fifo.temp = fifo_temp;
+	dev->conf.fifo.gyro = fifo_gyro;
+	if(!gy521_set_rate(dev) || !gy521_fifo_set(dev) || !ok) return false;
+
+	// Sensor LSB -> offset LSB: gyro 2^fs / 4, accel 2^fs / 8
+	const uint8_t accel_fs = (dev->conf.accel.fsr >> 3) & 0x03;
+	const uint8_t gyro_fs = (dev->conf.gyro.fsr >> 3) & 0x03;
+
+	if(gyro){
+		int32_t *go = &dev->conf.gyro.offset.x;
+		for(uint8_t k = 0; k < 3; k++)
+			go[k] -= gy521_div_round(sum[3 + k] * (1 << gyro_fs), 4 * (int64_t)samples);
+	}
+
+	if(accel){
+		int32_t *ao = &dev->conf.accel.offset.x;
+		uint8_t up = 0;
+		for(uint8_t k = 1; k < 3; k++)
+			if(llabs(sum[k]) > llabs(sum[up])) up = k;
+
+		const int64_t one_g = (int64_t)(16384 >> accel_fs) * samples;
+		sum[up] -= sum[up] < 0 ? -one_g : one_g;
+		for(uint8_t k = 0; k < 3; k++)
+			ao[k] -= gy521_div_round(sum[k] * (1 << accel_fs), 8 * (int64_t)samples);
+	}
+
+	return gy521_set_offsets(dev);
+}
+
+bool gy521_calibrate(gy521_s *dev, uint16_t samples){
+	return gy521_calibrate_run(dev, samples, true, true);
+}
+
+bool gy521_calibrate_accel(gy521_s *dev, uint16_t samples){
+	return gy521_calibrate_run(dev, samples, true, false);
+}
+
+bool gy521_calibrate_gyro(gy521_s *dev, uint16_t samples){
+	return gy521_calibrate_run(dev, samples, false, true);
+}
+
+// ===================================
+// === Register span per read mode ===
+// ===================================
+// First register and byte count for accel_temp_gyro 0..3
+const uint8_t gy521_span_reg[4] = {GY521_REG_ACCEL_XOUT_H, GY521_REG_ACCEL_XOUT_H, GY521_REG_TEMP_OUT_H, GY521_REG_GYRO_XOUT_H};
+const uint8_t gy521_span_len[4] = {14, 6, 2, 6};
+
+// EXT_SENS_DATA follows GYRO_ZOUT_L: the span is extended up to its end
+uint8_t gy521_span_bytes(const gy521_s *dev, uint8_t accel_temp_gyro){
+	if(!dev->conf.aux.ext_len) return gy521_span_len[accel_temp_gyro];
+	return GY521_REG_EXT_SENS_DATA_00 - gy521_span_reg[accel_temp_gyro] + dev->conf.aux.ext_len;
+}
+
+// =============================================
+// === Decode Sensor Data + Optional Scaling ===
+// =============================================
+void gy521_decode(gy521_s *dev, uint8_t accel_temp_gyro, const uint8_t *buf){
 	// Read all sensors
 	if(accel_temp_gyro == 0){
-		if(!gy521_read_register(GY521_REG_ACCEL_XOUT_H, g_gy521_cache, 14)) return false;
-
-		g_gy521->v.accel.raw.x = (g_gy521_cache[0]  << 8) | g_gy521_cache[1];
-		g_gy521->v.accel.raw.y = (g_gy521_cache[2]  << 8) | g_gy521_cache[3];
-		g_gy521->v.accel.raw.z = (g_gy521_cache[4]  << 8) | g_gy521_cache[5];
-		g_gy521->v.temp.raw = (g_gy521_cache[6]  << 8) | g_gy521_cache[7];
-		g_gy521->v.gyro.raw.x = (g_gy521_cache[8]  << 8) | g_gy521_cache[9];
-		g_gy521->v.gyro.raw.y = (g_gy521_cache[10] << 8) | g_gy521_cache[11];
-		g_gy521->v.gyro.raw.z = (g_gy521_cache[12] << 8) | g_gy521_cache[13];
+		dev->v.accel.raw.x = (buf[0]  << 8) | buf[1];
+		dev->v.accel.raw.y = (buf[2]  << 8) | buf[3];
+		dev->v.accel.raw.z = (buf[4]  << 8) | buf[5];
+		dev->v.temp.raw = (buf[6]  << 8) | buf[7];
+		dev->v.gyro.raw.x = (buf[8]  << 8) | buf[9];
+		dev->v.gyro.raw.y = (buf[10] << 8) | buf[11];
+		dev->v.gyro.raw.z = (buf[12] << 8) | buf[13];
 
 	// Only accelerometer
 	}else if(accel_temp_gyro == 1){
-		if(!gy521_read_register(GY521_REG_ACCEL_XOUT_H, g_gy521_cache, 6)) return false;
-
-		g_gy521->v.accel.raw.x = (g_gy521_cache[0]  << 8) | g_gy521_cache[1];
-		g_gy521->v.accel.raw.y = (g_gy521_cache[2]  << 8) | g_gy521_cache[3];
-		g_gy521->v.accel.raw.z = (g_gy521_cache[4]  << 8) | g_gy521_cache[5];
+		dev->v.accel.raw.x = (buf[0]  << 8) | buf[1];
+		dev->v.accel.raw.y = (buf[2]  << 8) | buf[3];
+		dev->v.accel.raw.z = (buf[4]  << 8) | buf[5];
 
 	// Only temperatur
 	}else if(accel_temp_gyro == 2){
-		if(!gy521_read_register(GY521_REG_TEMP_OUT_H, g_gy521_cache, 2)) return false;
-
-		g_gy521->v.temp.raw = (g_gy521_cache[0]  << 8) | g_gy521_cache[1];
+		dev->v.temp.raw = (buf[0]  << 8) | buf[1];
 
 	// Only gyroscope
 	}else if(accel_temp_gyro == 3){
-		if(!gy521_read_register(GY521_REG_GYRO_XOUT_H, g_gy521_cache, 6)) return false;
-
-		g_gy521->v.gyro.raw.x = (g_gy521_cache[0]  << 8) | g_gy521_cache[1];
-		g_gy521->v.gyro.raw.y = (g_gy521_cache[2] << 8) | g_gy521_cache[3];
-		g_gy521->v.gyro.raw.z = (g_gy521_cache[4] << 8) | g_gy521_cache[5];
+		dev->v.gyro.raw.x = (buf[0]  << 8) | buf[1];
+		dev->v.gyro.raw.y = (buf[2] << 8) | buf[3];
+		dev->v.gyro.raw.z = (buf[4] << 8) | buf[5];
 	}
 
+	// External sensor data (auxiliary I2C master) behind the sensor registers
+	if(dev->conf.aux.ext_len)
+		memcpy(dev->v.aux.data, buf + GY521_REG_EXT_SENS_DATA_00 - gy521_span_reg[accel_temp_gyro], dev->conf.aux.ext_len);
+
 	// Optional: scale raw values
-	if(g_gy521->conf.scaled){
+	if(dev->conf.scaled){
 		// Raw -> G for accelerometer
 		if(accel_temp_gyro == 0 || accel_temp_gyro == 1){
-			g_gy521->v.accel.g.x = g_gy521->v.accel.raw.x / g_gy521->conf.accel.fsr_divider;
-			g_gy521->v.accel.g.y = g_gy521->v.accel.raw.y / g_gy521->conf.accel.fsr_divider;
-			g_gy521->v.accel.g.z = g_gy521->v.accel.raw.z / g_gy521->conf.accel.fsr_divider;
+			dev->v.accel.g.x = dev->v.accel.raw.x / dev->conf.accel.fsr_divider;
+			dev->v.accel.g.y = dev->v.accel.raw.y / dev->conf.accel.fsr_divider;
+			dev->v.accel.g.z = dev->v.accel.raw.z / dev->conf.accel.fsr_divider;
 		}
 
 		// Raw -> °C
 		if(accel_temp_gyro == 0 || accel_temp_gyro == 2)
-			g_gy521->v.temp.celsius = (g_gy521->v.temp.raw / 340.0f) + 36.53f;
+			dev->v.temp.celsius = (dev->v.temp.raw / 340.0f) + 36.53f;
 
 		// Raw -> °/s for gyroscope
 		if(accel_temp_gyro == 0 || accel_temp_gyro == 3){
-			g_gy521->v.gyro.dps.x = (g_gy521->v.gyro.raw.x - g_gy521->conf.gyro.offset.x) / g_gy521->conf.gyro.fsr_divider;
-			g_gy521->v.gyro.dps.y = (g_gy521->v.gyro.raw.y - g_gy521->conf.gyro.offset.y) / g_gy521->conf.gyro.fsr_divider;
-			g_gy521->v.gyro.dps.z = (g_gy521->v.gyro.raw.z - g_gy521->conf.gyro.offset.z) / g_gy521->conf.gyro.fsr_divider;
+			dev->v.gyro.dps.x = dev->v.gyro.raw.x / dev->conf.gyro.fsr_divider;
+			dev->v.gyro.dps.y = dev->v.gyro.raw.y / dev->conf.gyro.fsr_divider;
+			dev->v.gyro.dps.z = dev->v.gyro.raw.z / dev->conf.gyro.fsr_divider;
+		}
+	}
+
+	// Optional: fixed-point scaling, one multiply per value instead of a soft-float division
+	if(dev->conf.fixed){
+		// Raw -> milli-g
+		if(accel_temp_gyro == 0 || accel_temp_gyro == 1){
+			dev->v.accel.mg.x = gy521_fixed_mul(dev->v.accel.raw.x, dev->conf.accel.fixed_mul);
+			dev->v.accel.mg.y = gy521_fixed_mul(dev->v.accel.raw.y, dev->conf.accel.fixed_mul);
+			dev->v.accel.mg.z = gy521_fixed_mul(dev->v.accel.raw.z, dev->conf.accel.fixed_mul);
+		}
+
+		// Raw -> milli-°C
+		if(accel_temp_gyro == 0 || accel_temp_gyro == 2)
+			dev->v.temp.mcelsius = gy521_fixed_mul(dev->v.temp.raw, GY521_TEMP_MC_Q16) + GY521_TEMP_MC_OFFSET;
+
+		// Raw -> milli-°/s
+		if(accel_temp_gyro == 0 || accel_temp_gyro == 3){
+			dev->v.gyro.mdps.x = gy521_fixed_mul(dev->v.gyro.raw.x, dev->conf.gyro.fixed_mul);
+			dev->v.gyro.mdps.y = gy521_fixed_mul(dev->v.gyro.raw.y, dev->conf.gyro.fixed_mul);
+			dev->v.gyro.mdps.z = gy521_fixed_mul(dev->v.gyro.raw.z, dev->conf.gyro.fixed_mul);
 		}
 	}
+}
+
+// =========================
+// === Take Sample Stamp ===
+// =========================
+// With conf.interrupt.data_ready only a signalled sample is handed out (once).
+// Otherwise every read gets the next sequence number and the current time.
+bool gy521_stamp_take(gy521_s *dev, gy521_stamp_t *stamp){
+	if(!dev->conf.interrupt.data_ready){
+		stamp->seq = ++dev->priv.seq;
+		stamp->timestamp_us = gy521_port_time_us();
+		return true;
+	}
+
+	uint32_t irq = gy521_port_irq_save();
+	bool pending = dev->priv.drdy_pending;
+	stamp->seq = dev->priv.drdy_stamp.seq;
+	stamp->timestamp_us = dev->priv.drdy_stamp.timestamp_us;
+	dev->priv.drdy_pending = false;
+	gy521_port_irq_restore(irq);
 
+	return pending;
+}
+
+// ===========================================
+// === Read Sensor Data + Optional Scaling ===
+// ===========================================
+// true once per v.rate.period_us; keeps the phase, resyncs after a stall
+static bool gy521_rate_due(gy521_s *dev){
+	uint64_t now = gy521_port_time_us();
+	if(now < dev->priv.next_read_us){
+		dev->v.rate.skipped++;
+		return false;
+	}
+
+	dev->priv.next_read_us += dev->v.rate.period_us;
+	if(dev->priv.next_read_us <= now) dev->priv.next_read_us = now + dev->v.rate.period_us;
 	return true;
 }
+
+// Rate-matched polling (data-ready paces by itself), then the stamp of a new sample
+static bool gy521_read_due(gy521_s *dev, gy521_stamp_t *stamp){
+	if(dev->conf.rate.pace && !dev->conf.interrupt.data_ready && !gy521_rate_due(dev)) return false;
+	return gy521_stamp_take(dev, stamp); // false: no new sample since last read
+}
+
+bool gy521_read(gy521_s *dev, uint8_t accel_temp_gyro){
+	if(!dev || accel_temp_gyro > 3) return false;
+
+	// Opt-in: non-blocking DMA read, returns true once a new sample is decoded
+	if(dev->conf.async.enable) return gy521_port_async_read(dev, accel_temp_gyro);
+
+	gy521_stamp_t stamp;
+	if(!gy521_read_due(dev, &stamp)) return false;
+
+	const uint64_t start_us = gy521_inst_now();
+	uint8_t buf[14 + GY521_AUX_BYTES];
+	if(!gy521_read_register(dev, gy521_span_reg[accel_temp_gyro], buf, gy521_span_bytes(dev, accel_temp_gyro))) return false;
+	gy521_decode(dev, accel_temp_gyro, buf);
+	dev->v.seq = stamp.seq;
+	dev->v.timestamp_us = stamp.timestamp_us;
+	gy521_inst_sample(dev, &stamp, start_us);
+
+	return true;
+}
+
+// ============================
+// === Read several Devices ===
+// ============================
+bool gy521_read_batch(gy521_s **devices, uint8_t count, uint8_t accel_temp_gyro){
+	if(!devices) return false;
+
+	bool all = true;
+	for(uint8_t i = 0; i < count; i++)
+		if(!gy521_read(devices[i], accel_temp_gyro)) all = false;
+
+	return all;
+}
+
+
+// ===========================
+// === Channel Masked Read ===
+// ===========================
+// Channels the current configuration actually produces
+uint8_t gy521_mask_default(const gy521_s *dev){
+	if(!dev) return 0;
+	uint8_t mask = GY521_MASK_ALL;
+
+	if(dev->conf.accel.x.stby) mask &= ~GY521_MASK_ACCEL_X;
+	if(dev->conf.accel.y.stby) mask &= ~GY521_MASK_ACCEL_Y;
+	if(dev->conf.accel.z.stby) mask &= ~GY521_MASK_ACCEL_Z;
+	if(dev->conf.gyro.x.stby) mask &= ~GY521_MASK_GYRO_X;
+	if(dev->conf.gyro.y.stby) mask &= ~GY521_MASK_GYRO_Y;
+	if(dev->conf.gyro.z.stby) mask &= ~GY521_MASK_GYRO_Z;
+	if(dev->conf.temp.sleep) mask &= ~GY521_MASK_TEMP;
+	if(dev->conf.power.cycle) mask &= GY521_MASK_ACCEL; // Accel only
+	return mask;
+}
+
+// Byte ranges from ACCEL_XOUT_H: channel i = [2i, 2i + 2), external data after
+// GYRO_ZOUT_L. One span from the first to the last used byte, split at the
+// largest unused gap if that is longer than GY521_SPAN_GAP_MAX.
+static void gy521_span_plan(gy521_s *dev, uint8_t mask){
+	uint8_t start[8], end[8], n = 0;
+	for(uint8_t i = 0; i < 7; i++){
+		if(!(mask & (1 << i))) continue;
+		start[n] = 2 * i;
+		end[n++] = 2 * i + 2;
+	}
+	if(dev->conf.aux.ext_len){
+		start[n] = GY521_REG_EXT_SENS_DATA_00 - GY521_REG_ACCEL_XOUT_H;
+		end[n] = start[n] + dev->conf.aux.ext_len;
+		n++;
+	}
+
+	uint8_t split = 0, gap = 0;
+	for(uint8_t k = 1; k < n; k++){
+		if(start[k] - end[k - 1] > gap){
+			gap = start[k] - end[k - 1];
+			split = k;
+		}
+	}
+
+	dev->priv.span.mask = mask;
+	dev->priv.span.ext_len = dev->conf.aux.ext_len;
+	dev->priv.span.count = gap > GY521_SPAN_GAP_MAX ? 2 : 1;
+	dev->priv.span.reg[0] = GY521_REG_ACCEL_XOUT_H + start[0];
+	if(dev->priv.span.count == 1){
+		dev->priv.span.len[0] = end[n - 1] - start[0];
+		return;
+	}
+	dev->priv.span.len[0] = end[split - 1] - start[0];
+	dev->priv.span.reg[1] = GY521_REG_ACCEL_XOUT_H + start[split];
+	dev->priv.span.len[1] = end[n - 1] - start[split];
+}
+
+// 'buf' holds the registers from ACCEL_XOUT_H on, only masked channels are touched
+static void gy521_decode_mask(gy521_s *dev, uint8_t mask, const uint8_t *buf){
+	int16_t *raw[7] = {&dev->v.accel.raw.x, &dev->v.accel.raw.y, &dev->v.accel.raw.z, &dev->v.temp.raw,
+		&dev->v.gyro.raw.x, &dev->v.gyro.raw.y, &dev->v.gyro.raw.z};
+	for(uint8_t i = 0; i < 7; i++)
+		if(mask & (1 << i)) *raw[i] = (buf[2 * i] << 8) | buf[2 * i + 1];
+
+	float *g = &dev->v.accel.g.x, *dps = &dev->v.gyro.dps.x;
+	int32_t *mg = &dev->v.accel.mg.x, *mdps = &dev->v.gyro.mdps.x;
+	for(uint8_t i = 0; i < 3; i++){
+		const bool a = mask & (GY521_MASK_ACCEL_X << i), r = mask & (GY521_MASK_GYRO_X << i);
+		if(dev->conf.scaled && a) g[i] = *raw[i] / dev->conf.accel.fsr_divider;
+		if(dev->conf.scaled && r) dps[i] = *raw[4 + i] / dev->conf.gyro.fsr_divider;
+		if(dev->conf.fixed && a) mg[i] = gy521_fixed_mul(*raw[i], dev->conf.accel.fixed_mul);
+		if(dev->conf.fixed && r) mdps[i] = gy521_fixed_mul(*raw[4 + i], dev->conf.gyro.fixed_mul);
+	}
+	if(mask & GY521_MASK_TEMP){
+		if(dev->conf.scaled) dev->v.temp.celsius = (dev->v.temp.raw / 340.0f) + 36.53f;
+		if(dev->conf.fixed) dev->v.temp.mcelsius = gy521_fixed_mul(dev->v.temp.raw, GY521_TEMP_MC_Q16) + GY521_TEMP_MC_OFFSET;
+	}
+
+	if(dev->conf.aux.ext_len)
+		memcpy(dev->v.aux.data, buf + GY521_REG_EXT_SENS_DATA_00 - GY521_REG_ACCEL_XOUT_H, dev->conf.aux.ext_len);
+}
+
+// Always blocking (conf.async.enable is ignored)
+bool gy521_read_mask(gy521_s *dev, uint8_t mask){
+	if(!dev) return false;
+	mask = (mask ? mask : gy521_mask_default(dev)) & GY521_MASK_ALL;
+	if(!mask && !dev->conf.aux.ext_len) return false;
+
+	if(dev->priv.span.mask != mask || dev->priv.span.ext_len != dev->conf.aux.ext_len || !dev->priv.span.count)
+		gy521_span_plan(dev, mask);
+
+	gy521_stamp_t stamp;
+	if(!gy521_read_due(dev, &stamp)) return false;
+
+	const uint64_t start_us = gy521_inst_now();
+	uint8_t buf[14 + GY521_AUX_BYTES];
+	for(uint8_t k = 0; k < dev->priv.span.count; k++){
+		const uint8_t reg = dev->priv.span.reg[k];
+		if(!gy521_read_register(dev, reg, &buf[reg - GY521_REG_ACCEL_XOUT_H], dev->priv.span.len[k])) return false;
+	}
+	gy521_decode_mask(dev, mask, buf);
+	dev->v.seq = stamp.seq;
+	dev->v.timestamp_us = stamp.timestamp_us;
+	gy521_inst_sample(dev, &stamp, start_us);
+
+	return true;
+}
+
+// ========================
+// === Data-ready Event ===
+// ========================
+// Stamps every new sample; a sample that was not read
+// before the next one arrived counts as missed.
+void gy521_data_ready(gy521_s *dev){
+	if(!dev) return;
+
+	// Motion pulse: the only source while cycling, or motion without data-ready
+	if((dev->conf.power.cycle && dev->conf.power.auto_cycle) || (dev->conf.interrupt.motion && !dev->conf.interrupt.data_ready)){
+		dev->priv.motion_pending = true;
+		return;
+	}
+	if(!dev->conf.interrupt.data_ready) return;
+
+	if(dev->priv.drdy_pending) dev->v.interrupt.missed++;
+	dev->priv.drdy_stamp.seq++;
+	dev->priv.drdy_stamp.timestamp_us = gy521_port_time_us();
+	dev->priv.drdy_pending = true;
+}
+
+// ===============================================
+// === Configure Data-ready / Motion Interrupt ===
+// ===============================================
+bool gy521_set_interrupt(gy521_s *dev){
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
+
+	gy521_bits_interrupt(dev, &image[GY521_SH_INT_PIN_CFG], &image[GY521_SH_INT_ENABLE]);
+	if(!gy521_shadow_apply(dev, image)) return false;
+
+	dev->priv.drdy_pending = false;
+	dev->priv.motion_pending = false;
+
+	return gy521_port_interrupt(dev, image[GY521_SH_INT_ENABLE] != 0);
+}
+
+// ==================
+// === FIFO Reset ===
+// ==================
+// Stops the FIFO, flushes it and enables it again if conf.fifo.enable
+bool gy521_fifo_reset(gy521_s *dev){
+	uint8_t reg;
+	if(!gy521_read_register(dev, GY521_REG_USER_CTRL, &reg, 1)) return false;
+
+	reg &= ~GY521_FIFO_EN;
+	if(!gy521_write_register(dev, GY521_REG_USER_CTRL, (uint8_t[]){reg | GY521_FIFO_RESET}, 1)) return false;
+
+	if(!dev->conf.fifo.enable) return true;
+
+	return gy521_write_register(dev, GY521_REG_USER_CTRL, (uint8_t[]){reg | GY521_FIFO_EN}, 1);
+}
+
+// =============================================
+// === Set FIFO channels in Register FIFO_EN ===
+// =============================================
+bool gy521_fifo_set(gy521_s *dev){
+	if(!dev) return false;
+
+	uint8_t fifo_en = 0;
+	dev->conf.fifo.frame_size = 0;
+	if(dev->conf.fifo.accel){
+		fifo_en |= GY521_ACCEL_FIFO_EN;
+		dev->conf.fifo.frame_size += 6;
+	}
+	if(dev->conf.fifo.temp){
+		fifo_en |= GY521_TEMP_FIFO_EN;
+		dev->conf.fifo.frame_size += 2;
+	}
+	if(dev->conf.fifo.gyro){
+		fifo_en |= GY521_XG_FIFO_EN | GY521_YG_FIFO_EN | GY521_ZG_FIFO_EN;
+		dev->conf.fifo.frame_size += 6;
+	}
+	if(!dev->conf.fifo.enable) fifo_en = 0;
+
+	if(!gy521_write_register(dev, GY521_REG_FIFO_EN, &fifo_en, 1)) return false;
+
+	dev->v.fifo.count = 0;
+
+	return gy521_fifo_reset(dev);
+}
+
+// =======================
+// === FIFO Burst Read ===
+// =======================
+// Reads up to 'max' complete frames from the FIFO into 'samples'.
+// Frames are written in register order (accel, temp, gyro).
+// On overflow or a misaligned count the FIFO is flushed and 0 is returned.
+// Complete frames queued (at most 'max'), 0 after an overflow
+static uint16_t gy521_fifo_frames(gy521_s *dev, uint16_t max){
+	const uint8_t frame_size = dev->conf.fifo.frame_size;
+	uint8_t count[2];
+
+	if(!gy521_read_register(dev, GY521_REG_FIFO_COUNTH, count, 2)) return 0;
+	dev->v.fifo.count = ((count[0] & 0x07) << 8) | count[1];
+
+	// A full FIFO has overwritten old data, frame alignment is lost
+	if(dev->v.fifo.count >= GY521_FIFO_SIZE || dev->v.fifo.count % frame_size){
+		dev->v.fifo.overflows++;
+		gy521_fifo_reset(dev);
+		return 0;
+	}
+
+	uint16_t frames = dev->v.fifo.count / frame_size;
+	return frames > max ? max : frames;
+}
+
+uint16_t gy521_fifo_read(gy521_s *dev, gy521_sample_t *samples, uint16_t max){
+	if(!dev || !samples || !dev->conf.fifo.frame_size) return 0;
+
+	const uint8_t frame_size = dev->conf.fifo.frame_size;
+	uint8_t burst[GY521_FIFO_BURST_FRAMES * 14];
+	uint16_t frames = gy521_fifo_frames(dev, max);
+
+	uint16_t done = 0;
+	while(done < frames){
+		uint16_t chunk = frames - done;
+		if(chunk > GY521_FIFO_BURST_FRAMES) chunk = GY521_FIFO_BURST_FRAMES;
+
+		if(!gy521_read_register(dev, GY521_REG_FIFO_R_W, burst, chunk * frame_size)) break;
+
+		for(uint16_t i = 0; i < chunk; i++){
+			const uint8_t *f = &burst[i * frame_size];
+			gy521_sample_t *s = &samples[done + i];
+			*s = (gy521_sample_t){0};
+
+			if(dev->conf.fifo.accel){
+				s->accel.x = (f[0] << 8) | f[1];
+				s->accel.y = (f[2] << 8) | f[3];
+				s->accel.z = (f[4] << 8) | f[5];
+				f += 6;
+			}
+			if(dev->conf.fifo.temp){
+				s->temp = (f[0] << 8) | f[1];
+				f += 2;
+			}
+			if(dev->conf.fifo.gyro){
+				s->gyro.x = (f[0] << 8) | f[1];
+				s->gyro.y = (f[2] << 8) | f[3];
+				s->gyro.z = (f[4] << 8) | f[5];
+			}
+		}
+		done += chunk;
+	}
+
+	dev->v.fifo.count -= done * frame_size;
+
+	return done;
+}
+
+// ===========================
+// === FIFO Raw Burst Read ===
+// ===========================
+// Copies up to 'max' complete frames undecoded into 'bytes'
+// (max * conf.fifo.frame_size bytes), e.g. for gy521_batch_*().
+uint16_t gy521_fifo_read_raw(gy521_s *dev, uint8_t *bytes, uint16_t max){
+	if(!dev || !bytes || !dev->conf.fifo.frame_size) return 0;
+
+	const uint8_t frame_size = dev->conf.fifo.frame_size;
+	uint16_t frames = gy521_fifo_frames(dev, max);
+
+	uint16_t done = 0;
+	while(done < frames){
+		uint16_t chunk = frames - done;
+		if(chunk > GY521_FIFO_BURST_FRAMES) chunk = GY521_FIFO_BURST_FRAMES;
+
+		if(!gy521_read_register(dev, GY521_REG_FIFO_R_W, &bytes[done * frame_size], chunk * frame_size)) break;
+		done += chunk;
+	}
+
+	dev->v.fifo.count -= done * frame_size;
+
+	return done;
+}
+
+// ============================
+// === Auxiliary I2C Master ===
+// ============================
+// The MPU-6050 reads up to 4 slaves on its auxiliary bus with every sample
+// into EXT_SENS_DATA, right behind GYRO_ZOUT_L, so fn.read() gets them in
+// the same burst. Read slots are packed in order, 24 bytes in total.
+bool gy521_aux_set(gy521_s *dev){
+	if(!dev) return false;
+
+	// I2C_MST_CTRL + ADDR / REG / CTRL of SLV0..3 in one burst, then SLV0..3_DO
+	uint8_t slv[1 + 3 * GY521_AUX_SLAVES] = {0}, out[GY521_AUX_SLAVES] = {0};
+	uint8_t ext_len = 0;
+	for(uint8_t i = 0; dev->conf.aux.enable && i < GY521_AUX_SLAVES; i++){
+		if(!dev->conf.aux.slv[i].addr) continue;
+
+		const uint8_t len = dev->conf.aux.slv[i].len;
+		if(len > GY521_I2C_SLV_LEN_MASK || ext_len + len > GY521_AUX_BYTES) return false;
+
+		uint8_t *s = &slv[1 + 3 * i];
+		s[0] = (dev->conf.aux.slv[i].addr & 0x7f) | (len ? GY521_I2C_SLV_RNW : 0);
+		s[1] = dev->conf.aux.slv[i].reg;
+		s[2] = GY521_I2C_SLV_EN | (len ? len : 1);
+		if(dev->conf.aux.slv[i].swap) s[2] |= GY521_I2C_SLV_BYTE_SW;
+		out[i] = dev->conf.aux.slv[i].out;
+		ext_len += len;
+	}
+	slv[0] = dev->conf.aux.clk & GY521_I2C_MST_CLK_MASK;
+	if(ext_len) slv[0] |= GY521_WAIT_FOR_ES; // Data-ready only with the external data in place
+
+	if(!gy521_write_register(dev, GY521_REG_I2C_MST_CTRL, slv, sizeof(slv))) return false;
+	if(!gy521_write_register(dev, GY521_REG_I2C_SLV0_DO, out, sizeof(out))) return false;
+
+	uint8_t user;
+	if(!gy521_read_register(dev, GY521_REG_USER_CTRL, &user, 1)) return false;
+	user = dev->conf.aux.enable ? user | GY521_I2C_MST_EN : user & ~GY521_I2C_MST_EN;
+	if(!gy521_write_register(dev, GY521_REG_USER_CTRL, &user, 1)) return false;
+	dev->conf.aux.ext_len = ext_len;
+
+	// Bypass shares INT_PIN_CFG with the interrupt pin setup
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
+
+	gy521_bits_interrupt(dev, &image[GY521_SH_INT_PIN_CFG], &image[GY521_SH_INT_ENABLE]);
+	return gy521_shadow_apply(dev, image);
+}
+
+// Single byte through SLV4, run by the master at its next sample.
+// Fails on NACK or after two sample periods without completion.
+static bool gy521_aux_slv4(gy521_s *dev, uint8_t addr, uint8_t reg, uint8_t value, bool read, uint8_t *in){
+	if(!dev || !dev->conf.aux.enable || dev->conf.sleep) return false;
+
+	const uint8_t cmd[4] = {(addr & 0x7f) | (read ? GY521_I2C_SLV_RNW : 0), reg, value, GY521_I2C_SLV_EN};
+	if(!gy521_write_register(dev, GY521_REG_I2C_SLV4_ADDR, cmd, 4)) return false;
+
+	const uint64_t deadline = gy521_port_time_us() + 2u * dev->v.rate.period_us + 2000u;
+	uint8_t status = 0;
+	while(!(status & GY521_I2C_SLV4_DONE)){
+		gy521_port_sleep_ms(1);
+		if(!gy521_read_register(dev, GY521_REG_I2C_MST_STATUS, &status, 1)) return false;
+		if(!(status & GY521_I2C_SLV4_DONE) && gy521_port_time_us() > deadline) return false;
+	}
+	if(status & GY521_I2C_SLV4_NACK) return false;
+
+	return !read || gy521_read_register(dev, GY521_REG_I2C_SLV4_DI, in, 1);
+}
+
+bool gy521_aux_read(gy521_s *dev, uint8_t addr, uint8_t reg, uint8_t *value){
+	if(!value) return false;
+	return gy521_aux_slv4(dev, addr, reg, 0, true, value);
+}
+
+bool gy521_aux_write(gy521_s *dev, uint8_t addr, uint8_t reg, uint8_t value){
+	return gy521_aux_slv4(dev, addr, reg, value, false, NULL);
+}
+
+// ====================
+// === Bus Recovery ===
+// ====================
+// The device may have been reset (brownout) or kept its registers:
+// read back what it holds, then write what differs from conf.
+static bool gy521_restore(gy521_s *dev){
+	dev->priv.shadow_valid = false;
+	if(!gy521_test_connection(dev)) return false;
+	if(!gy521_commit(dev)) return false;
+
+	// Interrupt registers only, the INT pin routing is not lost
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return false;
+	gy521_bits_interrupt(dev, &image[GY521_SH_INT_PIN_CFG], &image[GY521_SH_INT_ENABLE]);
+	if(!gy521_shadow_apply(dev, image)) return false;
+
+	// Zeros would wipe the factory trim, so only offsets the driver has seen
+	if(dev->priv.offsets_known && !gy521_set_offsets(dev)) return false;
+	if(dev->conf.fifo.enable && !gy521_fifo_set(dev)) return false;
+	if((dev->conf.aux.enable || dev->conf.aux.bypass) && !gy521_aux_set(dev)) return false;
+	return true;
+}
+
+// Worst case for the call that triggers it: conf.recover.after timed out
+// transfers before it, then the bus sequence + a few register transfers.
+bool gy521_recover(gy521_s *dev){
+	if(!dev || !dev->conf.bus || dev->priv.recovering) return false;
+	gy521_bus_t *bus = dev->conf.bus;
+	dev->priv.recovering = true;
+
+	bool ok = true;
+	if(bus->recover){
+		bus->stat.recoveries++;
+		ok = bus->recover(bus->ctx);
+	}
+	if(ok) ok = gy521_restore(dev);
+
+	dev->priv.recovering = false;
+	dev->priv.failures = 0;
+	dev->v.recover.events++;
+	if(!ok){
+		dev->v.recover.failed++;
+		return false;
+	}
+
+	if(dev->priv.outage){
+		uint64_t lost = gy521_port_time_us() - dev->priv.fail_since;
+		dev->v.recover.lost_us += lost;
+		dev->v.recover.last_us = (uint32_t)lost;
+		dev->priv.outage = false;
+	}
+	return true;
+}
+
+// =================
+// === Bus Clock ===
+// =================
+uint32_t gy521_bus_baud(gy521_bus_t *bus, uint32_t hz){
+	if(!bus || !bus->set_baud || !hz) return 0;
+	gy521_bus_wait(bus);
+
+	uint32_t actual = bus->set_baud(bus->ctx, hz);
+	if(!actual) return 0;
+	bus->baud = actual;
+
+	// Longest read: address + register + 14 data + external bytes, 9 clocks each + start / stop
+	uint32_t min_us = (uint32_t)(2ull * ((2u + 14u + GY521_AUX_BYTES) * 9u + 2u) * 1000000u / actual);
+	if(bus->timeout_us && bus->timeout_us < min_us) bus->timeout_us = min_us;
+	return actual;
+}
+
+// ===========================
+// === Bus Clock Self-test ===
+// ===========================
+// A burst checks what it can: WHO_AM_I and the configuration registers
+// (known from the shadow) read back, the data read in between is timed.
+static bool gy521_baud_burst(gy521_s *dev){
+	uint8_t who = 0, data[14], cfg[4];
+	if(!gy521_read_register(dev, GY521_REG_WHO_AM_I, &who, 1) || who != 0x68) return false;
+	if(!gy521_read_register(dev, GY521_REG_ACCEL_XOUT_H, data, 14)) return false;
+	if(!gy521_read_register(dev, GY521_REG_SMPLRT_DIV, cfg, 4)) return false;
+	return memcmp(cfg, &dev->priv.shadow[GY521_SH_SMPLRT_DIV], 4) == 0; // SMPLRT_DIV .. ACCEL_CONFIG
+}
+
+uint32_t gy521_baud_test(gy521_s *dev, const uint32_t *bauds, uint8_t count, uint16_t bursts, gy521_baud_result_t *results){
+	static const uint32_t g_gy521_bauds[3] = {GY521_BAUD_STANDARD, GY521_BAUD_FAST, GY521_BAUD_FAST_PLUS};
+	if(!dev || !dev->conf.bus || !dev->conf.bus->set_baud || !bursts) return 0;
+	if(!bauds){
+		bauds = g_gy521_bauds;
+		count = 3;
+	}
+
+	uint8_t image[GY521_SHADOW_REGS];
+	if(!gy521_shadow_image(dev, image)) return 0;
+
+	// Errors are expected here, no recovery in between
+	gy521_bus_t *bus = dev->conf.bus;
+	const uint32_t prev = bus->baud;
+	const uint8_t after = dev->conf.recover.after;
+	dev->conf.recover.after = 0;
+
+	uint32_t best = 0, best_req = prev;
+	for(uint8_t i = 0; i < count; i++){
+		gy521_baud_result_t r = {.baud = bauds[i]};
+		r.actual = gy521_bus_baud(bus, bauds[i]);
+
+		const uint64_t t0 = gy521_port_time_us();
+		for(; r.actual && r.bursts < bursts; r.bursts++)
+			if(!gy521_baud_burst(dev)) r.errors++;
+		const uint64_t us = gy521_port_time_us() - t0;
+
+		if(r.actual && us) r.samples_per_s = (uint32_t)((uint64_t)(r.bursts - r.errors) * 1000000u / us);
+		if(r.actual && !r.errors && r.actual > best){
+			best = r.actual;
+			best_req = bauds[i];
+		}
+		if(results) results[i] = r;
+	}
+
+	// Fastest reliable clock, or back to the previous one
+	if(best_req) gy521_bus_baud(bus, best_req);
+
+	dev->conf.recover.after = after;
+	dev->priv.failures = 0;
+	dev->priv.outage = false;
+	return best;
+}
@@ -0,0 +1,240 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_bias.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Online gyro bias tracking with stillness detection and a
+ *  bias-vs-temperature fit, see gy521_bias.h.
+ *
+ *  The estimate is kept as offset register LSB in Q8 together with
+ *  the temperature it was measured at. The prediction for the
+ *  current temperature is computed from there every window, so
+ *  no rounding error piles up while the temperature creeps.
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521_bias.h"
+#include "gy521_regs.h"
+
+#define GY521_BIAS_HYST 160 // Q8: v.offset moves once the estimate is 5/8 LSB away (no toggling)
+#define GY521_TEMP_LSB_PER_C 340.0f
+
+// ===============
+// === Helpers ===
+// ===============
+// x / d rounded half away from zero, d > 0
+static int64_t gy521_div_round(int64_t x, int64_t d){
+	return x >= 0 ? (x + d / 2) / d : (x - d / 2) / d;
+}
+
+static int32_t gy521_clamp16(int64_t v){
+	return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int32_t)v;
+}
+
+// ==================================
+// === Initialization / Configure ===
+// ==================================
+void gy521_bias_init(gy521_bias_t *b){
+	*b = (gy521_bias_t){0};
+	b->conf.window = GY521_BIAS_WINDOW;
+	b->conf.hold = 4;
+	b->conf.shift = 3;
+	b->conf.forget = 12;
+	b->conf.gyro_noise_mdps = 300;
+	b->conf.accel_noise_mg = 20;
+	b->conf.max_rate_mdps = 10000;
+	b->conf.min_spread_mc = 1000;
+	b->conf.model = true;
+}
+
+// Current window only
+static void gy521_bias_restart(gy521_bias_t *b){
+	for(uint8_t a = 0; a < 7; a++) b->priv.sum[a] = 0;
+	for(uint8_t a = 0; a < 6; a++) b->priv.sumsq[a] = 0;
+	b->priv.count = 0;
+	b->priv.run = 0;
+	b->priv.skip = GY521_BIAS_SETTLE;
+}
+
+void gy521_bias_reset(gy521_bias_t *b){
+	gy521_bias_restart(b);
+	b->priv.has_est = false;
+	b->priv.n = b->priv.t = b->priv.tt = 0;
+	for(uint8_t k = 0; k < 3; k++){
+		b->priv.b[k] = b->priv.tb[k] = 0;
+		b->v.slope[k] = 0;
+	}
+	b->v.fitted = false;
+}
+
+// ===================
+// === Temperature ===
+// ===================
+// Weighted least squares of bias (Q8) vs. temperature, once per measurement
+static void gy521_bias_fit(gy521_bias_t *b, int32_t temp, const int32_t target[3]){
+	if(b->priv.n == 0) b->priv.t0 = temp;
+	const float x = (temp - b->priv.t0) / GY521_TEMP_LSB_PER_C;
+	const float keep = b->conf.forget ? 1.0f - 1.0f / (float)(1ul << b->conf.forget) : 1.0f;
+
+	b->priv.n = b->priv.n * keep + 1.0f;
+	b->priv.t = b->priv.t * keep + x;
+	b->priv.tt = b->priv.tt * keep + x * x;
+	for(uint8_t k = 0; k < 3; k++){
+		const float y = target[k] / 256.0f;
+		b->priv.b[k] = b->priv.b[k] * keep + y;
+		b->priv.tb[k] = b->priv.tb[k] * keep + x * y;
+	}
+
+	const float mean = b->priv.t / b->priv.n;
+	const float var = b->priv.tt / b->priv.n - mean * mean;
+	const float spread = b->conf.min_spread_mc / 1000.0f;
+	if(var < spread * spread) return; // Keep the last slope
+
+	for(uint8_t k = 0; k < 3; k++)
+		b->v.slope[k] = (b->priv.tb[k] / b->priv.n - mean * b->priv.b[k] / b->priv.n) / var;
+	b->v.fitted = true;
+}
+
+// =================
+// === Stillness ===
+// =================
+static bool gy521_bias_still(const gy521_bias_t *b, uint8_t accel_fsr, uint8_t gyro_fsr){
+	const uint64_t n = b->priv.count;
+	// Limits in raw LSB * 1000 << fs: g = 16384 LSB, °/s = 131 LSB at fs 0
+	const uint64_t accel_lim = (uint64_t)b->conf.accel_noise_mg * 16384;
+	const uint64_t accel_den = 1000u << ((accel_fsr >> 3) & 0x03);
+	const uint64_t gyro_lim = (uint64_t)b->conf.gyro_noise_mdps * 131;
+	const uint64_t gyro_den = 1000u << ((gyro_fsr >> 3) & 0x03);
+	const uint64_t rate_lim = (uint64_t)b->conf.max_rate_mdps * 131;
+
+	for(uint8_t a = 0; a < 6; a++){
+		const int64_t sum = b->priv.sum[a];
+		const uint64_t var = (n * b->priv.sumsq[a] - (uint64_t)(sum * sum)) / (n * n);
+		const uint64_t lim = a < 3 ? accel_lim : gyro_lim, den = a < 3 ? accel_den : gyro_den;
+		if(var * den * den > lim * lim) return false;
+		if(a >= 3 && (uint64_t)(sum < 0 ? -sum : sum) * den > rate_lim * n) return false;
+	}
+	return true;
+}
+
+// ==============
+// === Window ===
+// ==============
+static uint8_t gy521_bias_window(gy521_bias_t *b, uint8_t accel_fsr, uint8_t gyro_fsr){
+	const bool still = gy521_bias_still(b, accel_fsr, gyro_fsr);
+	const int32_t temp = (int32_t)gy521_div_round(b->priv.sum[6], b->priv.count);
+	const uint8_t gyro_fs = (gyro_fsr >> 3) & 0x03;
+	int32_t *offset = &b->v.offset.x;
+
+	b->v.windows++;
+	b->v.still = still;
+	if(still){
+		b->v.still_windows++;
+		if(b->priv.run < UINT8_MAX) b->priv.run++;
+	}else b->priv.run = 0;
+
+	// Estimate carried to the current temperature along the fitted slope
+	int32_t est[3];
+	for(uint8_t k = 0; k < 3; k++){
+		est[k] = b->priv.est[k];
+		if(b->priv.has_est && b->v.fitted && b->conf.model)
+			est[k] += (int32_t)(b->v.slope[k] * (float)(temp - b->priv.t_est) * (256.0f / GY521_TEMP_LSB_PER_C));
+	}
+
+	if(still && b->priv.run >= b->conf.hold){
+		// Remaining rate in sensor LSB -> offset LSB (Q8): 2^fs / 4
+		int32_t target[3];
+		for(uint8_t k = 0; k < 3; k++){
+			target[k] = offset[k] * 256 - (int32_t)gy521_div_round(b->priv.sum[3 + k] * (64 << gyro_fs), b->priv.count);
+			est[k] = b->priv.has_est ? est[k] + (target[k] - est[k]) / (1 << b->conf.shift) : target[k];
+			b->priv.est[k] = est[k];
+		}
+		b->priv.t_est = temp;
+		b->priv.has_est = true;
+		b->v.measurements++;
+		gy521_bias_fit(b, temp, target);
+	}
+
+	for(uint8_t a = 0; a < 7; a++) b->priv.sum[a] = 0;
+	for(uint8_t a = 0; a < 6; a++) b->priv.sumsq[a] = 0;
+	b->priv.count = 0;
+
+	if(!b->priv.has_est) return GY521_BIAS_DONE;
+
+	bool changed = false;
+	for(uint8_t k = 0; k < 3; k++){
+		const int32_t diff = est[k] - offset[k] * 256;
+		if(diff > GY521_BIAS_HYST || diff < -GY521_BIAS_HYST){
+			const int32_t next = gy521_clamp16(gy521_div_round(est[k], 256));
+			changed |= next != offset[k];
+			offset[k] = next;
+		}
+	}
+	if(!changed) return GY521_BIAS_DONE;
+
+	b->priv.skip = GY521_BIAS_SETTLE;
+	b->v.changes++;
+	return GY521_BIAS_DONE | GY521_BIAS_OFFSET;
+}
+
+// ==============
+// === Update ===
+// ==============
+uint8_t gy521_bias_update_sample(gy521_bias_t *b, const gy521_sample_t *s, uint8_t accel_fsr, uint8_t gyro_fsr){
+	if(!b || !s || !b->conf.window) return 0;
+	if(b->priv.skip){
+		b->priv.skip--;
+		return 0;
+	}
+
+	const int16_t c[7] = {s->accel.x, s->accel.y, s->accel.z, s->gyro.x, s->gyro.y, s->gyro.z, s->temp};
+	for(uint8_t a = 0; a < 6; a++){
+		b->priv.sum[a] += c[a];
+		b->priv.sumsq[a] += (uint32_t)((int32_t)c[a] * c[a]);
+	}
+	b->priv.sum[6] += c[6];
+
+	if(++b->priv.count < b->conf.window) return 0;
+	return gy521_bias_window(b, accel_fsr, gyro_fsr);
+}
+
+uint8_t gy521_bias_update(gy521_bias_t *b, gy521_s *dev){
+	if(!b || !dev) return 0;
+	if(!dev->priv.offsets_known && !gy521_get_offsets(dev)) return 0;
+
+	// First call, or the offsets were changed behind our back (calibrate, failed write)
+	const int32_t *conf = &dev->conf.gyro.offset.x, *own = &b->v.offset.x;
+	if(!b->priv.synced || conf[0] != own[0] || conf[1] != own[1] || conf[2] != own[2]){
+		b->v.offset = dev->conf.gyro.offset;
+		b->priv.has_est = false;
+		b->priv.synced = true;
+		gy521_bias_restart(b);
+	}
+
+	const gy521_sample_t s = {
+		.accel = dev->v.accel.raw,
+		.temp = dev->v.temp.raw,
+		.gyro = dev->v.gyro.raw,
+	};
+	uint8_t done = gy521_bias_update_sample(b, &s, dev->conf.accel.fsr, dev->conf.gyro.fsr);
+	if(!(done & GY521_BIAS_OFFSET)) return done;
+
+	uint8_t g[6];
+	for(uint8_t k = 0; k < 3; k++){
+		g[2 * k] = (uint8_t)((uint16_t)own[k] >> 8);
+		g[2 * k + 1] = (uint8_t)own[k];
+	}
+	dev->conf.gyro.offset = b->v.offset;
+	if(!gy521_write_register(dev, GY521_REG_XG_OFFS_USRH, g, 6)){
+		dev->priv.offsets_known = false; // Read back on the next call
+		return done & ~GY521_BIAS_OFFSET;
+	}
+	return done;
+}
@@ -0,0 +1,114 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_core1.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Acquisition engine running on core 1.
+ *  Reads the device as fast as its configuration allows and
+ *  queues every sample into a lock-free SPSC ring buffer.
+ *
+ * ================================================================
+ */
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521.h"
+#include "gy521_ring.h"
+#include "gy521_core1.h"
+#include "gy521_port.h"
+
+// ========================
+// === Global Variables ===
+// ========================
+// Handed over to core 1 before launch, read-only while it runs
+static gy521_s *g_gy521_core1_dev = NULL;
+static gy521_ring_t *g_gy521_core1_ring = NULL;
+static uint8_t g_gy521_core1_mode = GY521_ALL;
+
+static volatile bool g_gy521_core1_stop = false; // Set by core 0
+static volatile bool g_gy521_core1_running = false; // Set by core 1
+
+// =========================
+// === Core 1 Entry Loop ===
+// =========================
+static void gy521_core1_entry(void){
+	gy521_s *dev = g_gy521_core1_dev;
+
+	// GPIO / DMA IRQs are installed on the core that configures them
+	if(dev->conf.interrupt.data_ready) dev->fn.interrupt(dev);
+
+	// Lets core 0 park this core while it writes flash (gy521_flash_save)
+	flash_safe_execute_core_init();
+
+	g_gy521_core1_running = true;
+
+	while(!g_gy521_core1_stop){
+		if(!dev->fn.read(dev, g_gy521_core1_mode)) continue;
+
+		gy521_frame_t frame = {
+			.timestamp_us = dev->v.timestamp_us,
+			.seq = dev->v.seq,
+			.sample = {
+				.accel = dev->v.accel.raw,
+				.temp = dev->v.temp.raw,
+				.gyro = dev->v.gyro.raw,
+			},
+		};
+		gy521_ring_push(g_gy521_core1_ring, &frame);
+	}
+
+	// Hand both back before core 0 sees the engine stopped
+	flash_safe_execute_core_deinit();
+	if(dev->conf.interrupt.data_ready) gy521_port_interrupt(dev, false);
+
+	g_gy521_core1_running = false;
+}
+
+// ====================
+// === Start Engine ===
+// ====================
+bool gy521_core1_start(gy521_s *device, gy521_ring_t *ring, uint8_t accel_temp_gyro){
+	if(!device || !ring || g_gy521_core1_running) return false;
+
+	g_gy521_core1_dev = device;
+	g_gy521_core1_ring = ring;
+	g_gy521_core1_mode = accel_temp_gyro;
+	g_gy521_core1_stop = false;
+
+	gy521_ring_init(ring);
+
+	// Data-ready moves to core 1: the GPIO IRQ is per core, both would take every edge
+	if(device->conf.int_pin >= 0) gy521_port_interrupt(device, false);
+	multicore_launch_core1(&gy521_core1_entry);
+
+	while(!g_gy521_core1_running) tight_loop_contents();
+
+	return true;
+}
+
+// ===================
+// === Stop Engine ===
+// ===================
+void gy521_core1_stop(void){
+	if(!g_gy521_core1_running) return;
+
+	g_gy521_core1_stop = true;
+	while(g_gy521_core1_running) tight_loop_contents();
+
+	multicore_reset_core1();
+
+	// Data-ready back on core 0
+	gy521_s *dev = g_gy521_core1_dev;
+	if(dev->conf.interrupt.data_ready) gy521_port_interrupt(dev, true);
+}
+
+bool gy521_core1_running(void){
+	return g_gy521_core1_running;
+}
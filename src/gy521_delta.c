@@ -0,0 +1,266 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_delta.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Deadband + delta encoded change-only stream and its byte-wise
+ *  decoder, see gy521_delta.h for the format.
+ *
+ *  Per suppressed sample the encoder costs 7 subtractions and
+ *  compares, no float, no division.
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "gy521_delta.h"
+#include "gy521_telemetry.h" // CRC-16
+
+#define GY521_DELTA_KEY_SIZE (3 + 8 + 14 + 2)
+
+// ===============
+// === Helpers ===
+// ===============
+static uint8_t gy521_delta_varint(uint8_t *out, uint32_t v){
+	uint8_t n = 0;
+	do{
+		out[n] = (uint8_t)(v & 0x7f);
+		v >>= 7;
+		if(v) out[n] |= 0x80;
+		n++;
+	}while(v);
+	return n;
+}
+
+// Bytes of the varint at p (max bytes 'max'), 0 = incomplete, -1 = too long
+static int8_t gy521_delta_varint_len(const uint8_t *p, uint8_t avail, uint8_t max){
+	for(uint8_t i = 0; i < max; i++){
+		if(i >= avail) return 0;
+		if(!(p[i] & 0x80)) return (int8_t)(i + 1);
+	}
+	return -1;
+}
+
+static uint32_t gy521_delta_varint_get(const uint8_t **p){
+	uint32_t v = 0;
+	for(uint8_t shift = 0;; shift += 7){
+		const uint8_t b = *(*p)++;
+		v |= (uint32_t)(b & 0x7f) << shift;
+		if(!(b & 0x80)) return v;
+	}
+}
+
+static void gy521_delta_put16(uint8_t *p, uint16_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void gy521_delta_put32(uint8_t *p, uint32_t v){
+	for(uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t gy521_delta_get32(const uint8_t *p){
+	return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void gy521_delta_channels(const gy521_sample_t *s, int16_t c[7]){
+	c[0] = s->accel.x; c[1] = s->accel.y; c[2] = s->accel.z;
+	c[3] = s->temp;
+	c[4] = s->gyro.x; c[5] = s->gyro.y; c[6] = s->gyro.z;
+}
+
+// ===============
+// === Encoder ===
+// ===============
+void gy521_delta_init(gy521_delta_encoder_t *e, uint16_t accel_lsb, uint16_t gyro_lsb){
+	memset(e, 0, sizeof(*e));
+	for(uint8_t a = 0; a < 3; a++){
+		e->conf.deadband[a] = accel_lsb;
+		e->conf.deadband[4 + a] = gyro_lsb;
+	}
+	e->conf.deadband[3] = 34; // 0.1 °C
+	e->conf.keyframe = GY521_DELTA_KEYFRAME;
+	e->conf.heartbeat_us = GY521_DELTA_HEARTBEAT_US;
+}
+
+void gy521_delta_key(gy521_delta_encoder_t *e){
+	e->priv.started = false;
+}
+
+uint8_t gy521_delta_encode_frame(gy521_delta_encoder_t *e, const gy521_frame_t *frame, uint8_t *out){
+	if(!e || !frame || !out) return 0;
+	e->stat.samples++;
+
+	int16_t c[7];
+	gy521_delta_channels(&frame->sample, c);
+
+	// Channels outside their deadband
+	uint8_t mask = 0;
+	for(uint8_t ch = 0; ch < 7; ch++){
+		int32_t diff = (int32_t)c[ch] - e->priv.last[ch];
+		if(diff < 0) diff = -diff;
+		if(diff > e->conf.deadband[ch]) mask |= 1 << ch;
+	}
+
+	const uint64_t dt = frame->timestamp_us - e->priv.timestamp_us;
+	bool key = !e->priv.started || e->priv.since_key + 1u >= e->conf.keyframe || dt > UINT32_MAX;
+	if(!key && !mask && !(e->conf.heartbeat_us && dt >= e->conf.heartbeat_us)) return 0;
+	if(key) mask = 0xff;
+
+	uint8_t n = 0;
+	out[n++] = GY521_DELTA_SYNC;
+	out[n++] = mask;
+	out[n++] = e->priv.count++;
+	if(key){
+		gy521_delta_put32(&out[n], frame->seq);
+		gy521_delta_put32(&out[n + 4], (uint32_t)frame->timestamp_us);
+		n += 8;
+		for(uint8_t ch = 0; ch < 7; ch++, n += 2) gy521_delta_put16(&out[n], (uint16_t)c[ch]);
+		e->priv.since_key = 0;
+		e->stat.keyframes++;
+	}else{
+		n += gy521_delta_varint(&out[n], frame->seq - e->priv.seq);
+		n += gy521_delta_varint(&out[n], (uint32_t)dt);
+		for(uint8_t ch = 0; ch < 7; ch++){
+			if(!(mask & (1 << ch))) continue;
+			const int32_t diff = (int32_t)c[ch] - e->priv.last[ch];
+			n += gy521_delta_varint(&out[n], ((uint32_t)diff << 1) ^ -(uint32_t)(diff < 0)); // Zigzag
+		}
+		e->priv.since_key++;
+	}
+	gy521_delta_put16(&out[n], gy521_telemetry_crc16(&out[1], n - 1));
+	n += 2;
+
+	for(uint8_t ch = 0; ch < 7; ch++)
+		if(mask & (1 << ch)) e->priv.last[ch] = c[ch];
+	e->priv.seq = frame->seq;
+	e->priv.timestamp_us = frame->timestamp_us;
+	e->priv.started = true;
+	e->stat.packets++;
+	e->stat.bytes += n;
+	return n;
+}
+
+uint8_t gy521_delta_encode(gy521_delta_encoder_t *e, const gy521_s *dev, uint8_t *out){
+	if(!dev) return 0;
+
+	const gy521_frame_t frame = {
+		.timestamp_us = dev->v.timestamp_us,
+		.seq = dev->v.seq,
+		.sample = {
+			.accel = dev->v.accel.raw,
+			.temp = dev->v.temp.raw,
+			.gyro = dev->v.gyro.raw,
+		},
+	};
+	return gy521_delta_encode_frame(e, &frame, out);
+}
+
+// ===============
+// === Decoder ===
+// ===============
+void gy521_delta_decoder_init(gy521_delta_decoder_t *d){
+	memset(d, 0, sizeof(*d));
+}
+
+// Size of the packet in buf: 0 = more bytes needed, -1 = not a packet
+static int8_t gy521_delta_size(const gy521_delta_decoder_t *d){
+	if(d->len < 2) return 0;
+	const uint8_t mask = d->buf[1];
+	if(mask & GY521_DELTA_KEY) return mask == 0xff ? GY521_DELTA_KEY_SIZE : -1;
+
+	uint8_t n = 3;
+	for(uint8_t field = 0; field < 9; field++){
+		if(field >= 2 && !(mask & (1 << (field - 2)))) continue;
+		const int8_t len = gy521_delta_varint_len(&d->buf[n], d->len > n ? d->len - n : 0, field < 2 ? 5 : 3);
+		if(len <= 0) return len;
+		n += len;
+	}
+	return (int8_t)(n + 2);
+}
+
+// Drops the buffered bytes up to the next possible sync byte
+static void gy521_delta_resync(gy521_delta_decoder_t *d){
+	uint8_t i = 1;
+	while(i < d->len && d->buf[i] != GY521_DELTA_SYNC) i++;
+
+	memmove(d->buf, &d->buf[i], d->len - i);
+	d->len -= i;
+	d->stat.skipped += i;
+}
+
+// Applies the valid packet at the start of buf
+static bool gy521_delta_apply(gy521_delta_decoder_t *d, gy521_frame_t *out){
+	const uint8_t mask = d->buf[1], count = d->buf[2];
+	const uint8_t *p = &d->buf[3];
+
+	d->gap = d->started ? (uint8_t)(count - d->count - 1) : 0;
+	if(d->gap) d->synced = false;
+	d->stat.lost += d->gap;
+	d->count = count;
+	d->started = true;
+
+	if(mask & GY521_DELTA_KEY){
+		const uint32_t time = gy521_delta_get32(p + 4);
+		d->seq = gy521_delta_get32(p);
+		d->timestamp_us = d->stat.keyframes ? d->timestamp_us + (uint32_t)(time - (uint32_t)d->timestamp_us) : time;
+		for(uint8_t ch = 0; ch < 7; ch++) d->last[ch] = (int16_t)(p[8 + 2 * ch] | (p[9 + 2 * ch] << 8));
+		d->synced = true;
+		d->stat.keyframes++;
+	}else{
+		if(!d->synced){
+			d->stat.unsynced++;
+			return false;
+		}
+		d->seq += gy521_delta_varint_get(&p);
+		d->timestamp_us += gy521_delta_varint_get(&p);
+		for(uint8_t ch = 0; ch < 7; ch++){
+			if(!(mask & (1 << ch))) continue;
+			const uint32_t zz = gy521_delta_varint_get(&p);
+			d->last[ch] = (int16_t)(d->last[ch] + (int32_t)((zz >> 1) ^ -(zz & 1)));
+		}
+	}
+	d->stat.packets++;
+
+	const int16_t *c = d->last;
+	out->sample = (gy521_sample_t){
+		.accel = {c[0], c[1], c[2]},
+		.temp = c[3],
+		.gyro = {c[4], c[5], c[6]},
+	};
+	out->seq = d->seq;
+	out->timestamp_us = d->timestamp_us;
+	return true;
+}
+
+bool gy521_delta_decode(gy521_delta_decoder_t *d, uint8_t byte, gy521_frame_t *out){
+	if(d->len >= sizeof(d->buf)) gy521_delta_resync(d);
+	d->buf[d->len++] = byte;
+
+	while(d->len){
+		if(d->buf[0] != GY521_DELTA_SYNC){
+			gy521_delta_resync(d);
+			continue;
+		}
+
+		const int8_t size = gy521_delta_size(d);
+		if(!size || (size > 0 && d->len < size)) return false; // Incomplete
+		if(size < 0 || gy521_telemetry_crc16(&d->buf[1], size - 3) != (uint16_t)(d->buf[size - 2] | (d->buf[size - 1] << 8))){
+			if(size > 0) d->stat.crc_errors++;
+			gy521_delta_resync(d);
+			continue;
+		}
+
+		const bool applied = gy521_delta_apply(d, out);
+		d->len -= size;
+		memmove(d->buf, &d->buf[size], d->len); // Left over after a resync: next call
+		if(applied) return true;
+	}
+	return false;
+}
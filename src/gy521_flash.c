@@ -0,0 +1,341 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_flash.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Calibration + configuration records in a wear-levelled flash
+ *  log, see gy521_flash.h for the format.
+ *
+ *  One field list (gy521_flash_fields) serves both directions, so
+ *  save and load cannot disagree on the layout. Change it, and
+ *  GY521_FLASH_VERSION goes up.
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "gy521_flash.h"
+#include "gy521_telemetry.h" // CRC-16
+
+#define GY521_FLASH_MAGIC0 'G'
+#define GY521_FLASH_MAGIC1 'Y'
+#define GY521_FLASH_HEADER 11
+#define GY521_FLASH_RECORD_MAX 128 // Bytes of a record kept on the stack (payload today: ~70)
+#define GY521_FLASH_PAYLOAD_MAX (GY521_FLASH_RECORD_MAX - GY521_FLASH_HEADER - 2)
+#define GY521_FLASH_SLOTS_PER_SECTOR (GY521_FLASH_SECTOR / GY521_FLASH_PAGE)
+
+// ===============
+// === Helpers ===
+// ===============
+static void gy521_flash_put16(uint8_t *p, uint16_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t gy521_flash_get16(const uint8_t *p){
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t gy521_flash_get32(const uint8_t *p){
+	return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void gy521_flash_put32(uint8_t *p, uint32_t v){
+	for(uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// ===============
+// === Payload ===
+// ===============
+typedef struct{
+	uint8_t *p;
+	uint8_t n;
+	bool load; // p -> conf, else conf -> p
+} gy521_flash_codec_t;
+
+static void gy521_flash_u8(gy521_flash_codec_t *c, uint8_t *v){
+	if(c->load) *v = c->p[c->n];
+	else c->p[c->n] = *v;
+	c->n++;
+}
+
+static void gy521_flash_bool(gy521_flash_codec_t *c, bool *v){
+	uint8_t b = *v;
+	gy521_flash_u8(c, &b);
+	*v = b != 0;
+}
+
+static void gy521_flash_u16(gy521_flash_codec_t *c, uint16_t *v){
+	if(c->load) *v = gy521_flash_get16(&c->p[c->n]);
+	else gy521_flash_put16(&c->p[c->n], *v);
+	c->n += 2;
+}
+
+// Offsets are register values: 16 bit
+static void gy521_flash_offset(gy521_flash_codec_t *c, gy521_offset_t *o){
+	int32_t *v = &o->x;
+	for(uint8_t k = 0; k < 3; k++){
+		uint16_t u = (uint16_t)(int16_t)v[k];
+		gy521_flash_u16(c, &u);
+		v[k] = (int16_t)u;
+	}
+}
+
+// Every persistent conf field, in record order
+static uint8_t gy521_flash_fields(gy521_flash_codec_t *c, gy521_s *dev){
+	gy521_flash_bool(c, &dev->conf.sleep);
+	gy521_flash_u8(c, &dev->conf.clksel);
+	gy521_flash_bool(c, &dev->conf.scaled);
+	gy521_flash_bool(c, &dev->conf.fixed);
+
+	uint16_t int_pin = (uint16_t)(int16_t)dev->conf.int_pin;
+	gy521_flash_u16(c, &int_pin);
+	dev->conf.int_pin = (int16_t)int_pin;
+
+	gy521_flash_u8(c, &dev->conf.accel.fsr);
+	gy521_flash_offset(c, &dev->conf.accel.offset);
+	gy521_flash_bool(c, &dev->conf.accel.x.stby);
+	gy521_flash_bool(c, &dev->conf.accel.y.stby);
+	gy521_flash_bool(c, &dev->conf.accel.z.stby);
+	gy521_flash_bool(c, &dev->conf.temp.sleep);
+
+	gy521_flash_u8(c, &dev->conf.gyro.fsr);
+	gy521_flash_offset(c, &dev->conf.gyro.offset);
+	gy521_flash_bool(c, &dev->conf.gyro.x.clksel);
+	gy521_flash_bool(c, &dev->conf.gyro.x.stby);
+	gy521_flash_bool(c, &dev->conf.gyro.y.clksel);
+	gy521_flash_bool(c, &dev->conf.gyro.y.stby);
+	gy521_flash_bool(c, &dev->conf.gyro.z.clksel);
+	gy521_flash_bool(c, &dev->conf.gyro.z.stby);
+
+	gy521_flash_u8(c, &dev->conf.rate.div);
+	gy521_flash_u8(c, &dev->conf.rate.dlpf);
+	gy521_flash_bool(c, &dev->conf.rate.pace);
+
+	gy521_flash_bool(c, &dev->conf.power.cycle);
+	gy521_flash_u8(c, &dev->conf.power.lp_wake);
+	gy521_flash_bool(c, &dev->conf.power.auto_cycle);
+	gy521_flash_u16(c, &dev->conf.power.idle_ms);
+	gy521_flash_u8(c, &dev->conf.motion.threshold);
+	gy521_flash_u8(c, &dev->conf.motion.duration);
+
+	gy521_flash_bool(c, &dev->conf.fifo.enable);
+	gy521_flash_bool(c, &dev->conf.fifo.accel);
+	gy521_flash_bool(c, &dev->conf.fifo.temp);
+	gy521_flash_bool(c, &dev->conf.fifo.gyro);
+
+	gy521_flash_bool(c, &dev->conf.aux.enable);
+	gy521_flash_bool(c, &dev->conf.aux.bypass);
+	gy521_flash_u8(c, &dev->conf.aux.clk);
+	for(uint8_t i = 0; i < GY521_AUX_SLAVES; i++){
+		gy521_flash_u8(c, &dev->conf.aux.slv[i].addr);
+		gy521_flash_u8(c, &dev->conf.aux.slv[i].reg);
+		gy521_flash_u8(c, &dev->conf.aux.slv[i].len);
+		gy521_flash_u8(c, &dev->conf.aux.slv[i].out);
+		gy521_flash_bool(c, &dev->conf.aux.slv[i].swap);
+	}
+
+	gy521_flash_bool(c, &dev->conf.async.enable);
+	gy521_flash_bool(c, &dev->conf.interrupt.data_ready);
+	gy521_flash_bool(c, &dev->conf.interrupt.motion);
+	gy521_flash_u8(c, &dev->conf.recover.after);
+	return c->n;
+}
+
+// =============
+// === Slots ===
+// =============
+typedef struct{
+	uint8_t addr;
+	uint16_t slot;
+	uint32_t seq;
+} gy521_flash_key_t;
+
+typedef struct{
+	gy521_flash_key_t key[GY521_FLASH_KEYS];
+	uint8_t keys;
+	bool any; // newest valid
+	uint16_t newest; // Slot of the highest seq
+	uint32_t seq;
+} gy521_flash_scan_t;
+
+static uint16_t gy521_flash_slots(const gy521_flash_t *flash){
+	return (uint16_t)(flash->sectors * GY521_FLASH_SLOTS_PER_SECTOR);
+}
+
+static uint32_t gy521_flash_addr(const gy521_flash_t *flash, uint16_t slot){
+	return flash->offset + (uint32_t)slot * GY521_FLASH_PAGE;
+}
+
+// Record in 'slot' into rec, its size, 0 = empty or not valid (rec[0..1] = 0xFF: never written)
+static uint16_t gy521_flash_record(gy521_flash_t *flash, uint16_t slot, uint8_t *rec){
+	rec[0] = rec[1] = 0xFF;
+	if(!flash->read(flash->ctx, gy521_flash_addr(flash, slot), rec, GY521_FLASH_HEADER)) return 0;
+	if(rec[0] != GY521_FLASH_MAGIC0 || rec[1] != GY521_FLASH_MAGIC1) return 0;
+	if(rec[2] != GY521_FLASH_VERSION || gy521_flash_get16(&rec[4]) != flash->tag) return 0;
+
+	const uint16_t size = GY521_FLASH_HEADER + rec[10] + 2;
+	if(rec[10] > GY521_FLASH_PAYLOAD_MAX) return 0;
+	if(!flash->read(flash->ctx, gy521_flash_addr(flash, slot) + GY521_FLASH_HEADER, &rec[GY521_FLASH_HEADER], size - GY521_FLASH_HEADER)) return 0;
+	if(gy521_telemetry_crc16(rec, size - 2) != gy521_flash_get16(&rec[size - 2])) return 0;
+	return size;
+}
+
+static bool gy521_flash_erased(gy521_flash_t *flash, uint16_t slot){
+	uint8_t chunk[32];
+	for(uint16_t at = 0; at < GY521_FLASH_PAGE; at += sizeof(chunk)){
+		if(!flash->read(flash->ctx, gy521_flash_addr(flash, slot) + at, chunk, sizeof(chunk))) return false;
+		for(uint8_t i = 0; i < sizeof(chunk); i++)
+			if(chunk[i] != 0xFF) return false;
+	}
+	return true;
+}
+
+// Newest valid record per address and overall
+static void gy521_flash_scan(gy521_flash_t *flash, gy521_flash_scan_t *s){
+	uint8_t rec[GY521_FLASH_RECORD_MAX];
+	*s = (gy521_flash_scan_t){0};
+	flash->stat.invalid = 0;
+
+	for(uint16_t slot = 0; slot < gy521_flash_slots(flash); slot++){
+		if(!gy521_flash_record(flash, slot, rec)){
+			if(rec[0] != 0xFF || rec[1] != 0xFF) flash->stat.invalid++;
+			continue;
+		}
+		const uint32_t seq = gy521_flash_get32(&rec[6]);
+		if(!s->any || (int32_t)(seq - s->seq) > 0){
+			s->any = true;
+			s->newest = slot;
+			s->seq = seq;
+		}
+
+		uint8_t k = 0;
+		while(k < s->keys && s->key[k].addr != rec[3]) k++;
+		if(k == s->keys){
+			if(s->keys == GY521_FLASH_KEYS) continue;
+			s->keys++;
+		}else if((int32_t)(seq - s->key[k].seq) <= 0) continue;
+		s->key[k] = (gy521_flash_key_t){.addr = rec[3], .slot = slot, .seq = seq};
+	}
+}
+
+static const gy521_flash_key_t *gy521_flash_find(const gy521_flash_scan_t *s, uint8_t addr){
+	for(uint8_t k = 0; k < s->keys; k++)
+		if(s->key[k].addr == addr) return &s->key[k];
+	return NULL;
+}
+
+// Programs record 'rec' (size bytes, seq + CRC filled in here) into 'slot'
+static bool gy521_flash_write(gy521_flash_t *flash, uint16_t slot, uint8_t *rec, uint16_t size, uint32_t seq){
+	uint8_t page[GY521_FLASH_PAGE];
+	gy521_flash_put32(&rec[6], seq);
+	gy521_flash_put16(&rec[size - 2], gy521_telemetry_crc16(rec, size - 2));
+	memcpy(page, rec, size);
+	memset(&page[size], 0xFF, GY521_FLASH_PAGE - size);
+
+	flash->stat.programs++;
+	return flash->program(flash->ctx, gy521_flash_addr(flash, slot), page);
+}
+
+// ============
+// === Save ===
+// ============
+bool gy521_flash_save(gy521_flash_t *flash, gy521_s *dev){
+	if(!flash || !dev || flash->sectors < 2) return false;
+	if(!dev->priv.offsets_known && !gy521_get_offsets(dev)) return false;
+
+	uint8_t rec[GY521_FLASH_RECORD_MAX];
+	gy521_flash_codec_t c = {.p = &rec[GY521_FLASH_HEADER], .load = false};
+	const uint8_t len = gy521_flash_fields(&c, dev);
+	rec[0] = GY521_FLASH_MAGIC0;
+	rec[1] = GY521_FLASH_MAGIC1;
+	rec[2] = GY521_FLASH_VERSION;
+	rec[3] = dev->conf.addr;
+	gy521_flash_put16(&rec[4], flash->tag);
+	rec[10] = len;
+
+	gy521_flash_scan_t s;
+	gy521_flash_scan(flash, &s);
+
+	// Same as stored: no wear
+	uint8_t old[GY521_FLASH_RECORD_MAX];
+	const gy521_flash_key_t *own = gy521_flash_find(&s, dev->conf.addr);
+	if(own && gy521_flash_record(flash, own->slot, old) && old[10] == len && !memcmp(&old[GY521_FLASH_HEADER], &rec[GY521_FLASH_HEADER], len)){
+		flash->stat.unchanged++;
+		return true;
+	}
+	if(!own && s.keys == GY521_FLASH_KEYS) return false;
+
+	// Next erased slot after the newest record, a new sector starts with an erase
+	const uint16_t slots = gy521_flash_slots(flash);
+	uint16_t slot = s.any ? (s.newest + 1) % slots : 0;
+	while(slot % GY521_FLASH_SLOTS_PER_SECTOR && !gy521_flash_erased(flash, slot)) slot = (slot + 1) % slots;
+
+	uint32_t seq = s.seq + 1;
+	if(slot % GY521_FLASH_SLOTS_PER_SECTOR == 0){
+		// Carried records are read before the erase: one of them may live in this sector
+		uint8_t carry[GY521_FLASH_KEYS - 1][GY521_FLASH_RECORD_MAX];
+		uint16_t size[GY521_FLASH_KEYS - 1];
+		uint8_t n = 0;
+		for(uint8_t k = 0; k < s.keys; k++){
+			if(s.key[k].addr == dev->conf.addr) continue;
+			size[n] = gy521_flash_record(flash, s.key[k].slot, carry[n]);
+			if(size[n]) n++;
+		}
+
+		flash->stat.erases++;
+		if(!flash->erase(flash->ctx, gy521_flash_addr(flash, slot))) return false;
+		for(uint8_t i = 0; i < n; i++)
+			if(!gy521_flash_write(flash, slot++, carry[i], size[i], seq++)) return false;
+	}
+
+	return gy521_flash_write(flash, slot, rec, GY521_FLASH_HEADER + len + 2, seq);
+}
+
+// ============
+// === Load ===
+// ============
+bool gy521_flash_load(gy521_flash_t *flash, gy521_s *dev){
+	if(!flash || !dev) return false;
+
+	gy521_flash_scan_t s;
+	gy521_flash_scan(flash, &s);
+	const gy521_flash_key_t *own = gy521_flash_find(&s, dev->conf.addr);
+	if(!own) return false;
+
+	uint8_t rec[GY521_FLASH_RECORD_MAX];
+	if(!gy521_flash_record(flash, own->slot, rec)) return false;
+
+	// Layout check before anything is touched (another field list has another length)
+	uint8_t scratch[GY521_FLASH_PAYLOAD_MAX];
+	gy521_flash_codec_t size = {.p = scratch, .load = false};
+	if(gy521_flash_fields(&size, dev) != rec[10]) return false;
+
+	gy521_flash_codec_t c = {.p = &rec[GY521_FLASH_HEADER], .load = true};
+	gy521_flash_fields(&c, dev);
+	return true;
+}
+
+bool gy521_flash_restore(gy521_flash_t *flash, gy521_s *dev){
+	if(!gy521_flash_load(flash, dev)) return false;
+	if(!dev->fn.commit(dev) || !dev->fn.offsets.set(dev)) return false;
+	if(dev->conf.fifo.enable && !dev->fn.fifo.set(dev)) return false;
+	if((dev->conf.aux.enable || dev->conf.aux.bypass) && !dev->fn.aux.set(dev)) return false;
+	if((dev->conf.interrupt.data_ready || dev->conf.interrupt.motion) && !dev->fn.interrupt(dev)) return false;
+	return true;
+}
+
+bool gy521_flash_erase(gy521_flash_t *flash){
+	if(!flash) return false;
+	for(uint16_t i = 0; i < flash->sectors; i++){
+		flash->stat.erases++;
+		if(!flash->erase(flash->ctx, flash->offset + (uint32_t)i * GY521_FLASH_SECTOR)) return false;
+	}
+	return true;
+}
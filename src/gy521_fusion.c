@@ -0,0 +1,446 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_fusion.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Madgwick, Mahony and complementary filter, each in float and
+ *  in Q8.24 fixed-point.
+ *
+ *  Fixed-point notes:
+ *  - Quaternion, gyro (rad/s), dt (s) and gains are Q8.24,
+ *    products use a 64-bit intermediate
+ *  - Vectors are normalized with an integer square root and one
+ *    division per vector, no float anywhere
+ *  - atan2/sin/cos are polynomials (error < 1e-5 rad)
+ *
+ * ================================================================
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521_fusion.h"
+
+#define GY521_FUSION_PI 3.14159265f
+
+// =========================
+// === Q8.24 Fixed-point ===
+// =========================
+#define Q24_ONE GY521_FUSION_ONE
+#define Q24_PI 52707179
+#define Q24_PI_2 26353589
+#define Q24(x) ((int32_t)((x) * Q24_ONE + ((x) < 0 ? -0.5 : 0.5))) // Constants only
+
+// rad/s per LSB in Q0.32 for FSR bits 4:3, result >> 8 = Q8.24
+static const int32_t g_gy521_fusion_gyro_rad[4] = {572224, 1144448, 2288895, 4577791};
+
+static inline int32_t q24_mul(int32_t a, int32_t b){
+	return (int32_t)(((int64_t)a * b) >> 24);
+}
+
+// µs -> s in Q8.24 (2^24 / 10^6 in Q16)
+static inline int32_t q24_from_us(uint32_t us){
+	return (int32_t)(((uint64_t)us * 1099512u) >> 16);
+}
+
+// rad (Q8.24) -> milli-degrees
+static inline int32_t q24_to_mdeg(int32_t rad){
+	return (int32_t)(((int64_t)rad * 14667720) >> 32);
+}
+
+static uint32_t q24_isqrt(uint64_t x){
+	uint64_t r = 0, bit = (uint64_t)1 << 62;
+	while(bit > x) bit >>= 2;
+	while(bit){
+		if(x >= r + bit){
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		}else r >>= 1;
+		bit >>= 2;
+	}
+	return (uint32_t)r;
+}
+
+// Scales v[0..n-1] (any common unit) to length 1.0 in Q8.24, false if zero
+static bool q24_normalize(int32_t *v, uint8_t n){
+	uint64_t sum = 0;
+	for(uint8_t i = 0; i < n; i++) sum += (uint64_t)((int64_t)v[i] * v[i]);
+
+	uint32_t norm = q24_isqrt(sum);
+	if(!norm) return false;
+
+	// |v[i]| <= norm, so v[i] * k stays below 2^48
+	int64_t k = ((int64_t)1 << 48) / norm;
+	for(uint8_t i = 0; i < n; i++) v[i] = (int32_t)((v[i] * k) >> 24);
+	return true;
+}
+
+// Keeps an angle in [-pi, pi)
+static inline int32_t q24_wrap(int32_t a){
+	if(a >= Q24_PI) a -= 2 * Q24_PI;
+	else if(a < -Q24_PI) a += 2 * Q24_PI;
+	return a;
+}
+
+static int32_t q24_atan2(int32_t y, int32_t x){
+	uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+	uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+	if(!ax && !ay) return 0;
+
+	// atan(z), z = min / max in [0, 1]
+	bool swap = ay > ax;
+	int32_t z = (int32_t)(((uint64_t)(swap ? ax : ay) << 24) / (swap ? ay : ax));
+	int32_t z2 = q24_mul(z, z);
+	int32_t p = 349555; // 0.0208351
+	p = -1428295 + q24_mul(z2, p); // -0.0851330
+	p = 3022264 + q24_mul(z2, p); // 0.1801410
+	p = -5541506 + q24_mul(z2, p); // -0.3302995
+	p = 16774968 + q24_mul(z2, p); // 0.9998660
+	int32_t a = q24_mul(z, p);
+
+	if(swap) a = Q24_PI_2 - a;
+	if(x < 0) a = Q24_PI - a;
+	return y < 0 ? -a : a;
+}
+
+// sin / cos for |x| <= pi/2 (Taylor, Horner form)
+static int32_t q24_sin(int32_t x){
+	int32_t x2 = q24_mul(x, x);
+	int32_t p = Q24_ONE - q24_mul(x2, Q24(1.0 / 72));
+	p = Q24_ONE - q24_mul(q24_mul(x2, Q24(1.0 / 42)), p);
+	p = Q24_ONE - q24_mul(q24_mul(x2, Q24(1.0 / 20)), p);
+	p = Q24_ONE - q24_mul(q24_mul(x2, Q24(1.0 / 6)), p);
+	return q24_mul(x, p);
+}
+
+static int32_t q24_cos(int32_t x){
+	int32_t x2 = q24_mul(x, x);
+	int32_t p = Q24_ONE - q24_mul(x2, Q24(1.0 / 90));
+	p = Q24_ONE - q24_mul(q24_mul(x2, Q24(1.0 / 56)), p);
+	p = Q24_ONE - q24_mul(q24_mul(x2, Q24(1.0 / 30)), p);
+	p = Q24_ONE - q24_mul(q24_mul(x2, Q24(1.0 / 12)), p);
+	return Q24_ONE - q24_mul(x2 >> 1, p);
+}
+
+// sin and cos for |x| <= pi
+static void q24_sincos(int32_t x, int32_t *s, int32_t *c){
+	if(x > Q24_PI_2){
+		*s = q24_sin(Q24_PI - x);
+		*c = -q24_cos(Q24_PI - x);
+	}else if(x < -Q24_PI_2){
+		*s = q24_sin(-Q24_PI - x);
+		*c = -q24_cos(-Q24_PI - x);
+	}else{
+		*s = q24_sin(x);
+		*c = q24_cos(x);
+	}
+}
+
+// ============================
+// === Init / Configuration ===
+// ============================
+void gy521_fusion_init(gy521_fusion_t *f, uint8_t algo, bool fixed){
+	*f = (gy521_fusion_t){0};
+	f->conf.algo = algo;
+	f->conf.fixed = fixed;
+	f->conf.beta = 0.1f;
+	f->conf.kp = 1.0f;
+	f->conf.ki = 0.0f;
+	f->conf.tau = 0.5f;
+
+	gy521_fusion_set(f);
+	gy521_fusion_reset(f);
+}
+
+void gy521_fusion_set(gy521_fusion_t *f){
+	f->priv.beta = (int32_t)(f->conf.beta * Q24_ONE);
+	f->priv.kp = (int32_t)(f->conf.kp * Q24_ONE);
+	f->priv.ki = (int32_t)(f->conf.ki * Q24_ONE);
+	f->priv.inv_tau = f->conf.tau > 0.0f ? (int32_t)(Q24_ONE / f->conf.tau) : Q24_ONE;
+}
+
+void gy521_fusion_reset(gy521_fusion_t *f){
+	for(uint8_t i = 0; i < 3; i++){
+		f->priv.integral[i] = f->priv.angle[i] = 0.0f;
+		f->priv.integralf[i] = f->priv.anglef[i] = 0;
+	}
+	f->priv.q[0] = 1.0f;
+	f->priv.q[1] = f->priv.q[2] = f->priv.q[3] = 0.0f;
+	f->priv.qf[0] = Q24_ONE;
+	f->priv.qf[1] = f->priv.qf[2] = f->priv.qf[3] = 0;
+	f->priv.started = false;
+
+	f->v.q = (gy521_quat_t){1.0f, 0.0f, 0.0f, 0.0f};
+	f->v.q_fixed = (gy521_quat_fixed_t){Q24_ONE, 0, 0, 0};
+	f->v.deg = (gy521_euler_t){0};
+	f->v.mdeg = (gy521_euler_fixed_t){0};
+}
+
+// ===================
+// === Float Paths ===
+// ===================
+// q += q * (0, h), h = gyro * dt / 2, then normalize
+static void gy521_fusion_integrate(float *q, float hx, float hy, float hz, const float *corr){
+	float d0 = -q[1] * hx - q[2] * hy - q[3] * hz;
+	float d1 = q[0] * hx + q[2] * hz - q[3] * hy;
+	float d2 = q[0] * hy - q[1] * hz + q[3] * hx;
+	float d3 = q[0] * hz + q[1] * hy - q[2] * hx;
+
+	q[0] += d0 - (corr ? corr[0] : 0.0f);
+	q[1] += d1 - (corr ? corr[1] : 0.0f);
+	q[2] += d2 - (corr ? corr[2] : 0.0f);
+	q[3] += d3 - (corr ? corr[3] : 0.0f);
+
+	float n = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for(uint8_t i = 0; i < 4; i++) q[i] /= n;
+}
+
+static void gy521_fusion_float(gy521_fusion_t *f, const gy521_sample_t *s, uint8_t gyro_fsr, float dt){
+	float *q = f->priv.q;
+	float gk = (GY521_FUSION_PI / 180.0f) / (131.0f / (1 << ((gyro_fsr >> 3) & 0x03))); // rad/s per LSB
+	float gx = s->gyro.x * gk, gy = s->gyro.y * gk, gz = s->gyro.z * gk;
+	float ax = s->accel.x, ay = s->accel.y, az = s->accel.z;
+	float an = sqrtf(ax * ax + ay * ay + az * az);
+	bool accel = an > 0.0f;
+	if(accel){
+		ax /= an;
+		ay /= an;
+		az /= an;
+	}
+
+	if(f->conf.algo == GY521_FUSION_MADGWICK){
+		float c[4] = {0};
+		if(accel){
+			// Gradient of the gravity error (Madgwick, IMU form)
+			float q0q0 = q[0] * q[0], q1q1 = q[1] * q[1], q2q2 = q[2] * q[2], q3q3 = q[3] * q[3];
+			c[0] = 4.0f * q[0] * q2q2 + 2.0f * q[2] * ax + 4.0f * q[0] * q1q1 - 2.0f * q[1] * ay;
+			c[1] = 4.0f * q[1] * q3q3 - 2.0f * q[3] * ax + 4.0f * q0q0 * q[1] - 2.0f * q[0] * ay - 4.0f * q[1] + 8.0f * q[1] * q1q1 + 8.0f * q[1] * q2q2 + 4.0f * q[1] * az;
+			c[2] = 4.0f * q0q0 * q[2] + 2.0f * q[0] * ax + 4.0f * q[2] * q3q3 - 2.0f * q[3] * ay - 4.0f * q[2] + 8.0f * q[2] * q1q1 + 8.0f * q[2] * q2q2 + 4.0f * q[2] * az;
+			c[3] = 4.0f * q1q1 * q[3] - 2.0f * q[1] * ax + 4.0f * q2q2 * q[3] - 2.0f * q[2] * ay;
+
+			float n = sqrtf(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+			if(n > 0.0f) for(uint8_t i = 0; i < 4; i++) c[i] *= f->conf.beta * dt / n;
+		}
+		gy521_fusion_integrate(q, gx * 0.5f * dt, gy * 0.5f * dt, gz * 0.5f * dt, c);
+
+	}else if(f->conf.algo == GY521_FUSION_MAHONY){
+		if(accel){
+			// Error = measured x estimated gravity direction
+			float vx = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+			float vy = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+			float vz = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+			float ex = ay * vz - az * vy, ey = az * vx - ax * vz, ez = ax * vy - ay * vx;
+
+			if(f->conf.ki > 0.0f){
+				f->priv.integral[0] += f->conf.ki * ex * dt;
+				f->priv.integral[1] += f->conf.ki * ey * dt;
+				f->priv.integral[2] += f->conf.ki * ez * dt;
+				gx += f->priv.integral[0];
+				gy += f->priv.integral[1];
+				gz += f->priv.integral[2];
+			}
+			gx += f->conf.kp * ex;
+			gy += f->conf.kp * ey;
+			gz += f->conf.kp * ez;
+		}
+		gy521_fusion_integrate(q, gx * 0.5f * dt, gy * 0.5f * dt, gz * 0.5f * dt, NULL);
+
+	}else{
+		float *a = f->priv.angle;
+		float k = f->conf.tau > 0.0f ? dt / f->conf.tau : 1.0f;
+		// Body rates -> Euler angle rates (pitch kept off +-90°)
+		float sr = sinf(a[0]), cr = cosf(a[0]), cp = cosf(a[1]);
+		if(cp < 0.01f) cp = 0.01f;
+		float yz = (sr * gy + cr * gz) / cp;
+		a[0] += (gx + yz * sinf(a[1])) * dt;
+		a[1] += (cr * gy - sr * gz) * dt;
+		a[2] = remainderf(a[2] + yz * dt, 2.0f * GY521_FUSION_PI);
+		if(accel){
+			// Blend the difference, wrap-safe at +-180°
+			a[0] += k * remainderf(atan2f(ay, az) - a[0], 2.0f * GY521_FUSION_PI);
+			a[1] += k * (atan2f(-ax, sqrtf(ay * ay + az * az)) - a[1]);
+		}
+		a[0] = remainderf(a[0], 2.0f * GY521_FUSION_PI);
+
+		// Euler (ZYX) -> quaternion from the half angles
+		float c0 = cosf(a[0] * 0.5f), s0 = sinf(a[0] * 0.5f);
+		float c1 = cosf(a[1] * 0.5f), s1 = sinf(a[1] * 0.5f);
+		float c2 = cosf(a[2] * 0.5f), s2 = sinf(a[2] * 0.5f);
+		q[0] = c0 * c1 * c2 + s0 * s1 * s2;
+		q[1] = s0 * c1 * c2 - c0 * s1 * s2;
+		q[2] = c0 * s1 * c2 + s0 * c1 * s2;
+		q[3] = c0 * c1 * s2 - s0 * s1 * c2;
+	}
+
+	f->v.q = (gy521_quat_t){q[0], q[1], q[2], q[3]};
+	if(f->conf.algo == GY521_FUSION_COMPLEMENTARY){
+		f->v.deg.roll = f->priv.angle[0] * (180.0f / GY521_FUSION_PI);
+		f->v.deg.pitch = f->priv.angle[1] * (180.0f / GY521_FUSION_PI);
+		f->v.deg.yaw = f->priv.angle[2] * (180.0f / GY521_FUSION_PI);
+	}else{
+		float sinp = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+		if(sinp > 1.0f) sinp = 1.0f;
+		else if(sinp < -1.0f) sinp = -1.0f;
+		f->v.deg.roll = atan2f(2.0f * (q[0] * q[1] + q[2] * q[3]), 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2])) * (180.0f / GY521_FUSION_PI);
+		f->v.deg.pitch = asinf(sinp) * (180.0f / GY521_FUSION_PI);
+		f->v.deg.yaw = atan2f(2.0f * (q[0] * q[3] + q[1] * q[2]), 1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3])) * (180.0f / GY521_FUSION_PI);
+	}
+}
+
+// =========================
+// === Fixed-point Paths ===
+// =========================
+static void gy521_fusion_integrate_fixed(int32_t *q, int32_t hx, int32_t hy, int32_t hz, const int32_t *corr){
+	int32_t d0 = -q24_mul(q[1], hx) - q24_mul(q[2], hy) - q24_mul(q[3], hz);
+	int32_t d1 = q24_mul(q[0], hx) + q24_mul(q[2], hz) - q24_mul(q[3], hy);
+	int32_t d2 = q24_mul(q[0], hy) - q24_mul(q[1], hz) + q24_mul(q[3], hx);
+	int32_t d3 = q24_mul(q[0], hz) + q24_mul(q[1], hy) - q24_mul(q[2], hx);
+
+	q[0] += d0 - (corr ? corr[0] : 0);
+	q[1] += d1 - (corr ? corr[1] : 0);
+	q[2] += d2 - (corr ? corr[2] : 0);
+	q[3] += d3 - (corr ? corr[3] : 0);
+	q24_normalize(q, 4);
+}
+
+static void gy521_fusion_fixed(gy521_fusion_t *f, const gy521_sample_t *s, uint8_t gyro_fsr, int32_t dt){
+	int32_t *q = f->priv.qf;
+	int32_t gk = g_gy521_fusion_gyro_rad[(gyro_fsr >> 3) & 0x03];
+	int32_t gx = (int32_t)(((int64_t)s->gyro.x * gk) >> 8);
+	int32_t gy = (int32_t)(((int64_t)s->gyro.y * gk) >> 8);
+	int32_t gz = (int32_t)(((int64_t)s->gyro.z * gk) >> 8);
+	int32_t a[3] = {s->accel.x, s->accel.y, s->accel.z};
+	bool accel = q24_normalize(a, 3);
+	int32_t half_dt = dt >> 1;
+
+	if(f->conf.algo == GY521_FUSION_MADGWICK){
+		int32_t c[4] = {0};
+		if(accel){
+			int32_t q0q0 = q24_mul(q[0], q[0]), q1q1 = q24_mul(q[1], q[1]);
+			int32_t q2q2 = q24_mul(q[2], q[2]), q3q3 = q24_mul(q[3], q[3]);
+			// Same gradient as the float path, all terms fit in Q8.24 (|c| < 128)
+			c[0] = 4 * q24_mul(q[0], q2q2) + 2 * q24_mul(q[2], a[0]) + 4 * q24_mul(q[0], q1q1) - 2 * q24_mul(q[1], a[1]);
+			c[1] = 4 * q24_mul(q[1], q3q3) - 2 * q24_mul(q[3], a[0]) + 4 * q24_mul(q0q0, q[1]) - 2 * q24_mul(q[0], a[1])
+				- 4 * q[1] + 8 * q24_mul(q[1], q1q1) + 8 * q24_mul(q[1], q2q2) + 4 * q24_mul(q[1], a[2]);
+			c[2] = 4 * q24_mul(q0q0, q[2]) + 2 * q24_mul(q[0], a[0]) + 4 * q24_mul(q[2], q3q3) - 2 * q24_mul(q[3], a[1])
+				- 4 * q[2] + 8 * q24_mul(q[2], q1q1) + 8 * q24_mul(q[2], q2q2) + 4 * q24_mul(q[2], a[2]);
+			c[3] = 4 * q24_mul(q1q1, q[3]) - 2 * q24_mul(q[1], a[0]) + 4 * q24_mul(q2q2, q[3]) - 2 * q24_mul(q[2], a[1]);
+
+			if(q24_normalize(c, 4)){
+				int32_t step = q24_mul(f->priv.beta, dt);
+				for(uint8_t i = 0; i < 4; i++) c[i] = q24_mul(c[i], step);
+			}
+		}
+		gy521_fusion_integrate_fixed(q, q24_mul(gx, half_dt), q24_mul(gy, half_dt), q24_mul(gz, half_dt), c);
+
+	}else if(f->conf.algo == GY521_FUSION_MAHONY){
+		if(accel){
+			int32_t vx = 2 * (q24_mul(q[1], q[3]) - q24_mul(q[0], q[2]));
+			int32_t vy = 2 * (q24_mul(q[0], q[1]) + q24_mul(q[2], q[3]));
+			int32_t vz = q24_mul(q[0], q[0]) - q24_mul(q[1], q[1]) - q24_mul(q[2], q[2]) + q24_mul(q[3], q[3]);
+			int32_t e[3] = {
+				q24_mul(a[1], vz) - q24_mul(a[2], vy),
+				q24_mul(a[2], vx) - q24_mul(a[0], vz),
+				q24_mul(a[0], vy) - q24_mul(a[1], vx)
+			};
+
+			if(f->priv.ki > 0){
+				int32_t ki_dt = q24_mul(f->priv.ki, dt);
+				for(uint8_t i = 0; i < 3; i++) f->priv.integralf[i] += q24_mul(ki_dt, e[i]);
+				gx += f->priv.integralf[0];
+				gy += f->priv.integralf[1];
+				gz += f->priv.integralf[2];
+			}
+			gx += q24_mul(f->priv.kp, e[0]);
+			gy += q24_mul(f->priv.kp, e[1]);
+			gz += q24_mul(f->priv.kp, e[2]);
+		}
+		gy521_fusion_integrate_fixed(q, q24_mul(gx, half_dt), q24_mul(gy, half_dt), q24_mul(gz, half_dt), NULL);
+
+	}else{
+		int32_t *r = f->priv.anglef;
+		int32_t k = q24_mul(dt, f->priv.inv_tau);
+		if(k > Q24_ONE) k = Q24_ONE;
+		// Body rates -> Euler angle rates (pitch kept off +-90°)
+		int32_t sr, cr, sp, cp;
+		q24_sincos(r[0], &sr, &cr);
+		q24_sincos(r[1], &sp, &cp);
+		if(cp < Q24(0.01)) cp = Q24(0.01);
+		int64_t yz64 = (int64_t)(q24_mul(sr, gy) + q24_mul(cr, gz)) * ((int64_t)1 << 24) / cp; // Signed: multiply, no shift
+		// Up to 100x the body rate near +-90°: clamped so gx + yz * sp stays within int32
+		if(yz64 > INT32_MAX / 2) yz64 = INT32_MAX / 2;
+		else if(yz64 < -(INT32_MAX / 2)) yz64 = -(INT32_MAX / 2);
+		int32_t yz = (int32_t)yz64;
+		r[0] = q24_wrap(r[0] + q24_mul(gx + q24_mul(yz, sp), dt));
+		r[1] += q24_mul(q24_mul(cr, gy) - q24_mul(sr, gz), dt);
+		r[2] = q24_wrap(r[2] + q24_mul(yz, dt));
+		if(accel){
+			int32_t horiz = (int32_t)q24_isqrt((uint64_t)((int64_t)a[1] * a[1] + (int64_t)a[2] * a[2]));
+			r[0] = q24_wrap(r[0] + q24_mul(k, q24_wrap(q24_atan2(a[1], a[2]) - r[0])));
+			r[1] += q24_mul(k, q24_atan2(-a[0], horiz) - r[1]);
+		}
+
+		// Euler (ZYX) -> quaternion from the half angles
+		int32_t c0 = q24_cos(r[0] >> 1), s0 = q24_sin(r[0] >> 1);
+		int32_t c1 = q24_cos(r[1] >> 1), s1 = q24_sin(r[1] >> 1);
+		int32_t c2 = q24_cos(r[2] >> 1), s2 = q24_sin(r[2] >> 1);
+		q[0] = q24_mul(q24_mul(c0, c1), c2) + q24_mul(q24_mul(s0, s1), s2);
+		q[1] = q24_mul(q24_mul(s0, c1), c2) - q24_mul(q24_mul(c0, s1), s2);
+		q[2] = q24_mul(q24_mul(c0, s1), c2) + q24_mul(q24_mul(s0, c1), s2);
+		q[3] = q24_mul(q24_mul(c0, c1), s2) - q24_mul(q24_mul(s0, s1), c2);
+	}
+
+	f->v.q_fixed = (gy521_quat_fixed_t){q[0], q[1], q[2], q[3]};
+	if(f->conf.algo == GY521_FUSION_COMPLEMENTARY){
+		f->v.mdeg.roll = q24_to_mdeg(f->priv.anglef[0]);
+		f->v.mdeg.pitch = q24_to_mdeg(f->priv.anglef[1]);
+		f->v.mdeg.yaw = q24_to_mdeg(f->priv.anglef[2]);
+	}else{
+		int32_t sinp = 2 * (q24_mul(q[0], q[2]) - q24_mul(q[3], q[1]));
+		if(sinp > Q24_ONE) sinp = Q24_ONE;
+		else if(sinp < -Q24_ONE) sinp = -Q24_ONE;
+		int32_t cosp = (int32_t)q24_isqrt((uint64_t)(Q24_ONE - q24_mul(sinp, sinp)) << 24);
+
+		f->v.mdeg.roll = q24_to_mdeg(q24_atan2(2 * (q24_mul(q[0], q[1]) + q24_mul(q[2], q[3])),
+			Q24_ONE - 2 * (q24_mul(q[1], q[1]) + q24_mul(q[2], q[2]))));
+		f->v.mdeg.pitch = q24_to_mdeg(q24_atan2(sinp, cosp)); // asin
+		f->v.mdeg.yaw = q24_to_mdeg(q24_atan2(2 * (q24_mul(q[0], q[3]) + q24_mul(q[1], q[2])),
+			Q24_ONE - 2 * (q24_mul(q[2], q[2]) + q24_mul(q[3], q[3]))));
+	}
+}
+
+// ==============
+// === Update ===
+// ==============
+void gy521_fusion_update_sample(gy521_fusion_t *f, const gy521_sample_t *s, uint8_t gyro_fsr, uint32_t dt_us){
+	if(f->conf.fixed) gy521_fusion_fixed(f, s, gyro_fsr, q24_from_us(dt_us));
+	else gy521_fusion_float(f, s, gyro_fsr, dt_us * 1e-6f);
+	f->v.updates++;
+}
+
+bool gy521_fusion_update(gy521_fusion_t *f, const gy521_s *dev){
+	if(f->priv.started && dev->v.seq == f->priv.last_seq) return false; // Same sample again
+
+	uint32_t dt_us = f->conf.dt_us;
+	if(!dt_us){
+		if(!f->priv.started){
+			// First sample only provides the time base
+			f->priv.started = true;
+			f->priv.last_seq = dev->v.seq;
+			f->priv.last_us = dev->v.timestamp_us;
+			return false;
+		}
+		dt_us = (uint32_t)(dev->v.timestamp_us - f->priv.last_us);
+	}
+	f->priv.started = true;
+	f->priv.last_seq = dev->v.seq;
+	f->priv.last_us = dev->v.timestamp_us;
+
+	gy521_sample_t s = {.accel = dev->v.accel.raw, .gyro = dev->v.gyro.raw};
+	gy521_fusion_update_sample(f, &s, dev->conf.gyro.fsr, dt_us);
+	return true;
+}
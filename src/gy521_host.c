@@ -0,0 +1,191 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_host.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Host (Linux) port of the driver (see gy521_port.h), used
+ *  with the register simulator and the benchmark tools.
+ *
+ *  - Time + sleep come from CLOCK_MONOTONIC, or from a clock
+ *    installed with gy521_host_clock() (e.g. simulator time)
+ *  - Fake DMA engine for conf.async.enable (gy521_host_dma()):
+ *    same double buffer hand-off as the RP2040 path, a transfer
+ *    completes a set time after its start. Off: blocking reads
+ *  - Data-ready events are delivered by calling gy521_data_ready()
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "gy521.h"
+#include "gy521_host.h"
+#include "gy521_port.h"
+
+// ========================
+// === Global Variables ===
+// ========================
+static uint64_t (*g_gy521_host_now)(void *) = NULL; // Optional clock
+static void (*g_gy521_host_sleep)(void *, uint64_t) = NULL; // Optional sleep
+static void *g_gy521_host_clock_ctx = NULL;
+static uint32_t g_gy521_host_dma_us = 0; // Fake DMA transfer time, 0 = blocking reads
+static const gy521_s *g_gy521_host_dma_dev = NULL; // Last poll of a transfer not done yet
+static uint64_t g_gy521_host_dma_poll_us = 0;
+
+// ==========================
+// === Install Host Clock ===
+// ==========================
+void gy521_host_clock(uint64_t (*now_us)(void *ctx), void (*sleep_us)(void *ctx, uint64_t us), void *ctx){
+	g_gy521_host_now = now_us;
+	g_gy521_host_sleep = sleep_us;
+	g_gy521_host_clock_ctx = ctx;
+}
+
+// =============================
+// === Time, Sleep, Critical ===
+// =============================
+uint64_t gy521_port_time_us(void){
+	if(g_gy521_host_now) return g_gy521_host_now(g_gy521_host_clock_ctx);
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u;
+}
+
+void gy521_port_sleep_ms(uint32_t ms){
+	if(g_gy521_host_sleep){
+		g_gy521_host_sleep(g_gy521_host_clock_ctx, (uint64_t)ms * 1000u);
+		return;
+	}
+
+	struct timespec ts = {.tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L};
+	nanosleep(&ts, NULL);
+}
+
+// Data-ready events are delivered synchronously on the host
+uint32_t gy521_port_irq_save(void){
+	return 0;
+}
+
+void gy521_port_irq_restore(uint32_t state){
+	(void)state;
+}
+
+// ======================
+// === Bus / IRQ Port ===
+// ======================
+gy521_bus_t *gy521_port_default_bus(void){
+	return NULL; // Host builds always pass a transport
+}
+
+bool gy521_port_interrupt(gy521_s *dev, bool enable){
+	(void)dev;
+	(void)enable;
+	return true; // Caller feeds gy521_data_ready()
+}
+
+// =====================================
+// === Non-blocking Reads (fake DMA) ===
+// =====================================
+// Stand-in for the RP2040 DMA path with the same double buffer hand-off.
+// A transfer reads the registers through the transport into the free
+// half right away (what the DMA does during the transfer) and completes
+// g_gy521_host_dma_us after its start, at the next poll.
+void gy521_host_dma(uint32_t transfer_us){
+	g_gy521_host_dma_us = transfer_us;
+}
+
+static void gy521_host_async_done(gy521_s *dev){
+	dev->v.async.ready_buf = dev->priv.dma_fill;
+	dev->priv.dma_fill ^= 1;
+	dev->v.async.busy = false;
+	dev->conf.bus->owner = NULL;
+	dev->v.async.ready = true;
+	dev->v.async.completed++;
+
+	if(dev->conf.async.callback) dev->conf.async.callback(dev);
+}
+
+static void gy521_host_async_start(gy521_s *dev, uint8_t accel_temp_gyro){
+	gy521_bus_t *bus = dev->conf.bus;
+	gy521_bus_wait(bus); // Another device's transfer may hold the bus
+
+	const uint8_t reg = gy521_span_reg[accel_temp_gyro];
+	const uint8_t len = gy521_span_bytes(dev, accel_temp_gyro);
+	dev->priv.dma_mode = accel_temp_gyro;
+	dev->priv.dma_start_us = gy521_port_time_us();
+	bus->stat.transactions++;
+	bus->stat.bytes += 1 + len;
+
+	int ret = bus->write(bus->ctx, dev->conf.addr, &reg, 1, true);
+	if(ret == 1) ret = bus->read(bus->ctx, dev->conf.addr, dev->priv.dma_buf[dev->priv.dma_fill], len, false);
+	if(ret == len){
+		dev->v.async.busy = true;
+		bus->owner = dev;
+		return;
+	}
+
+	// NACK / timeout: aborted like a TX abort on the RP2040
+	dev->v.async.errors++;
+#if GY521_INSTRUMENT
+	gy521_instrument_xfer(&dev->inst, true, -1, 0);
+#endif
+	gy521_bus_fault(dev, ret < 0 ? ret : GY521_BUS_ERROR);
+}
+
+// A caller spinning on a frozen simulated clock (gy521_bus_wait()) lets the rest of the transfer pass
+bool gy521_async_poll(gy521_s *dev){
+	if(!dev || !dev->v.async.busy) return false;
+
+	const uint64_t now = gy521_port_time_us(), done = dev->priv.dma_start_us + g_gy521_host_dma_us;
+	if(now < done){
+		const bool spinning = g_gy521_host_dma_dev == dev && g_gy521_host_dma_poll_us == now;
+		g_gy521_host_dma_dev = dev;
+		g_gy521_host_dma_poll_us = now;
+		if(!spinning || !g_gy521_host_sleep) return true;
+		g_gy521_host_sleep(g_gy521_host_clock_ctx, done - now);
+	}
+
+	gy521_host_async_done(dev);
+	return false;
+}
+
+// Decodes the last completed buffer (if any) and starts the next transfer
+bool gy521_port_async_read(gy521_s *dev, uint8_t accel_temp_gyro){
+	if(!g_gy521_host_dma_us){
+		dev->conf.async.enable = false;
+		bool ok = gy521_read(dev, accel_temp_gyro);
+		dev->conf.async.enable = true;
+		return ok;
+	}
+	if(gy521_async_poll(dev)) return false; // Still transferring
+
+	bool got = false;
+	uint8_t mode = dev->priv.dma_mode;
+	uint8_t idx = dev->v.async.ready_buf;
+	if(dev->v.async.ready){
+		dev->v.async.ready = false;
+		got = true;
+	}
+
+	// Next transfer fills the other half while we decode this one
+	if(gy521_stamp_take(dev, &dev->priv.dma_stamp[dev->priv.dma_fill])) gy521_host_async_start(dev, accel_temp_gyro);
+	if(got){
+		gy521_bus_ok(dev);
+		gy521_decode(dev, mode, dev->priv.dma_buf[idx]);
+		dev->v.seq = dev->priv.dma_stamp[idx].seq;
+		dev->v.timestamp_us = dev->priv.dma_stamp[idx].timestamp_us;
+#if GY521_INSTRUMENT
+		gy521_instrument_xfer(&dev->inst, true, gy521_span_bytes(dev, mode), gy521_span_bytes(dev, mode));
+		gy521_instrument_sample(&dev->inst, dev->v.seq, dev->v.timestamp_us, dev->v.timestamp_us, gy521_port_time_us(), dev->v.rate.period_us);
+#endif
+	}
+
+	return got;
+}
@@ -0,0 +1,106 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_instrument.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Counters, log2 histograms and a text dump for the optional
+ *  per-device instrumentation (GY521_INSTRUMENT).
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "gy521_instrument.h"
+
+// =============
+// === Reset ===
+// =============
+void gy521_instrument_reset(gy521_instrument_t *in){
+	memset(in, 0, sizeof(*in));
+	in->sample.interval_min_us = UINT32_MAX;
+}
+
+// ======================
+// === log2 Histogram ===
+// ======================
+// Bucket = bit length of the value: 0 -> 0, 1 -> 1, 2..3 -> 2, 4..7 -> 3, ...
+static void gy521_hist_add(gy521_hist_t *h, uint64_t v){
+	uint32_t k = v ? 32u - (uint32_t)__builtin_clz(v > UINT32_MAX ? UINT32_MAX : (uint32_t)v) : 0;
+	h->bucket[k < GY521_HIST_BUCKETS ? k : GY521_HIST_BUCKETS - 1]++;
+}
+
+// =================
+// === Recording ===
+// =================
+void gy521_instrument_xfer(gy521_instrument_t *in, bool read, int ret, uint16_t len){
+	in->bus.transfers++;
+	if(ret < 0){
+		in->bus.nacks++;
+		return;
+	}
+	in->bus.bytes += (uint32_t)ret;
+	if(ret != len){
+		if(read) in->bus.short_reads++;
+		else in->bus.short_writes++;
+	}
+}
+
+void gy521_instrument_sample(gy521_instrument_t *in, uint32_t seq, uint64_t stamp_us, uint64_t start_us, uint64_t end_us, uint32_t period_us){
+	gy521_hist_add(&in->read_us, end_us - start_us);
+	gy521_hist_add(&in->age_us, end_us > stamp_us ? end_us - stamp_us : 0);
+
+	if(!in->sample.count) in->sample.first_us = stamp_us;
+	else if(seq != in->sample.last_seq + 1) in->sample.gaps++;
+	else{
+		// Interval + jitter only between consecutive samples
+		uint64_t dt = stamp_us - in->sample.last_us;
+		uint32_t interval = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+		if(interval < in->sample.interval_min_us) in->sample.interval_min_us = interval;
+		if(interval > in->sample.interval_max_us) in->sample.interval_max_us = interval;
+		gy521_hist_add(&in->jitter_us, interval > period_us ? interval - period_us : period_us - interval);
+	}
+
+	in->sample.count++;
+	in->sample.last_seq = seq;
+	in->sample.last_us = stamp_us;
+}
+
+// ============
+// === Dump ===
+// ============
+static uint16_t gy521_hist_dump(const char *name, const gy521_hist_t *h, char *buf, uint16_t len){
+	int n = snprintf(buf, len, "%s", name);
+	for(uint8_t k = 0; k < GY521_HIST_BUCKETS && n >= 0 && n < len; k++){
+		if(!h->bucket[k]) continue;
+		if(k == GY521_HIST_BUCKETS - 1) n += snprintf(buf + n, len - n, " >=%lu:%lu", 1ul << (k - 1), (unsigned long)h->bucket[k]);
+		else n += snprintf(buf + n, len - n, " <%lu:%lu", 1ul << k, (unsigned long)h->bucket[k]);
+	}
+	if(n >= 0 && n < len) n += snprintf(buf + n, len - n, "\n");
+	return n < 0 ? 0 : n < len ? (uint16_t)n : len ? len - 1 : 0;
+}
+
+uint16_t gy521_instrument_dump(const gy521_instrument_t *in, char *buf, uint16_t len){
+	if(!in || !buf || !len) return 0;
+
+	int n = snprintf(buf, len, "bus: %lu transfers, %lu bytes, %lu nacks, %lu short reads, %lu short writes\n"
+		"samples: %lu, %lu gaps, interval %lu..%lu us, span %llu us\n",
+		(unsigned long)in->bus.transfers, (unsigned long)in->bus.bytes, (unsigned long)in->bus.nacks,
+		(unsigned long)in->bus.short_reads, (unsigned long)in->bus.short_writes,
+		(unsigned long)in->sample.count, (unsigned long)in->sample.gaps,
+		(unsigned long)(in->sample.interval_max_us ? in->sample.interval_min_us : 0), (unsigned long)in->sample.interval_max_us,
+		(unsigned long long)(in->sample.last_us - in->sample.first_us));
+	if(n < 0) return 0;
+	if(n >= len) return len - 1;
+
+	n += gy521_hist_dump("read us:", &in->read_us, buf + n, len - n);
+	n += gy521_hist_dump("age us:", &in->age_us, buf + n, len - n);
+	n += gy521_hist_dump("jitter us:", &in->jitter_us, buf + n, len - n);
+	return (uint16_t)n;
+}
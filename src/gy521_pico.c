@@ -0,0 +1,430 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_pico.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  RP2040 port of the driver (see gy521_port.h).
+ *
+ *  This file implements:
+ *  - Hardware I²C transport + bus initialization (clock per port)
+ *  - Transfer timeouts + bus recovery (SCL pulses, STOP, re-init)
+ *  - Non-blocking DMA reads (double buffered)
+ *  - Data-ready GPIO interrupt
+ *  - Flash storage for calibration + configuration (gy521_flash.h)
+ *  - Time, sleep and critical sections
+ *
+ * ================================================================
+ */
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "gy521.h"
+#include "gy521_flash.h"
+#include "gy521_port.h"
+
+#ifndef GY521_FLASH_OFFSET
+#define GY521_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - GY521_FLASH_SECTORS * FLASH_SECTOR_SIZE) // Last sectors, behind the program
+#endif
+
+#ifndef GY521_FLASH_LOCK_MS
+#define GY521_FLASH_LOCK_MS 100 // Max. wait for core 1 to park before an erase / program
+#endif
+
+// ========================
+// === Global Variables ===
+// ========================
+// Only per-bus / IRQ dispatch state, all device state lives in gy521_s
+static gy521_bus_t g_gy521_bus[2]; // Transport per I2C port (by i2c_hw_index)
+static bool g_gy521_bus_ready[2] = {false}; // I2C port initialized
+static uint g_gy521_bus_pins[2][2]; // SDA, SCL per I2C port (bus recovery)
+static gy521_s *g_gy521_devices[GY521_MAX_DEVICES] = {NULL}; // Devices with IRQs (DMA / data-ready)
+
+// =============================
+// === Time, Sleep, Critical ===
+// =============================
+uint64_t gy521_port_time_us(void){
+	return time_us_64();
+}
+
+void gy521_port_sleep_ms(uint32_t ms){
+	sleep_ms(ms);
+}
+
+uint32_t gy521_port_irq_save(void){
+	return save_and_disable_interrupts();
+}
+
+void gy521_port_irq_restore(uint32_t state){
+	restore_interrupts(state);
+}
+
+// ================================
+// === Register device for IRQs ===
+// ================================
+// IRQ handlers have no context, they look the device up here
+static bool gy521_register(gy521_s *dev){
+	int8_t free_slot = -1;
+	for(uint8_t i = 0; i < GY521_MAX_DEVICES; i++){
+		if(g_gy521_devices[i] == dev) return true;
+		if(!g_gy521_devices[i] && free_slot < 0) free_slot = i;
+	}
+	if(free_slot < 0) return false;
+
+	g_gy521_devices[free_slot] = dev;
+	return true;
+}
+
+// ==============================
+// === Hardware I2C Transport ===
+// ==============================
+// bus->timeout_us = 0 waits forever (i2c_*_blocking)
+static int gy521_pico_write(void *ctx, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+	i2c_inst_t *i2c = (i2c_inst_t *)ctx;
+	uint32_t timeout_us = g_gy521_bus[i2c_hw_index(i2c)].timeout_us;
+	if(!timeout_us) return i2c_write_blocking(i2c, addr, src, len, nostop);
+	return i2c_write_timeout_us(i2c, addr, src, len, nostop, timeout_us);
+}
+
+static int gy521_pico_read(void *ctx, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+	i2c_inst_t *i2c = (i2c_inst_t *)ctx;
+	uint32_t timeout_us = g_gy521_bus[i2c_hw_index(i2c)].timeout_us;
+	if(!timeout_us) return i2c_read_blocking(i2c, addr, dst, len, nostop);
+	return i2c_read_timeout_us(i2c, addr, dst, len, nostop, timeout_us);
+}
+
+// ====================
+// === Bus Recovery ===
+// ====================
+// A slave cut off mid-byte (brownout, glitch) keeps SDA low and waits for
+// clocks. Pins as open drain through SIO: low = output 0, high = input.
+static void gy521_pico_line(uint pin, bool high){
+	gpio_set_dir(pin, high ? GPIO_IN : GPIO_OUT);
+	sleep_us(5); // Half a 100 kHz clock
+}
+
+static void gy521_pico_pins_i2c(uint sda_pin, uint scl_pin){
+	gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+	gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+#if GY521_USE_PULLUP
+	gpio_pull_up(sda_pin);
+	gpio_pull_up(scl_pin);
+#endif
+}
+
+// Up to 9 SCL pulses until SDA is released, STOP, then the peripheral is reset
+static bool gy521_pico_recover(void *ctx){
+	i2c_inst_t *i2c = (i2c_inst_t *)ctx;
+	const uint8_t idx = i2c_hw_index(i2c);
+	const uint sda = g_gy521_bus_pins[idx][0], scl = g_gy521_bus_pins[idx][1];
+
+	i2c_deinit(i2c);
+	gpio_init(sda);
+	gpio_init(scl);
+	gpio_put(sda, 0);
+	gpio_put(scl, 0);
+#if GY521_USE_PULLUP
+	gpio_pull_up(sda);
+	gpio_pull_up(scl);
+#endif
+
+	gy521_pico_line(sda, true);
+	gy521_pico_line(scl, true);
+	for(uint8_t i = 0; i < 9 && !gpio_get(sda); i++){
+		gy521_pico_line(scl, false);
+		gy521_pico_line(scl, true);
+	}
+
+	// STOP: SDA rises while SCL is high
+	gy521_pico_line(scl, false);
+	gy521_pico_line(sda, false);
+	gy521_pico_line(scl, true);
+	gy521_pico_line(sda, true);
+	const bool idle = gpio_get(sda) && gpio_get(scl);
+
+	i2c_init(i2c, g_gy521_bus[idx].baud);
+	gy521_pico_pins_i2c(sda, scl);
+	return idle;
+}
+
+// Up to Fast-mode Plus
+static uint32_t gy521_pico_baud(void *ctx, uint32_t hz){
+	if(hz > GY521_BAUD_FAST_PLUS) return 0;
+	return i2c_set_baudrate((i2c_inst_t *)ctx, hz);
+}
+
+// ==========================
+// === Initialize I2C Bus ===
+// ==========================
+gy521_bus_t *gy521_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin){
+	if(!i2c) return NULL;
+	uint8_t idx = i2c_hw_index(i2c);
+	gy521_bus_t *bus = &g_gy521_bus[idx];
+	if(g_gy521_bus_ready[idx]) return bus;
+
+	const uint baud = i2c_init(i2c, GY521_I2C_BAUD);
+	gy521_pico_pins_i2c(sda_pin, scl_pin);
+	g_gy521_bus_pins[idx][0] = sda_pin;
+	g_gy521_bus_pins[idx][1] = scl_pin;
+
+	*bus = (gy521_bus_t){0};
+	bus->ctx = i2c;
+	bus->write = &gy521_pico_write;
+	bus->read = &gy521_pico_read;
+	bus->recover = &gy521_pico_recover;
+	bus->timeout_us = GY521_BUS_TIMEOUT_US;
+	bus->set_baud = &gy521_pico_baud;
+	gy521_bus_baud(bus, baud); // Raises timeout_us for slow clocks
+	g_gy521_bus_ready[idx] = true;
+
+	return bus;
+}
+
+gy521_bus_t *gy521_port_default_bus(void){
+	return gy521_bus_init(GY521_I2C_PORT, GY521_SDA_PIN, GY521_SCL_PIN);
+}
+
+// ==================================
+// === Non-blocking DMA Read Path ===
+// ==================================
+// TX channel feeds IC_DATA_CMD with the register address + read commands,
+// RX channel drains the received bytes into one half of a double buffer.
+// The half that was filled last is owned by the CPU until the next
+// gy521_port_async_read() decodes it and hands it back to the DMA.
+// Only available on the hardware I2C transport.
+
+// Called from DMA_IRQ_1 when an RX channel has received all bytes
+static void gy521_async_irq(void){
+	for(uint8_t i = 0; i < GY521_MAX_DEVICES; i++){
+		gy521_s *dev = g_gy521_devices[i];
+		if(!dev || dev->priv.dma_rx < 0 || !dma_channel_get_irq1_status(dev->priv.dma_rx)) continue;
+		dma_channel_acknowledge_irq1(dev->priv.dma_rx);
+
+		if(!dev->v.async.busy) continue;
+		dev->v.async.ready_buf = dev->priv.dma_fill;
+		dev->priv.dma_fill ^= 1;
+		dev->v.async.busy = false;
+		dev->conf.bus->owner = NULL; // No stale pointer to a device that may go out of scope
+		dev->v.async.ready = true;
+		dev->v.async.completed++;
+
+		if(dev->conf.async.callback) dev->conf.async.callback(dev);
+	}
+}
+
+// Claims the DMA channels once per device
+static bool gy521_async_init(gy521_s *dev){
+	static bool irq_installed = false;
+	if(dev->priv.dma_rx >= 0) return true;
+	if(dev->conf.bus->read != &gy521_pico_read) return false; // DMA needs the hardware I2C
+	if(!gy521_register(dev)) return false;
+
+	dev->priv.dma_tx = dma_claim_unused_channel(false);
+	dev->priv.dma_rx = dma_claim_unused_channel(false);
+	if(dev->priv.dma_tx < 0 || dev->priv.dma_rx < 0){
+		if(dev->priv.dma_tx >= 0) dma_channel_unclaim(dev->priv.dma_tx);
+		if(dev->priv.dma_rx >= 0) dma_channel_unclaim(dev->priv.dma_rx);
+		dev->priv.dma_tx = dev->priv.dma_rx = -1;
+		return false;
+	}
+
+	dma_channel_set_irq1_enabled(dev->priv.dma_rx, true);
+	if(!irq_installed){
+		irq_add_shared_handler(DMA_IRQ_1, &gy521_async_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(DMA_IRQ_1, true);
+		irq_installed = true;
+	}
+
+	return true;
+}
+
+// Starts a register read into the free half of the double buffer
+static bool gy521_async_start(gy521_s *dev, uint8_t accel_temp_gyro){
+	gy521_bus_wait(dev->conf.bus); // Another device's transfer may hold the bus
+
+	i2c_inst_t *i2c = (i2c_inst_t *)dev->conf.bus->ctx;
+	i2c_hw_t *hw = i2c_get_hw(i2c);
+	const uint8_t len = gy521_span_bytes(dev, accel_temp_gyro);
+
+	hw->enable = 0;
+	hw->tar = dev->conf.addr;
+	hw->enable = 1;
+
+	dev->priv.dma_cmd[0] = gy521_span_reg[accel_temp_gyro];
+	for(uint8_t i = 0; i < len; i++){
+		dev->priv.dma_cmd[1 + i] = I2C_IC_DATA_CMD_CMD_BITS;
+		if(i == 0) dev->priv.dma_cmd[1 + i] |= I2C_IC_DATA_CMD_RESTART_BITS;
+		if(i == len - 1) dev->priv.dma_cmd[1 + i] |= I2C_IC_DATA_CMD_STOP_BITS;
+	}
+
+	dev->priv.dma_mode = accel_temp_gyro;
+	dev->priv.dma_start_us = time_us_64();
+	dev->v.async.busy = true;
+	dev->conf.bus->owner = dev;
+	dev->conf.bus->stat.transactions++;
+	dev->conf.bus->stat.bytes += 1 + len;
+
+	dma_channel_config c = dma_channel_get_default_config(dev->priv.dma_rx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, true);
+	channel_config_set_dreq(&c, i2c_get_dreq(i2c, false));
+	dma_channel_configure(dev->priv.dma_rx, &c, dev->priv.dma_buf[dev->priv.dma_fill], &hw->data_cmd, len, true);
+
+	c = dma_channel_get_default_config(dev->priv.dma_tx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+	channel_config_set_read_increment(&c, true);
+	channel_config_set_write_increment(&c, false);
+	channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+	dma_channel_configure(dev->priv.dma_tx, &c, &hw->data_cmd, dev->priv.dma_cmd, 1 + len, true);
+
+	return true;
+}
+
+// =================================
+// === Poll running DMA transfer ===
+// =================================
+// Returns true while a transfer is still in flight.
+// A NACK (TX abort) or bus->timeout_us cancels the transfer and counts as error.
+bool gy521_async_poll(gy521_s *dev){
+	if(!dev || !dev->v.async.busy) return false;
+
+	gy521_bus_t *bus = dev->conf.bus;
+	i2c_hw_t *hw = i2c_get_hw((i2c_inst_t *)bus->ctx);
+	const bool abort = hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+	const bool late = bus->timeout_us && time_us_64() - dev->priv.dma_start_us > bus->timeout_us;
+	if(abort || late){
+		dma_channel_abort(dev->priv.dma_tx);
+		dma_channel_abort(dev->priv.dma_rx);
+		dma_channel_acknowledge_irq1(dev->priv.dma_rx);
+		(void)hw->clr_tx_abrt;
+		dev->v.async.busy = false;
+		bus->owner = NULL;
+		dev->v.async.errors++;
+#if GY521_INSTRUMENT
+		gy521_instrument_xfer(&dev->inst, true, -1, 0);
+#endif
+		gy521_bus_fault(dev, abort ? GY521_BUS_ERROR : GY521_BUS_TIMEOUT);
+		return false;
+	}
+
+	return dev->v.async.busy;
+}
+
+// ===================================
+// === Async Read (behind fn.read) ===
+// ===================================
+// Decodes the last completed buffer (if any) and starts the next transfer.
+bool gy521_port_async_read(gy521_s *dev, uint8_t accel_temp_gyro){
+	if(!gy521_async_init(dev)) return false;
+	if(gy521_async_poll(dev)) return false; // Still transferring
+
+	bool got = false;
+	uint8_t mode = dev->priv.dma_mode;
+	uint8_t idx = dev->v.async.ready_buf;
+	if(dev->v.async.ready){
+		dev->v.async.ready = false;
+		got = true;
+	}
+
+	// Next transfer writes into the other half while we decode this one
+	if(gy521_stamp_take(dev, &dev->priv.dma_stamp[dev->priv.dma_fill])) gy521_async_start(dev, accel_temp_gyro);
+	if(got){
+		gy521_bus_ok(dev);
+		gy521_decode(dev, mode, dev->priv.dma_buf[idx]);
+		dev->v.seq = dev->priv.dma_stamp[idx].seq;
+		dev->v.timestamp_us = dev->priv.dma_stamp[idx].timestamp_us;
+#if GY521_INSTRUMENT
+		// The DMA transfer starts right after the stamp: read time = age
+		gy521_instrument_xfer(&dev->inst, true, gy521_span_bytes(dev, mode), gy521_span_bytes(dev, mode));
+		gy521_instrument_sample(&dev->inst, dev->v.seq, dev->v.timestamp_us, dev->v.timestamp_us, time_us_64(), dev->v.rate.period_us);
+#endif
+	}
+
+	return got;
+}
+
+// ===============================
+// === Data-ready GPIO Handler ===
+// ===============================
+static void gy521_int_irq(uint gpio, uint32_t events){
+	if(!(events & GPIO_IRQ_EDGE_RISE)) return;
+
+	for(uint8_t i = 0; i < GY521_MAX_DEVICES; i++){
+		gy521_s *dev = g_gy521_devices[i];
+		if(dev && dev->conf.int_pin == (int)gpio) gy521_data_ready(dev);
+	}
+}
+
+// =================================
+// === Route INT pin to a device ===
+// =================================
+// Uses gpio_set_irq_enabled_with_callback(), which replaces
+// any other GPIO callback on the calling core.
+bool gy521_port_interrupt(gy521_s *dev, bool enable){
+	if(dev->conf.int_pin < 0 || !gy521_register(dev)) return false;
+
+	gpio_init(dev->conf.int_pin);
+	gpio_set_dir(dev->conf.int_pin, GPIO_IN);
+	gpio_set_irq_enabled_with_callback(dev->conf.int_pin, GPIO_IRQ_EDGE_RISE, enable, &gy521_int_irq);
+
+	return true;
+}
+
+// =====================
+// === Flash Storage ===
+// =====================
+// Erase / program stall XIP: flash_safe_execute() disables interrupts
+// and parks core 1 (flash_safe_execute_core_init() in the core-1 engine).
+// Fails after GY521_FLASH_LOCK_MS if core 1 never answers.
+typedef struct{
+	uint32_t offset;
+	const uint8_t *src; // NULL = erase
+} gy521_pico_flash_op_t;
+
+static void gy521_pico_flash_op(void *param){
+	const gy521_pico_flash_op_t *op = param;
+	if(op->src) flash_range_program(op->offset, op->src, FLASH_PAGE_SIZE);
+	else flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+}
+
+static bool gy521_pico_flash_read(void *ctx, uint32_t offset, uint8_t *dst, uint32_t len){
+	(void)ctx;
+	memcpy(dst, (const uint8_t *)XIP_BASE + offset, len);
+	return true;
+}
+
+static bool gy521_pico_flash_erase(void *ctx, uint32_t offset){
+	(void)ctx;
+	gy521_pico_flash_op_t op = {.offset = offset, .src = NULL};
+	return flash_safe_execute(&gy521_pico_flash_op, &op, GY521_FLASH_LOCK_MS) == PICO_OK;
+}
+
+static bool gy521_pico_flash_program(void *ctx, uint32_t offset, const uint8_t *src){
+	(void)ctx;
+	gy521_pico_flash_op_t op = {.offset = offset, .src = src};
+	return flash_safe_execute(&gy521_pico_flash_op, &op, GY521_FLASH_LOCK_MS) == PICO_OK;
+}
+
+gy521_flash_t *gy521_flash_init(void){
+	static gy521_flash_t flash;
+	if(flash.read) return &flash;
+
+	flash.read = &gy521_pico_flash_read;
+	flash.erase = &gy521_pico_flash_erase;
+	flash.program = &gy521_pico_flash_program;
+	flash.offset = GY521_FLASH_OFFSET;
+	flash.sectors = GY521_FLASH_SECTORS;
+	return &flash;
+}
@@ -0,0 +1,48 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_port.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Platform port of the driver (private).
+ *
+ *  gy521.c is platform independent, everything that needs the
+ *  pico-sdk (time, IRQs, GPIO, DMA, hardware I²C) is behind
+ *  these hooks:
+ *  - gy521_pico.c  RP2040
+ *  - gy521_host.c  Linux / host builds (GY521_HOST)
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521.h"
+
+// ======================
+// === Platform hooks ===
+// ======================
+uint64_t gy521_port_time_us(void);
+void gy521_port_sleep_ms(uint32_t ms);
+uint32_t gy521_port_irq_save(void); // Enter critical section (vs. driver IRQs)
+void gy521_port_irq_restore(uint32_t state);
+
+gy521_bus_t *gy521_port_default_bus(void); // Bus for gy521_init(NULL, ...)
+bool gy521_port_interrupt(gy521_s *dev, bool enable); // Route the INT line of 'dev' to gy521_data_ready()
+bool gy521_port_async_read(gy521_s *dev, uint8_t accel_temp_gyro); // Non-blocking read (conf.async.enable)
+
+// =====================================
+// === Driver internals for the port ===
+// =====================================
+extern const uint8_t gy521_span_reg[4]; // First register per accel_temp_gyro
+extern const uint8_t gy521_span_len[4]; // Bytes per accel_temp_gyro
+uint8_t gy521_span_bytes(const gy521_s *dev, uint8_t accel_temp_gyro); // Same + external sensor data (conf.aux.ext_len)
+
+void gy521_decode(gy521_s *dev, uint8_t accel_temp_gyro, const uint8_t *buf);
+bool gy521_stamp_take(gy521_s *dev, gy521_stamp_t *stamp);
+void gy521_bus_wait(gy521_bus_t *bus); // Wait until no non-blocking transfer holds the bus
+void gy521_bus_fault(gy521_s *dev, int ret); // Count a failed transfer, recover after conf.recover.after in a row
+void gy521_bus_ok(gy521_s *dev); // Successful transfer, ends the failure run
@@ -0,0 +1,111 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_regs.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  MPU-6050 register map and bit masks.
+ *  Private to the driver and the register simulator.
+ *
+ * ================================================================
+ */
+#pragma once
+
+// ==========================================
+// === GY521(MPU-6050) register addresses ===
+// ==========================================
+#define GY521_REG_XA_OFFS_H 0x06 // Accel offsets XA..ZA, ±16 g LSB, bit 0 reserved (factory trim)
+#define GY521_REG_XG_OFFS_USRH 0x13 // Gyro offsets XG..ZG, ±1000 °/s LSB
+#define GY521_REG_SMPLRT_DIV 0x19
+#define GY521_REG_CONFIG 0x1A
+#define GY521_REG_MOT_THR 0x1F // Motion threshold, 2 mg/LSB
+#define GY521_REG_MOT_DUR 0x20 // Motion duration, 1 ms/LSB
+#define GY521_REG_FIFO_EN 0x23
+#define GY521_REG_I2C_MST_CTRL 0x24
+#define GY521_REG_I2C_SLV0_ADDR 0x25 // SLV0..3: ADDR, REG, CTRL each
+#define GY521_REG_I2C_SLV4_ADDR 0x31 // SLV4: ADDR, REG, DO, CTRL, DI
+#define GY521_REG_I2C_SLV4_REG 0x32
+#define GY521_REG_I2C_SLV4_DO 0x33
+#define GY521_REG_I2C_SLV4_CTRL 0x34
+#define GY521_REG_I2C_SLV4_DI 0x35
+#define GY521_REG_I2C_MST_STATUS 0x36
+#define GY521_REG_INT_PIN_CFG 0x37
+#define GY521_REG_INT_ENABLE 0x38
+#define GY521_REG_INT_STATUS 0x3A
+#define GY521_REG_ACCEL_XOUT_H 0x3B
+#define GY521_REG_ACCEL_CONFIG 0x1c
+#define GY521_REG_TEMP_OUT_H 0x41
+#define GY521_REG_GYRO_XOUT_H  0x43
+#define GY521_REG_GYRO_CONFIG 0x1b
+#define GY521_REG_EXT_SENS_DATA_00 0x49 // .. EXT_SENS_DATA_23 0x60
+#define GY521_REG_I2C_SLV0_DO 0x63 // .. I2C_SLV3_DO 0x66
+#define GY521_REG_SIGNAL_PATH_RESET 0x68
+#define GY521_REG_USER_CTRL 0x6A
+#define GY521_REG_PWR_MGMT_1 0x6B
+#define GY521_REG_PWR_MGMT_2 0x6C
+#define GY521_REG_FIFO_COUNTH 0x72
+#define GY521_REG_FIFO_COUNTL 0x73
+#define GY521_REG_FIFO_R_W 0x74
+#define GY521_REG_WHO_AM_I 0x75
+
+#define GY521_FIFO_SIZE 1024 // FIFO size in bytes
+#define GY521_EXT_SENS_DATA_SIZE 24 // EXT_SENS_DATA_00 .. 23
+
+// =============================================
+// === Bitmasks for reset, FIFO, sleep, etc. ===
+// =============================================
+#define GY521_GYRO_RESET (1 << 2)
+#define GY521_ACCEL_RESET (1 << 1)
+#define GY521_TEMP_RESET 0x01
+
+#define GY521_FIFO_EN (1 << 6)
+#define GY521_I2C_MST_EN (1 << 5)
+#define GY521_I2C_IF_DIS (1 << 4)
+#define GY521_FIFO_RESET (1 << 2)
+#define GY521_I2C_MST_RESET (1 << 1)
+#define GY521_SIG_COND_RESET 0x01
+
+#define GY521_DEVICE_RESET (1 << 7)
+#define GY521_SLEEP (1 << 6) // Sleep mode enable/disable
+#define GY521_CYCLE (1 << 5)
+#define GY521_TEMP_DIS (1 << 3)
+
+#define GY521_STBY_XA (1 << 5)
+#define GY521_STBY_YA (1 << 4)
+#define GY521_STBY_ZA (1 << 3)
+#define GY521_STBY_XG (1 << 2)
+#define GY521_STBY_YG (1 << 1)
+#define GY521_STBY_ZG 0x01
+#define GY521_LP_WAKE_MASK 0xC0 // PWR_MGMT_2 bits 7:6
+
+#define GY521_ACCEL_HPF_5HZ 0x01 // ACCEL_CONFIG bits 2:0, feeds the motion detector
+
+#define GY521_INT_LEVEL (1 << 7) // INT pin active low
+#define GY521_INT_OPEN (1 << 6) // INT pin open drain
+#define GY521_LATCH_INT_EN (1 << 5) // Hold INT until cleared (else 50 us pulse)
+#define GY521_INT_RD_CLEAR (1 << 4)
+#define GY521_I2C_BYPASS_EN (1 << 1) // Host reaches the auxiliary bus directly
+#define GY521_MOT_EN (1 << 6)
+#define GY521_DATA_RDY_EN 0x01
+
+#define GY521_MOT_INT (1 << 6) // INT_STATUS
+#define GY521_FIFO_OFLOW_INT (1 << 4) // INT_STATUS
+#define GY521_DATA_RDY_INT 0x01 // INT_STATUS
+
+#define GY521_TEMP_FIFO_EN (1 << 7)
+#define GY521_XG_FIFO_EN (1 << 6)
+#define GY521_YG_FIFO_EN (1 << 5)
+#define GY521_ZG_FIFO_EN (1 << 4)
+#define GY521_ACCEL_FIFO_EN (1 << 3)
+
+#define GY521_WAIT_FOR_ES (1 << 6) // I2C_MST_CTRL: data-ready waits for the external data
+#define GY521_I2C_MST_CLK_MASK 0x0F
+#define GY521_I2C_SLV_RNW (1 << 7) // I2C_SLVx_ADDR: read from the slave
+#define GY521_I2C_SLV_EN (1 << 7) // I2C_SLVx_CTRL
+#define GY521_I2C_SLV_BYTE_SW (1 << 6) // Swap byte pairs
+#define GY521_I2C_SLV_LEN_MASK 0x0F
+#define GY521_I2C_SLV4_DONE (1 << 6) // I2C_MST_STATUS
+#define GY521_I2C_SLV4_NACK (1 << 4) // I2C_MST_STATUS, SLV0..3_NACK = bits 0..3
@@ -0,0 +1,87 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_ring.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Lock-free SPSC ring buffer between the acquisition core
+ *  (producer) and the processing core (consumer).
+ *
+ *  head/tail are free running counters, the slot is
+ *  counter & (GY521_RING_SIZE - 1). The producer publishes a
+ *  frame with a release store of head, the consumer frees
+ *  slots with a release store of tail.
+ *
+ * ================================================================
+ */
+#include <stdatomic.h>
+#include <stdint.h>
+#include "gy521_ring.h"
+
+#define GY521_RING_MASK (GY521_RING_SIZE - 1)
+
+// =======================
+// === Initialize Ring ===
+// =======================
+void gy521_ring_init(gy521_ring_t *ring){
+	atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->overruns, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->high_water, 0, memory_order_release);
+}
+
+// =================================
+// === Push one Frame (Producer) ===
+// =================================
+bool gy521_ring_push(gy521_ring_t *ring, const gy521_frame_t *frame){
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+	if(head - tail >= GY521_RING_SIZE){
+		// Only the producer writes overruns, a plain load + store is enough
+		uint32_t overruns = atomic_load_explicit(&ring->overruns, memory_order_relaxed);
+		atomic_store_explicit(&ring->overruns, overruns + 1, memory_order_relaxed);
+		return false;
+	}
+
+	ring->buf[head & GY521_RING_MASK] = *frame;
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+	uint32_t fill = head + 1 - tail;
+	if(fill > atomic_load_explicit(&ring->high_water, memory_order_relaxed))
+		atomic_store_explicit(&ring->high_water, fill, memory_order_relaxed);
+
+	return true;
+}
+
+// ========================================
+// === Pop a Batch of Frames (Consumer) ===
+// ========================================
+uint16_t gy521_ring_pop(gy521_ring_t *ring, gy521_frame_t *out, uint16_t max){
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	uint32_t n = head - tail;
+	if(n > max) n = max;
+
+	for(uint32_t i = 0; i < n; i++)
+		out[i] = ring->buf[(tail + i) & GY521_RING_MASK];
+
+	// Release the slots only after they were copied
+	atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+
+	return (uint16_t)n;
+}
+
+// ==========================
+// === Frames in the Ring ===
+// ==========================
+uint32_t gy521_ring_count(gy521_ring_t *ring){
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	return head - tail;
+}
@@ -0,0 +1,29 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_scale.h
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Fixed-point scaling (Q16.16) shared by the per-sample decode
+ *  and the batch conversion.
+ *  Private to the driver.
+ *
+ * ================================================================
+ */
+#pragma once
+#include <stdint.h>
+
+#define GY521_ACCEL_MG_Q16 4000 // 1000 mg / 16384 LSB * 65536 (±2 g, exact, x2 per step)
+#define GY521_GYRO_MDPS_Q16 500275 // 1000 m°/s / 131 LSB * 65536 (±250 °/s)
+#define GY521_TEMP_MC_Q16 192753 // 1000 m°C / 340 LSB * 65536
+#define GY521_TEMP_MC_OFFSET 36530 // 36.53 °C
+
+// raw * mul (Q16.16) rounded to integer, for 16-bit raw and mul >= 0.
+// Split into integer and fraction part: two 32-bit multiplies (single
+// cycle on the M0+) instead of a 64-bit product, bit-identical result.
+static inline int32_t gy521_fixed_mul(int32_t raw, int32_t mul){
+	return raw * (mul >> 16) + ((raw * (mul & 0xffff) + (1 << 15)) >> 16);
+}
@@ -0,0 +1,548 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_sim.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Register-level MPU-6050 simulator behind a gy521_bus_t,
+ *  so the unmodified driver can run and be measured on a host.
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gy521_sim.h"
+#include "gy521_regs.h"
+
+// =========================
+// === Power-up Defaults ===
+// =========================
+static void gy521_sim_defaults(gy521_sim_t *sim){
+	memset(sim->reg, 0, sizeof(sim->reg));
+	sim->reg[GY521_REG_PWR_MGMT_1] = GY521_SLEEP; // Starts in sleep mode
+	sim->reg[GY521_REG_WHO_AM_I] = 0x68;
+	sim->ptr = 0;
+	sim->fifo_head = 0;
+	sim->fifo_count = 0;
+}
+
+void gy521_sim_init(gy521_sim_t *sim, uint8_t addr){
+	memset(sim, 0, sizeof(*sim));
+	sim->addr = addr;
+	gy521_sim_defaults(sim);
+}
+
+void gy521_sim_brownout(gy521_sim_t *sim){
+	gy521_sim_defaults(sim);
+	sim->motion_count = 0;
+}
+
+// ========================
+// === Sample Rate (µs) ===
+// ========================
+// Gyro output rate is 8 kHz with DLPF off (0 / 7), else 1 kHz.
+// Cycle mode wakes the accel at LP_WAKE_CTRL instead.
+uint32_t gy521_sim_sample_period_us(const gy521_sim_t *sim){
+	static const uint32_t lp_wake_us[4] = {800000, 200000, 50000, 25000}; // 1.25, 5, 20, 40 Hz
+	if(sim->reg[GY521_REG_PWR_MGMT_1] & GY521_CYCLE) return lp_wake_us[sim->reg[GY521_REG_PWR_MGMT_2] >> 6];
+
+	uint8_t dlpf = sim->reg[GY521_REG_CONFIG] & 0x07;
+	uint32_t base_us = (dlpf == 0 || dlpf == 7) ? 125 : 1000;
+	return base_us * (1u + sim->reg[GY521_REG_SMPLRT_DIV]);
+}
+
+static void gy521_sim_default_source(uint32_t index, uint8_t accel_fsr, gy521_sample_t *out){
+	*out = (gy521_sample_t){0};
+	out->accel.x = (int16_t)(index & 0xffff);
+	out->accel.y = (int16_t)(index >> 16);
+	out->accel.z = (int16_t)(16384 >> ((accel_fsr >> 3) & 0x03)); // 1 g
+}
+
+// ====================
+// === FIFO Helpers ===
+// ====================
+static void gy521_sim_fifo_push(gy521_sim_t *sim, const uint8_t *src, uint8_t len){
+	for(uint8_t i = 0; i < len; i++){
+		// Full: the oldest byte is lost
+		if(sim->fifo_count == sizeof(sim->fifo)){
+			sim->fifo_head = (sim->fifo_head + 1) % sizeof(sim->fifo);
+			sim->fifo_count--;
+		}
+		sim->fifo[(sim->fifo_head + sim->fifo_count) % sizeof(sim->fifo)] = src[i];
+		sim->fifo_count++;
+	}
+}
+
+static uint8_t gy521_sim_fifo_pop(gy521_sim_t *sim){
+	if(!sim->fifo_count) return 0;
+	uint8_t b = sim->fifo[sim->fifo_head];
+	sim->fifo_head = (sim->fifo_head + 1) % sizeof(sim->fifo);
+	sim->fifo_count--;
+	return b;
+}
+
+// ========================
+// === Motion Detection ===
+// ========================
+// Change against the previous sample stands in for the high-pass filter.
+// Each sample above MOT_THR (2 mg/LSB) counts, MOT_DUR consecutive ones detect motion.
+static bool gy521_sim_motion(gy521_sim_t *sim, const gy521_axis_raw_t *a){
+	int32_t lsb_per_g = 16384 >> ((sim->reg[GY521_REG_ACCEL_CONFIG] >> 3) & 0x03);
+	int32_t thr = (int32_t)sim->reg[GY521_REG_MOT_THR] * 2 * lsb_per_g / 1000;
+	const gy521_axis_raw_t *p = &sim->last_accel;
+	bool above = abs(a->x - p->x) > thr || abs(a->y - p->y) > thr || abs(a->z - p->z) > thr;
+
+	sim->last_accel = *a;
+	if(!above) sim->motion_count = 0;
+	else if(sim->motion_count < 255) sim->motion_count++;
+	return above && sim->motion_count >= sim->reg[GY521_REG_MOT_DUR];
+}
+
+// ========================
+// === Offset Registers ===
+// ========================
+// Gyro offsets in ±1000 °/s LSB, accel in ±16 g LSB (bit 0 reserved), scaled to the FSR
+static int16_t gy521_sim_offset(int16_t v, const uint8_t *reg, uint8_t i, int32_t lsb_per_offset, uint8_t fsr, bool accel){
+	int32_t offset = (int16_t)((reg[2 * i] << 8) | reg[2 * i + 1]);
+	if(accel) offset &= ~1;
+	int32_t out = v + offset * lsb_per_offset / (1 << ((fsr >> 3) & 0x03));
+	return out > INT16_MAX ? INT16_MAX : out < INT16_MIN ? INT16_MIN : (int16_t)out;
+}
+
+// ============================
+// === Auxiliary I2C Master ===
+// ============================
+static gy521_sim_slave_t *gy521_sim_aux_find(gy521_sim_t *sim, uint8_t addr){
+	for(uint8_t i = 0; i < sim->aux_count; i++)
+		if(sim->aux[i]->addr == addr) return sim->aux[i];
+	return NULL;
+}
+
+static uint8_t gy521_sim_slave_read(gy521_sim_slave_t *slave){
+	slave->stat.reads++;
+	return slave->reg[slave->ptr++];
+}
+
+static void gy521_sim_slave_write(gy521_sim_slave_t *slave, uint8_t value){
+	slave->stat.writes++;
+	slave->reg[slave->ptr++] = value;
+}
+
+// One master cycle: SLV0..3 in order (reads packed into EXT_SENS_DATA), then a pending SLV4
+static void gy521_sim_aux_master(gy521_sim_t *sim){
+	uint8_t *ext = &sim->reg[GY521_REG_EXT_SENS_DATA_00];
+	uint8_t off = 0;
+
+	for(uint8_t i = 0; i < 4; i++){
+		const uint8_t *slv = &sim->reg[GY521_REG_I2C_SLV0_ADDR + 3 * i];
+		if(!(slv[2] & GY521_I2C_SLV_EN)) continue;
+
+		const uint8_t len = slv[2] & GY521_I2C_SLV_LEN_MASK;
+		gy521_sim_slave_t *slave = gy521_sim_aux_find(sim, slv[0] & 0x7f);
+		if(!slave){
+			sim->reg[GY521_REG_I2C_MST_STATUS] |= 1 << i; // SLVx_NACK
+			if(slv[0] & GY521_I2C_SLV_RNW) off += len; // Slot keeps its place
+			continue;
+		}
+
+		slave->ptr = slv[1];
+		if(!(slv[0] & GY521_I2C_SLV_RNW)){
+			gy521_sim_slave_write(slave, sim->reg[GY521_REG_I2C_SLV0_DO + i]);
+			continue;
+		}
+
+		const uint8_t first = off;
+		for(uint8_t k = 0; k < len && off < GY521_EXT_SENS_DATA_SIZE; k++) ext[off++] = gy521_sim_slave_read(slave);
+		if(slv[2] & GY521_I2C_SLV_BYTE_SW){
+			for(uint8_t k = first; k + 1 < off; k += 2){
+				uint8_t t = ext[k];
+				ext[k] = ext[k + 1];
+				ext[k + 1] = t;
+			}
+		}
+	}
+
+	uint8_t *slv4 = &sim->reg[GY521_REG_I2C_SLV4_ADDR];
+	if(!(slv4[3] & GY521_I2C_SLV_EN)) return;
+
+	gy521_sim_slave_t *slave = gy521_sim_aux_find(sim, slv4[0] & 0x7f);
+	slv4[3] &= ~GY521_I2C_SLV_EN; // Single shot
+	sim->reg[GY521_REG_I2C_MST_STATUS] |= GY521_I2C_SLV4_DONE;
+	if(!slave){
+		sim->reg[GY521_REG_I2C_MST_STATUS] |= GY521_I2C_SLV4_NACK;
+		return;
+	}
+
+	slave->ptr = slv4[1];
+	if(slv4[0] & GY521_I2C_SLV_RNW) slv4[4] = gy521_sim_slave_read(slave); // SLV4_DI
+	else gy521_sim_slave_write(slave, slv4[2]);
+}
+
+// ==========================
+// === Produce one Sample ===
+// ==========================
+static void gy521_sim_sample(gy521_sim_t *sim){
+	gy521_sample_t s;
+	if(sim->source) sim->source(sim->source_user, sim->index, &s);
+	else gy521_sim_default_source(sim->index, sim->reg[GY521_REG_ACCEL_CONFIG], &s);
+
+	// Slaves measure alongside, the master collects before the data registers update
+	for(uint8_t i = 0; i < sim->aux_count; i++)
+		if(sim->aux[i]->update) sim->aux[i]->update(sim->aux[i]->user, sim->index, sim->aux[i]);
+	if(sim->reg[GY521_REG_USER_CTRL] & GY521_I2C_MST_EN) gy521_sim_aux_master(sim);
+	sim->index++;
+	sim->stat.samples++;
+
+	int16_t *a = &s.accel.x, *g = &s.gyro.x;
+	for(uint8_t i = 0; i < 3; i++){
+		a[i] = gy521_sim_offset(a[i], &sim->reg[GY521_REG_XA_OFFS_H], i, 8, sim->reg[GY521_REG_ACCEL_CONFIG], true);
+		g[i] = gy521_sim_offset(g[i], &sim->reg[GY521_REG_XG_OFFS_USRH], i, 4, sim->reg[GY521_REG_GYRO_CONFIG], false);
+	}
+
+	// Gyro off in standby / cycle mode, temperature sensor off with TEMP_DIS
+	uint8_t stby = sim->reg[GY521_REG_PWR_MGMT_2];
+	bool cycle = sim->reg[GY521_REG_PWR_MGMT_1] & GY521_CYCLE;
+	if(cycle || (stby & GY521_STBY_XG)) s.gyro.x = 0;
+	if(cycle || (stby & GY521_STBY_YG)) s.gyro.y = 0;
+	if(cycle || (stby & GY521_STBY_ZG)) s.gyro.z = 0;
+	if(sim->reg[GY521_REG_PWR_MGMT_1] & GY521_TEMP_DIS) s.temp = 0;
+
+	bool motion = gy521_sim_motion(sim, &s.accel);
+
+	// Data registers, big endian
+	const int16_t v[7] = {s.accel.x, s.accel.y, s.accel.z, s.temp, s.gyro.x, s.gyro.y, s.gyro.z};
+	uint8_t *d = &sim->reg[GY521_REG_ACCEL_XOUT_H];
+	for(uint8_t i = 0; i < 7; i++){
+		d[2 * i] = (uint8_t)((uint16_t)v[i] >> 8);
+		d[2 * i + 1] = (uint8_t)v[i];
+	}
+
+	// FIFO, channels in register order
+	if(sim->reg[GY521_REG_USER_CTRL] & GY521_FIFO_EN){
+		uint8_t en = sim->reg[GY521_REG_FIFO_EN];
+		uint16_t before = sim->fifo_count;
+		uint8_t pushed = 0;
+
+		if(en & GY521_ACCEL_FIFO_EN){ gy521_sim_fifo_push(sim, &d[0], 6); pushed += 6; }
+		if(en & GY521_TEMP_FIFO_EN){ gy521_sim_fifo_push(sim, &d[6], 2); pushed += 2; }
+		if(en & GY521_XG_FIFO_EN){ gy521_sim_fifo_push(sim, &d[8], 2); pushed += 2; }
+		if(en & GY521_YG_FIFO_EN){ gy521_sim_fifo_push(sim, &d[10], 2); pushed += 2; }
+		if(en & GY521_ZG_FIFO_EN){ gy521_sim_fifo_push(sim, &d[12], 2); pushed += 2; }
+
+		if(before + pushed > sizeof(sim->fifo)){
+			sim->reg[GY521_REG_INT_STATUS] |= GY521_FIFO_OFLOW_INT;
+			sim->stat.fifo_overflows++;
+		}
+	}
+
+	sim->reg[GY521_REG_INT_STATUS] |= GY521_DATA_RDY_INT;
+	if(motion) sim->reg[GY521_REG_INT_STATUS] |= GY521_MOT_INT;
+
+	uint8_t en = sim->reg[GY521_REG_INT_ENABLE];
+	if(sim->int_line && ((en & GY521_DATA_RDY_EN) || (motion && (en & GY521_MOT_EN)))) sim->int_line(sim->int_user);
+}
+
+// Produce every sample due up to 'now_ns'
+static void gy521_sim_run(gy521_sim_t *sim, uint64_t now_ns){
+	uint64_t period_ns = (uint64_t)gy521_sim_sample_period_us(sim) * 1000u;
+
+	// Asleep: no samples, restart the sample clock on wake-up
+	if(sim->reg[GY521_REG_PWR_MGMT_1] & GY521_SLEEP){
+		sim->next_sample_ns = now_ns + period_ns;
+		return;
+	}
+
+	while(sim->next_sample_ns <= now_ns){
+		gy521_sim_sample(sim);
+		sim->next_sample_ns += period_ns;
+	}
+}
+
+// =======================
+// === Register Access ===
+// =======================
+static uint8_t gy521_sim_reg_read(gy521_sim_t *sim){
+	uint8_t reg = sim->ptr;
+
+	// FIFO_R_W does not auto-increment
+	if(reg == GY521_REG_FIFO_R_W) return gy521_sim_fifo_pop(sim);
+
+	sim->ptr = (sim->ptr + 1) & 0x7f;
+	switch(reg){
+		case GY521_REG_FIFO_COUNTH: return (uint8_t)(sim->fifo_count >> 8);
+		case GY521_REG_FIFO_COUNTL: return (uint8_t)sim->fifo_count;
+		case GY521_REG_I2C_MST_STATUS:
+		case GY521_REG_INT_STATUS:{
+			uint8_t status = sim->reg[reg];
+			sim->reg[reg] = 0; // Cleared on read
+			return status;
+		}
+		default: return sim->reg[reg];
+	}
+}
+
+static void gy521_sim_reg_write(gy521_sim_t *sim, uint8_t value, uint64_t now_ns){
+	uint8_t reg = sim->ptr;
+	sim->ptr = (sim->ptr + 1) & 0x7f;
+
+	// Read-only registers
+	if((reg >= GY521_REG_INT_STATUS && reg < GY521_REG_EXT_SENS_DATA_00 + GY521_EXT_SENS_DATA_SIZE) ||
+			reg == GY521_REG_I2C_SLV4_DI || reg == GY521_REG_I2C_MST_STATUS || reg == GY521_REG_WHO_AM_I || reg == GY521_REG_FIFO_COUNTH || reg == GY521_REG_FIFO_COUNTL)
+		return;
+
+	if(reg == GY521_REG_FIFO_R_W){
+		gy521_sim_fifo_push(sim, &value, 1);
+		sim->ptr = reg;
+		return;
+	}
+
+	if(reg == GY521_REG_PWR_MGMT_1 && (value & GY521_DEVICE_RESET)){
+		gy521_sim_defaults(sim);
+		sim->reset_until_ns = now_ns + GY521_SIM_RESET_US * 1000ull;
+		return;
+	}
+
+	if(reg == GY521_REG_USER_CTRL && (value & GY521_FIFO_RESET)){
+		sim->fifo_head = 0;
+		sim->fifo_count = 0;
+		value &= ~GY521_FIFO_RESET; // Self clearing
+	}
+
+	sim->reg[reg] = value;
+}
+
+// ==========================
+// === Simulated Bus Time ===
+// ==========================
+// Start + address + data bytes, 9 clocks each, + stop
+static void gy521_sim_transfer_time(gy521_sim_bus_t *sb, size_t len){
+	if(!sb->baud) return;
+	sb->now_ns += ((uint64_t)(len + 1) * 9 + 2) * 1000000000u / sb->baud;
+}
+
+// Injected fault for the next transfer: NACK, or SDA stuck until the deadline
+static int gy521_sim_fault(gy521_sim_bus_t *sb){
+	if(sb->fault.stuck){
+		uint32_t timeout_us = sb->bus->timeout_us ? sb->bus->timeout_us : GY521_SIM_HANG_US;
+		sb->now_ns += (uint64_t)timeout_us * 1000u;
+		sb->stat.timeouts++;
+		return GY521_BUS_TIMEOUT;
+	}
+	if(sb->fault.nack){
+		sb->fault.nack--;
+		gy521_sim_transfer_time(sb, 0);
+		return GY521_BUS_ERROR;
+	}
+	return 0;
+}
+
+static gy521_sim_t *gy521_sim_find(gy521_sim_bus_t *sb, uint8_t addr){
+	for(uint8_t i = 0; i < sb->count; i++){
+		gy521_sim_run(sb->devices[i], sb->now_ns);
+		if(sb->devices[i]->addr == addr) return sb->devices[i];
+	}
+	return NULL;
+}
+
+// Slave reachable on the main bus: bypass on and master off
+static gy521_sim_slave_t *gy521_sim_find_bypass(gy521_sim_bus_t *sb, uint8_t addr){
+	for(uint8_t i = 0; i < sb->count; i++){
+		const uint8_t *reg = sb->devices[i]->reg;
+		if(!(reg[GY521_REG_INT_PIN_CFG] & GY521_I2C_BYPASS_EN) || (reg[GY521_REG_USER_CTRL] & GY521_I2C_MST_EN)) continue;
+
+		gy521_sim_slave_t *slave = gy521_sim_aux_find(sb->devices[i], addr);
+		if(slave) return slave;
+	}
+	return NULL;
+}
+
+// =====================
+// === Bus Transport ===
+// =====================
+static int gy521_sim_bus_write(void *ctx, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+	(void)nostop;
+	gy521_sim_bus_t *sb = ctx;
+	int fault = gy521_sim_fault(sb);
+	if(fault) return fault;
+
+	gy521_sim_t *sim = gy521_sim_find(sb, addr);
+	if(sim && sb->now_ns < sim->reset_until_ns) sim = NULL; // Resetting: NACK
+	gy521_sim_slave_t *slave = sim ? NULL : gy521_sim_find_bypass(sb, addr);
+	gy521_sim_transfer_time(sb, (sim || slave) ? len : 0);
+	if(!sim && !slave) return GY521_BUS_ERROR;
+	if(!len) return 0;
+
+	if(slave){
+		slave->ptr = src[0];
+		for(size_t i = 1; i < len; i++) gy521_sim_slave_write(slave, src[i]);
+		return (int)len;
+	}
+
+	sim->ptr = src[0] & 0x7f;
+	for(size_t i = 1; i < len; i++) gy521_sim_reg_write(sim, src[i], sb->now_ns);
+
+	return (int)len;
+}
+
+static int gy521_sim_bus_read(void *ctx, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+	(void)nostop;
+	gy521_sim_bus_t *sb = ctx;
+	int fault = gy521_sim_fault(sb);
+	if(fault) return fault;
+
+	gy521_sim_t *sim = gy521_sim_find(sb, addr);
+	if(sim && sb->now_ns < sim->reset_until_ns) sim = NULL; // Resetting: NACK
+	gy521_sim_slave_t *slave = sim ? NULL : gy521_sim_find_bypass(sb, addr);
+	gy521_sim_transfer_time(sb, (sim || slave) ? len : 0);
+	if(!sim && !slave) return GY521_BUS_ERROR;
+
+	for(size_t i = 0; i < len; i++) dst[i] = slave ? gy521_sim_slave_read(slave) : gy521_sim_reg_read(sim);
+
+	// Too fast for the wiring: edges smear, now and then a bit is read wrong
+	for(size_t i = 0; i < len; i++){
+		if(sb->fault.max_baud && sb->baud > sb->fault.max_baud && sb->stat.bytes_read % GY521_SIM_FLIP_EVERY == GY521_SIM_FLIP_EVERY - 1){
+			dst[i] ^= 0x10;
+			sb->stat.flipped++;
+		}
+		sb->stat.bytes_read++;
+	}
+
+	return (int)len;
+}
+
+// 9 clock pulses + STOP at 100 kHz (as gy521_pico.c), the slave lets go after enough of them
+static bool gy521_sim_bus_recover(void *ctx){
+	gy521_sim_bus_t *sb = ctx;
+	sb->now_ns += (2 + 2 * 9 + 4) * 5000u;
+	sb->stat.recoveries++;
+	if(sb->fault.stuck) sb->fault.stuck--;
+	return !sb->fault.stuck;
+}
+
+static uint32_t gy521_sim_bus_baud(void *ctx, uint32_t hz){
+	((gy521_sim_bus_t *)ctx)->baud = hz;
+	return hz;
+}
+
+void gy521_sim_bus_init(gy521_sim_bus_t *sim_bus, gy521_bus_t *bus){
+	memset(sim_bus, 0, sizeof(*sim_bus));
+	sim_bus->baud = 400 * 1000;
+	sim_bus->bus = bus;
+
+	*bus = (gy521_bus_t){0};
+	bus->ctx = sim_bus;
+	bus->write = &gy521_sim_bus_write;
+	bus->read = &gy521_sim_bus_read;
+	bus->recover = &gy521_sim_bus_recover;
+	bus->timeout_us = GY521_BUS_TIMEOUT_US;
+	bus->set_baud = &gy521_sim_bus_baud;
+	bus->baud = sim_bus->baud;
+}
+
+bool gy521_sim_attach(gy521_sim_bus_t *sim_bus, gy521_sim_t *sim){
+	if(sim_bus->count >= GY521_SIM_MAX_DEVICES) return false;
+	sim->next_sample_ns = sim_bus->now_ns;
+	sim_bus->devices[sim_bus->count++] = sim;
+	return true;
+}
+
+void gy521_sim_slave_init(gy521_sim_slave_t *slave, uint8_t addr){
+	memset(slave, 0, sizeof(*slave));
+	slave->addr = addr;
+}
+
+bool gy521_sim_aux_attach(gy521_sim_t *sim, gy521_sim_slave_t *slave){
+	if(sim->aux_count >= GY521_SIM_MAX_AUX) return false;
+	sim->aux[sim->aux_count++] = slave;
+	return true;
+}
+
+// ======================
+// === Flash Stand-in ===
+// ======================
+// One byte of an erase / program, false once the power is cut
+static bool gy521_sim_flash_power(gy521_sim_flash_t *sf){
+	if(sf->fault.off) return false;
+	if(sf->fault.cut && !--sf->fault.cut) sf->fault.off = true;
+	return !sf->fault.off;
+}
+
+static bool gy521_sim_flash_read(void *ctx, uint32_t offset, uint8_t *dst, uint32_t len){
+	gy521_sim_flash_t *sf = ctx;
+	if(sf->fault.off || offset > sf->size || len > sf->size - offset) return false;
+	memcpy(dst, &sf->mem[offset], len);
+	return true;
+}
+
+static bool gy521_sim_flash_erase(void *ctx, uint32_t offset){
+	gy521_sim_flash_t *sf = ctx;
+	if(offset % GY521_FLASH_SECTOR || offset >= sf->size){
+		sf->stat.misaligned++;
+		return false;
+	}
+	if(sf->fault.off) return false;
+
+	sf->stat.erases++;
+	sf->erases[offset / GY521_FLASH_SECTOR]++;
+	if(sf->clock) gy521_sim_advance(sf->clock, GY521_SIM_FLASH_ERASE_US);
+	for(uint32_t i = 0; i < GY521_FLASH_SECTOR; i++){
+		if(!gy521_sim_flash_power(sf)) return false;
+		sf->mem[offset + i] = 0xFF;
+	}
+	return true;
+}
+
+static bool gy521_sim_flash_program(void *ctx, uint32_t offset, const uint8_t *src){
+	gy521_sim_flash_t *sf = ctx;
+	if(offset % GY521_FLASH_PAGE || offset >= sf->size){
+		sf->stat.misaligned++;
+		return false;
+	}
+	if(sf->fault.off) return false;
+
+	sf->stat.programs++;
+	if(sf->clock) gy521_sim_advance(sf->clock, GY521_SIM_FLASH_PROGRAM_US);
+	for(uint32_t i = 0; i < GY521_FLASH_PAGE; i++){
+		if(!gy521_sim_flash_power(sf)) return false;
+		sf->mem[offset + i] &= src[i]; // NOR: only 1 -> 0
+	}
+	return true;
+}
+
+bool gy521_sim_flash_init(gy521_sim_flash_t *sim_flash, gy521_flash_t *flash, uint8_t *mem, uint32_t size){
+	if(size % GY521_FLASH_SECTOR || size / GY521_FLASH_SECTOR > GY521_SIM_FLASH_SECTORS) return false;
+	memset(sim_flash, 0, sizeof(*sim_flash));
+	memset(mem, 0xFF, size);
+	sim_flash->mem = mem;
+	sim_flash->size = size;
+
+	*flash = (gy521_flash_t){0};
+	flash->ctx = sim_flash;
+	flash->read = &gy521_sim_flash_read;
+	flash->erase = &gy521_sim_flash_erase;
+	flash->program = &gy521_sim_flash_program;
+	flash->sectors = (uint16_t)(size / GY521_FLASH_SECTOR);
+	return true;
+}
+
+// ==================
+// === Time Hooks ===
+// ==================
+void gy521_sim_advance(gy521_sim_bus_t *sim_bus, uint64_t us){
+	sim_bus->now_ns += us * 1000u;
+	for(uint8_t i = 0; i < sim_bus->count; i++) gy521_sim_run(sim_bus->devices[i], sim_bus->now_ns);
+}
+
+uint64_t gy521_sim_now(void *sim_bus){
+	return ((gy521_sim_bus_t *)sim_bus)->now_ns / 1000u;
+}
+
+void gy521_sim_sleep(void *sim_bus, uint64_t us){
+	gy521_sim_advance(sim_bus, us);
+}
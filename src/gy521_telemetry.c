@@ -0,0 +1,129 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_telemetry.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Binary telemetry frame encoder (device side) and streaming
+ *  decoder (host side), see gy521_telemetry.h for the layout.
+ *
+ *  The CRC uses a 16 entry nibble table: two lookups per byte,
+ *  32 bytes of flash, no 512 byte table on the RP2040.
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "gy521_telemetry.h"
+
+// ==========================
+// === CRC-16/CCITT-FALSE ===
+// ==========================
+// Poly 0x1021, init 0xFFFF
+static const uint16_t g_gy521_crc_nibble[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+uint16_t gy521_telemetry_crc16(const uint8_t *data, uint16_t len){
+	uint16_t crc = 0xffff;
+	for(uint16_t i = 0; i < len; i++){
+		crc = (crc << 4) ^ g_gy521_crc_nibble[(crc >> 12) ^ (data[i] >> 4)];
+		crc = (crc << 4) ^ g_gy521_crc_nibble[(crc >> 12) ^ (data[i] & 0x0f)];
+	}
+	return crc;
+}
+
+static void gy521_put16(uint8_t *p, uint16_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t gy521_get16(const uint8_t *p){
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// ====================
+// === Encode Frame ===
+// ====================
+uint8_t gy521_telemetry_encode(uint8_t *out, const gy521_frame_t *frame){
+	const gy521_sample_t *s = &frame->sample;
+	const int16_t raw[7] = {s->accel.x, s->accel.y, s->accel.z, s->temp, s->gyro.x, s->gyro.y, s->gyro.z};
+
+	out[0] = GY521_TELEMETRY_SYNC0;
+	out[1] = GY521_TELEMETRY_SYNC1;
+	gy521_put16(&out[2], (uint16_t)frame->seq);
+	gy521_put16(&out[4], (uint16_t)frame->timestamp_us);
+	gy521_put16(&out[6], (uint16_t)(frame->timestamp_us >> 16));
+	for(uint8_t i = 0; i < 7; i++) gy521_put16(&out[8 + 2 * i], (uint16_t)raw[i]);
+	gy521_put16(&out[22], gy521_telemetry_crc16(&out[2], 20));
+
+	return GY521_TELEMETRY_FRAME_SIZE;
+}
+
+// ===============
+// === Decoder ===
+// ===============
+void gy521_telemetry_decoder_init(gy521_telemetry_decoder_t *d){
+	memset(d, 0, sizeof(*d));
+}
+
+// Drops the buffered bytes up to the next possible sync word
+static void gy521_telemetry_resync(gy521_telemetry_decoder_t *d){
+	uint8_t i = 1;
+	while(i < d->len && !(d->buf[i] == GY521_TELEMETRY_SYNC0 && (i + 1 == d->len || d->buf[i + 1] == GY521_TELEMETRY_SYNC1))) i++;
+
+	memmove(d->buf, &d->buf[i], d->len - i);
+	d->len -= i;
+	d->stat.skipped += i;
+}
+
+bool gy521_telemetry_decode(gy521_telemetry_decoder_t *d, uint8_t byte, gy521_frame_t *out){
+	d->buf[d->len++] = byte;
+
+	if((d->len == 1 && byte != GY521_TELEMETRY_SYNC0) || (d->len == 2 && byte != GY521_TELEMETRY_SYNC1)){
+		gy521_telemetry_resync(d);
+		return false;
+	}
+	if(d->len < GY521_TELEMETRY_FRAME_SIZE) return false;
+
+	if(gy521_telemetry_crc16(&d->buf[2], 20) != gy521_get16(&d->buf[22])){
+		d->stat.crc_errors++;
+		gy521_telemetry_resync(d);
+		return false;
+	}
+	d->len = 0;
+
+	// Unwrap the 16 bit seq and the 32 bit time against the previous frame
+	uint16_t seq = gy521_get16(&d->buf[2]);
+	uint32_t time = gy521_get16(&d->buf[4]) | ((uint32_t)gy521_get16(&d->buf[6]) << 16);
+	if(!d->started){
+		d->seq = seq;
+		d->timestamp_us = time;
+		d->gap = 0;
+		d->started = true;
+	}else{
+		uint16_t step = (uint16_t)(seq - (uint16_t)d->seq);
+		d->gap = step ? step - 1u : 0;
+		d->seq += step;
+		d->timestamp_us += (uint32_t)(time - (uint32_t)d->timestamp_us);
+	}
+	d->stat.frames++;
+	d->stat.lost += d->gap;
+
+	gy521_sample_t *s = &out->sample;
+	int16_t raw[7];
+	for(uint8_t i = 0; i < 7; i++) raw[i] = (int16_t)gy521_get16(&d->buf[8 + 2 * i]);
+	s->accel = (gy521_axis_raw_t){raw[0], raw[1], raw[2]};
+	s->temp = raw[3];
+	s->gyro = (gy521_axis_raw_t){raw[4], raw[5], raw[6]};
+	out->seq = d->seq;
+	out->timestamp_us = d->timestamp_us;
+
+	return true;
+}
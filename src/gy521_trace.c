@@ -0,0 +1,276 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_trace.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Transfer trace recorder (device side, a transport wrapper)
+ *  and replay transport (host side), see gy521_trace.h for the
+ *  format.
+ *
+ *  Recording costs one clock read and two sink calls per
+ *  transfer, no buffering inside.
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "gy521.h"
+#include "gy521_trace.h"
+#include "gy521_port.h"
+#include "gy521_regs.h"
+
+static const uint8_t g_gy521_trace_magic[4] = {'G', 'Y', '5', 'T'};
+
+// ==============
+// === Varint ===
+// ==============
+static uint8_t gy521_varint_put(uint8_t *out, uint64_t v){
+	uint8_t n = 0;
+	do{
+		out[n] = (uint8_t)(v & 0x7f);
+		v >>= 7;
+		if(v) out[n] |= 0x80;
+		n++;
+	}while(v);
+	return n;
+}
+
+static bool gy521_varint_get(const uint8_t *in, size_t size, size_t *pos, uint64_t *v){
+	*v = 0;
+	for(uint8_t shift = 0; shift < 64 && *pos < size; shift += 7){
+		uint8_t b = in[(*pos)++];
+		*v |= (uint64_t)(b & 0x7f) << shift;
+		if(!(b & 0x80)) return true;
+	}
+	return false;
+}
+
+// ==============
+// === Record ===
+// ==============
+static void gy521_trace_put(gy521_trace_rec_t *rec, const uint8_t *data, size_t len){
+	rec->sink(rec->user, data, len);
+	rec->stat.bytes += (uint32_t)len;
+}
+
+static void gy521_trace_emit(gy521_trace_rec_t *rec, uint8_t flags, uint8_t addr, uint64_t start_us, const uint8_t *data, size_t len, int ret){
+	uint8_t head[2 + 10 + 3 + 5];
+	uint8_t n = 0;
+
+	if(ret != (int)len) flags |= GY521_TRACE_FAILED;
+	head[n++] = flags;
+	head[n++] = addr & 0x7f;
+	n += gy521_varint_put(&head[n], start_us - rec->last_us);
+	n += gy521_varint_put(&head[n], len);
+	if(flags & GY521_TRACE_FAILED) n += gy521_varint_put(&head[n], ((uint32_t)ret << 1) ^ -(uint32_t)(ret < 0)); // Zigzag
+	rec->last_us = start_us;
+
+	gy521_trace_put(rec, head, n);
+	if(!(flags & GY521_TRACE_FAILED) && len) gy521_trace_put(rec, data, len);
+	rec->stat.records++;
+}
+
+static int gy521_trace_rec_write(void *ctx, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+	gy521_trace_rec_t *rec = ctx;
+	const uint64_t start_us = gy521_port_time_us();
+	int ret = rec->inner->write(rec->inner->ctx, addr, src, len, nostop);
+	gy521_trace_emit(rec, nostop ? GY521_TRACE_NOSTOP : 0, addr, start_us, src, len, ret);
+	return ret;
+}
+
+static int gy521_trace_rec_read(void *ctx, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+	gy521_trace_rec_t *rec = ctx;
+	const uint64_t start_us = gy521_port_time_us();
+	int ret = rec->inner->read(rec->inner->ctx, addr, dst, len, nostop);
+	gy521_trace_emit(rec, GY521_TRACE_READ | (nostop ? GY521_TRACE_NOSTOP : 0), addr, start_us, dst, len, ret);
+	return ret;
+}
+
+static bool gy521_trace_rec_recover(void *ctx){
+	gy521_trace_rec_t *rec = ctx;
+	return rec->inner->recover(rec->inner->ctx);
+}
+
+static uint32_t gy521_trace_rec_baud(void *ctx, uint32_t hz){
+	return gy521_bus_baud(((gy521_trace_rec_t *)ctx)->inner, hz);
+}
+
+void gy521_trace_record(gy521_trace_rec_t *rec, gy521_bus_t *inner, gy521_trace_sink_fn sink, void *user){
+	memset(rec, 0, sizeof(*rec));
+	rec->inner = inner;
+	rec->sink = sink;
+	rec->user = user;
+
+	rec->bus.ctx = rec;
+	rec->bus.write = &gy521_trace_rec_write;
+	rec->bus.read = &gy521_trace_rec_read;
+	rec->bus.recover = inner->recover ? &gy521_trace_rec_recover : NULL;
+	rec->bus.set_baud = inner->set_baud ? &gy521_trace_rec_baud : NULL;
+	rec->bus.timeout_us = inner->timeout_us;
+	rec->bus.baud = inner->baud;
+
+	const uint8_t header[GY521_TRACE_HEADER_SIZE] = {'G', 'Y', '5', 'T', GY521_TRACE_VERSION, 0, 0, 0};
+	gy521_trace_put(rec, header, sizeof(header));
+}
+
+// =============
+// === Parse ===
+// =============
+bool gy521_trace_next(const uint8_t *trace, size_t size, size_t *pos, uint64_t *time_us, gy521_trace_record_t *rec){
+	size_t p = *pos;
+	uint64_t dt, len, zz = 0;
+	if(p + 2 > size) return false;
+
+	rec->flags = trace[p++];
+	rec->addr = trace[p++];
+	if(!gy521_varint_get(trace, size, &p, &dt) || !gy521_varint_get(trace, size, &p, &len) || len > UINT16_MAX) return false;
+	rec->len = (uint16_t)len;
+	rec->time_us = *time_us + dt;
+
+	if(rec->flags & GY521_TRACE_FAILED){
+		if(!gy521_varint_get(trace, size, &p, &zz)) return false;
+		rec->ret = (int)((uint32_t)(zz >> 1) ^ -(uint32_t)(zz & 1));
+		rec->data = NULL;
+	}else{
+		if(p + len > size) return false;
+		rec->ret = (int)len;
+		rec->data = &trace[p];
+		p += len;
+	}
+
+	*pos = p;
+	*time_us = rec->time_us;
+	return true;
+}
+
+// ==============
+// === Replay ===
+// ==============
+// Start time of the record at play->pos (end of trace: the last one)
+static void gy521_trace_peek(gy521_trace_play_t *play){
+	gy521_trace_record_t rec;
+	size_t p = play->pos;
+	uint64_t t = play->time_us;
+	play->pos_us = gy521_trace_next(play->trace, play->size, &p, &t, &rec) ? rec.time_us : play->time_us;
+}
+
+// Moves past the record just parsed from play->pos up to 'p'
+static void gy521_trace_take(gy521_trace_play_t *play, const gy521_trace_record_t *rec, size_t p){
+	if(!(rec->flags & GY521_TRACE_READ) && rec->data && rec->len) play->rec_reg = rec->data[0];
+	play->pos = p;
+	play->time_us = rec->time_us;
+	play->slept_us = 0;
+	gy521_trace_peek(play);
+}
+
+static int gy521_trace_play_write(void *ctx, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+	(void)nostop;
+	gy521_trace_play_t *play = ctx;
+	if(len) play->reg = src[0];
+	play->stat.writes++;
+
+	// The same write next in the trace: consumed, with its recorded result
+	gy521_trace_record_t rec;
+	size_t p = play->pos;
+	uint64_t t = play->time_us;
+	if(gy521_trace_next(play->trace, play->size, &p, &t, &rec) && !(rec.flags & GY521_TRACE_READ) && rec.addr == addr &&
+			rec.len == len && (!rec.data || !memcmp(rec.data, src, len))){
+		if(play->pace) play->pace(play->pace_user, rec.time_us);
+		gy521_trace_take(play, &rec, p);
+		return rec.ret;
+	}
+
+	play->stat.mismatches++;
+	return (int)len;
+}
+
+static int gy521_trace_play_read(void *ctx, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+	(void)nostop;
+	gy521_trace_play_t *play = ctx;
+
+	// Next read of the same device, register and length
+	gy521_trace_record_t rec;
+	size_t p = play->pos;
+	uint64_t t = play->time_us;
+	uint8_t reg = play->rec_reg;
+	uint32_t skipped = 0;
+	while(gy521_trace_next(play->trace, play->size, &p, &t, &rec)){
+		if(!(rec.flags & GY521_TRACE_READ)){
+			if(rec.data && rec.len) reg = rec.data[0];
+		}else if(rec.addr == addr && rec.len == len && reg == play->reg){
+			if(play->pace) play->pace(play->pace_user, rec.time_us);
+			play->stat.skipped += skipped;
+			play->stat.reads++;
+			gy521_trace_take(play, &rec, p);
+			if(rec.data) memcpy(dst, rec.data, len);
+			return rec.ret;
+		}
+		skipped++;
+	}
+
+	play->stat.misses++;
+	return GY521_BUS_ERROR;
+}
+
+bool gy521_trace_replay(gy521_trace_play_t *play, const uint8_t *trace, size_t size){
+	memset(play, 0, sizeof(*play));
+	if(size < GY521_TRACE_HEADER_SIZE || memcmp(trace, g_gy521_trace_magic, 4) || trace[4] != GY521_TRACE_VERSION) return false;
+
+	play->trace = trace;
+	play->size = size;
+	play->pos = GY521_TRACE_HEADER_SIZE;
+	gy521_trace_peek(play);
+
+	play->bus.ctx = play;
+	play->bus.write = &gy521_trace_play_write;
+	play->bus.read = &gy521_trace_play_read;
+	return true;
+}
+
+bool gy521_trace_done(const gy521_trace_play_t *play){
+	return play->pos >= play->size;
+}
+
+uint64_t gy521_trace_now(void *play){
+	gy521_trace_play_t *p = play;
+	return p->pos_us + p->slept_us;
+}
+
+void gy521_trace_sleep(void *play, uint64_t us){
+	((gy521_trace_play_t *)play)->slept_us += us;
+}
+
+// ===================================
+// === Register Values of a Device ===
+// ===================================
+void gy521_trace_regs(const uint8_t *trace, size_t size, uint8_t addr, uint8_t until, uint8_t regs[128]){
+	if(size < GY521_TRACE_HEADER_SIZE) return;
+
+	gy521_trace_record_t rec;
+	size_t p = GY521_TRACE_HEADER_SIZE;
+	uint64_t t = 0;
+	uint8_t reg = 0;
+	while(gy521_trace_next(trace, size, &p, &t, &rec)){
+		if(rec.addr != addr || !rec.data || !rec.len) continue;
+
+		if(rec.flags & GY521_TRACE_READ){
+			if(reg == until) return;
+			for(uint16_t i = 0; i < rec.len && reg + i < 128; i++) regs[reg + i] = rec.data[i];
+			continue;
+		}
+
+		reg = rec.data[0] & 0x7f;
+		for(uint16_t i = 1; i < rec.len && reg + i - 1 < 128; i++) regs[reg + i - 1] = rec.data[i];
+		if(reg == GY521_REG_PWR_MGMT_1 && rec.len > 1 && (rec.data[1] & GY521_DEVICE_RESET)){
+			memset(regs, 0, 128);
+			regs[GY521_REG_PWR_MGMT_1] = GY521_SLEEP;
+			regs[GY521_REG_WHO_AM_I] = 0x68;
+		}
+	}
+}
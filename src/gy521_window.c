@@ -0,0 +1,218 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_window.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Windowed statistics and CIC / boxcar decimation.
+ *
+ *  Per input sample: 6 x (add, multiply-add, compare) for the
+ *  statistics and conf.order adds per channel for the decimator.
+ *  Divisions and the square root run once per window / output.
+ *  The CIC accumulators wrap modulo 2^32; the output is still
+ *  exact as long as it fits 32 bit (gain limit in gy521_window_set).
+ *
+ * ================================================================
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "gy521_window.h"
+
+// ===============
+// === Helpers ===
+// ===============
+// x / d rounded half away from zero, d > 0
+static int32_t gy521_div_round(int64_t x, uint64_t d){
+	return (int32_t)(x >= 0 ? (x + (int64_t)(d / 2)) / (int64_t)d : (x - (int64_t)(d / 2)) / (int64_t)d);
+}
+
+// floor(sqrt(x)), bit by bit
+static uint32_t gy521_isqrt(uint64_t x){
+	uint64_t r = 0, bit = 1ull << 62;
+	while(bit > x) bit >>= 2;
+	while(bit){
+		if(x >= r + bit){
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		}else r >>= 1;
+		bit >>= 2;
+	}
+	return (uint32_t)r;
+}
+
+static void gy521_window_channels(const gy521_sample_t *s, int16_t c[7]){
+	c[0] = s->accel.x; c[1] = s->accel.y; c[2] = s->accel.z;
+	c[3] = s->temp;
+	c[4] = s->gyro.x; c[5] = s->gyro.y; c[6] = s->gyro.z;
+}
+
+// ==================================
+// === Initialization / Configure ===
+// ==================================
+bool gy521_window_init(gy521_window_t *w, uint16_t window, uint8_t filter, uint8_t ratio){
+	*w = (gy521_window_t){0};
+	w->conf.window = window;
+	w->conf.filter = filter;
+	w->conf.ratio = ratio;
+	w->conf.order = filter == GY521_DECIM_CIC ? GY521_CIC_ORDER_MAX : 1;
+	return gy521_window_set(w);
+}
+
+bool gy521_window_set(gy521_window_t *w){
+	uint32_t gain = 1;
+	if(w->conf.filter > GY521_DECIM_CIC) return false;
+	if(w->conf.filter == GY521_DECIM_CIC){
+		if(w->conf.order < 1 || w->conf.order > GY521_CIC_ORDER_MAX) return false;
+		for(uint8_t k = 0; k < w->conf.order; k++){
+			gain *= w->conf.ratio ? w->conf.ratio : 1;
+			if(gain > GY521_CIC_GAIN_MAX) return false;
+		}
+	}else if(w->conf.filter == GY521_DECIM_BOXCAR){
+		gain = w->conf.ratio;
+	}
+	w->priv.gain = gain;
+
+	gy521_window_reset(w);
+	return true;
+}
+
+void gy521_window_reset(gy521_window_t *w){
+	for(uint8_t a = 0; a < 6; a++){
+		w->priv.sum[a] = 0;
+		w->priv.sumsq[a] = 0;
+		w->priv.min[a] = INT16_MAX;
+		w->priv.max[a] = INT16_MIN;
+	}
+	w->priv.count = 0;
+
+	for(uint8_t k = 0; k < GY521_CIC_ORDER_MAX; k++){
+		for(uint8_t c = 0; c < 7; c++) w->priv.integ[k][c] = w->priv.comb[k][c] = 0;
+	}
+	w->priv.phase = 0;
+	w->priv.settle = w->conf.filter == GY521_DECIM_CIC ? w->conf.order - 1 : 0; // Outputs that still see the zero start
+}
+
+// ==================
+// === Statistics ===
+// ==================
+static void gy521_window_stat(gy521_stat_t *st, int64_t sum, uint64_t sumsq, int16_t min, int16_t max, uint16_t n){
+	st->mean = (int16_t)gy521_div_round(sum, n);
+	st->min = min;
+	st->max = max;
+	// N*sumsq <= 2^62 and sum^2 <= 2^62 for N <= 65535: no overflow
+	const uint64_t num = (uint64_t)n * sumsq - (uint64_t)(sum * sum);
+	st->var = (uint32_t)(num / ((uint64_t)n * n));
+	st->rms = (uint16_t)gy521_isqrt((sumsq + n / 2) / n);
+}
+
+static bool gy521_window_stats(gy521_window_t *w, const int16_t c[7], uint64_t timestamp_us){
+	if(!w->conf.window) return false;
+	if(!w->priv.count) w->priv.first_us = timestamp_us;
+
+	for(uint8_t a = 0; a < 6; a++){
+		const int16_t x = c[a < 3 ? a : a + 1]; // Temp skipped
+		w->priv.sum[a] += x;
+		w->priv.sumsq[a] += (uint32_t)((int32_t)x * x);
+		if(x < w->priv.min[a]) w->priv.min[a] = x;
+		if(x > w->priv.max[a]) w->priv.max[a] = x;
+	}
+	if(++w->priv.count < w->conf.window) return false;
+
+	gy521_window_stats_t *out = &w->v.stats;
+	for(uint8_t a = 0; a < 6; a++){
+		gy521_stat_t *st = a < 3 ? &out->accel[a] : &out->gyro[a - 3];
+		gy521_window_stat(st, w->priv.sum[a], w->priv.sumsq[a], w->priv.min[a], w->priv.max[a], w->priv.count);
+		w->priv.sum[a] = 0;
+		w->priv.sumsq[a] = 0;
+		w->priv.min[a] = INT16_MAX;
+		w->priv.max[a] = INT16_MIN;
+	}
+	out->count = w->priv.count;
+	out->seq = ++w->v.windows;
+	out->timestamp_us = w->priv.first_us;
+	w->priv.count = 0;
+	return true;
+}
+
+// ==================
+// === Decimation ===
+// ==================
+static bool gy521_window_decim(gy521_window_t *w, const int16_t c[7], uint64_t timestamp_us){
+	if(!w->conf.ratio) return false;
+	const uint8_t order = w->conf.filter == GY521_DECIM_CIC ? w->conf.order : 1;
+
+	// Integrators at the input rate (boxcar: one, cleared per output)
+	if(w->conf.filter != GY521_DECIM_PICK){
+		for(uint8_t ch = 0; ch < 7; ch++){
+			uint32_t acc = (uint32_t)(int32_t)c[ch];
+			for(uint8_t k = 0; k < order; k++) acc = w->priv.integ[k][ch] += acc;
+		}
+	}
+	if(++w->priv.phase < w->conf.ratio) return false;
+	w->priv.phase = 0;
+
+	int16_t y[7];
+	for(uint8_t ch = 0; ch < 7; ch++){
+		if(w->conf.filter == GY521_DECIM_PICK){
+			y[ch] = c[ch];
+			continue;
+		}
+		uint32_t acc = w->priv.integ[order - 1][ch];
+		if(w->conf.filter == GY521_DECIM_BOXCAR){
+			w->priv.integ[0][ch] = 0;
+		}else{
+			// Combs at the output rate
+			for(uint8_t k = 0; k < order; k++){
+				const uint32_t in = acc;
+				acc -= w->priv.comb[k][ch];
+				w->priv.comb[k][ch] = in;
+			}
+		}
+		y[ch] = (int16_t)gy521_div_round((int32_t)acc, w->priv.gain);
+	}
+
+	if(w->priv.settle){
+		w->priv.settle--;
+		return false;
+	}
+
+	gy521_frame_t *out = &w->v.sample;
+	out->sample = (gy521_sample_t){
+		.accel = {y[0], y[1], y[2]},
+		.temp = y[3],
+		.gyro = {y[4], y[5], y[6]},
+	};
+	out->seq = ++w->v.decimated;
+	out->timestamp_us = timestamp_us;
+	return true;
+}
+
+// ==============
+// === Update ===
+// ==============
+uint8_t gy521_window_update_sample(gy521_window_t *w, const gy521_sample_t *s, uint64_t timestamp_us){
+	if(!w || !s) return 0;
+
+	int16_t c[7];
+	gy521_window_channels(s, c);
+
+	uint8_t done = 0;
+	if(gy521_window_stats(w, c, timestamp_us)) done |= GY521_WINDOW_STATS;
+	if(gy521_window_decim(w, c, timestamp_us)) done |= GY521_WINDOW_DECIM;
+	return done;
+}
+
+uint8_t gy521_window_update(gy521_window_t *w, const gy521_s *dev){
+	if(!dev) return 0;
+
+	const gy521_sample_t s = {
+		.accel = dev->v.accel.raw,
+		.temp = dev->v.temp.raw,
+		.gyro = dev->v.gyro.raw,
+	};
+	return gy521_window_update_sample(w, &s, dev->v.timestamp_us);
+}
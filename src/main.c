@@ -19,8 +19,13 @@
  *  - Full-scale range configuration
  *  - Clock source selection
  *  - Axis standby control
- *  - Gyroscope calibration
- *  - Continuous sensor readout (scaled output)
+ *  - Gyroscope calibration, kept in flash for the next boot (USE_FLASH)
+ *  - Online gyro bias tracking against temperature drift (USE_BIAS)
+ *  - Data-ready interrupt driven sensor readout
+ *  - Binary telemetry stream at 1 kHz (USE_TELEMETRY, decode on
+ *    the host with gy521_decode) or scaled printf output
+ *  - Change-only delta stream (USE_DELTA): nothing is sent
+ *    while the sensor lies still
  *
  *  This file is meant as a usage example for the gy521 driver.
  *
@@ -33,15 +38,19 @@
 
 #include "default.h"
 #include "gy521.h"
+#include "gy521_bias.h"
+#include "gy521_delta.h"
+#include "gy521_flash.h"
+#include "gy521_telemetry.h"
 
 int main(void){
 	stdio_init_board();
-	gy521_s gy521 = gy521_init(GY521_I2C_ADDR_GND);
+	gy521_s gy521 = gy521_init(NULL, GY521_I2C_ADDR_GND);
 	int retries = 3;
 	bool connected = false;
 	printf("Try connecting GY-521...\n");
 	while(retries--){
-		connected = gy521.fn.test_connection();
+		connected = gy521.fn.test_connection(&gy521);
 		if(connected) break;
 
 		printf("Retrying...\n");
@@ -50,35 +59,104 @@ int main(void){
 	if(!connected) printf("GY-521 not found!\n");
 	else printf("GY-521 ready!\n");
 
-	if(gy521.fn.reset()) printf("GY-521 got reset\n");
+	if(gy521.fn.reset(&gy521)) printf("GY-521 got reset\n");
 
-	gy521.conf.scaled = true;
+	gy521.conf.scaled = !USE_TELEMETRY; // Frames carry raw values
 	gy521.conf.sleep = false;
 	gy521.conf.accel.fsr = GY521_ACCEL_FSR_SEL_8G;
 	gy521.conf.gyro.fsr = GY521_GYRO_FSR_SEL_2000DPS;
 	gy521.conf.gyro.x.clksel = true;
+	gy521.conf.rate.dlpf = GY521_DLPF_44HZ; // 1 kHz gyro rate
+	gy521.conf.rate.div = USE_TELEMETRY ? 0 : 9; // 1 kHz, printf text only keeps up with 100 Hz
 
-	if(gy521.fn.sleep()) printf("GY-521 sleep stop\n");
-	if(gy521.fn.fsr()) printf("GY-521 Full-Scale-Range is set.\n");
-	if(gy521.fn.clk_sel()) printf("GY-521 Clock Select set to GyroX\n");
+#if USE_FLASH
+	// Configuration + offsets of the last run: applied in one go, no calibration
+	gy521_flash_t *flash = gy521_flash_init();
+	flash->tag = USE_TELEMETRY; // A build with other settings calibrates again
+	bool restored = gy521_flash_restore(flash, &gy521);
+	if(restored) printf("GY-521 configuration + offsets restored from flash\n");
+#else
+	bool restored = false;
+#endif
 
-	//gy521.conf.gyro.y.stby = true;
-	//if(gy521.fn.stby()) printf("YG in standby\n");
-	//gy521.conf.temp.sleep = true;
-	//if(gy521.fn.sleep()) printf("temp in standby\n");
+	if(!restored){
+		// Rate, Full-Scale-Range, motion threshold, wake up and Clock Select in one go (3 writes)
+		if(gy521.fn.commit(&gy521)) printf("GY-521 configured: %lu mHz, 8G / 2000DPS, clock GyroX\n", (unsigned long)gy521.v.rate.odr_mhz);
 
+		//gy521.conf.gyro.y.stby = true;
+		//gy521.conf.temp.sleep = true;
+		//if(gy521.fn.commit(&gy521)) printf("YG and temp in standby\n");
 
-	printf("Try to calibrate GY-521\n");
-	sleep_ms(2000);
-	if(gy521.fn.gyro.calibrate(15)) printf("GY-521 is now calibrated.\n");
-	else printf("GY-521 could not be calibrated.\n");
+
+		// Keep the board still and level: ~0.5 s, offsets end up in the chip
+		printf("Try to calibrate GY-521\n");
+		if(gy521.fn.calibrate(&gy521, 1024)){
+			printf("GY-521 is now calibrated.\n");
+#if USE_FLASH
+			if(gy521_flash_save(flash, &gy521)) printf("GY-521 calibration saved to flash\n");
+#endif
+		}
+		else printf("GY-521 could not be calibrated.\n");
+	}
+
+	// Read once per new sample instead of polling
+	gy521.conf.interrupt.data_ready = true;
+	if(gy521.fn.interrupt(&gy521)) printf("GY-521 data-ready interrupt enabled\n");
+
+#if USE_BIAS
+	// Keeps the offsets right while the board warms up, measured whenever it lies still
+	gy521_bias_t bias;
+	gy521_bias_init(&bias);
+#endif
+
+#if USE_BIAS && USE_FLASH
+	// Tracked offsets go to flash for the next boot, at most every 10 minutes (an erase stalls ~50 ms)
+	uint32_t saved_changes = 0;
+	uint64_t saved_us = time_us_64();
+#endif
+
+#if USE_DELTA
+	// Deadband 16 LSB = 3.9 mg, 8 LSB = 0.49 °/s at 8G / 2000DPS
+	gy521_delta_encoder_t delta;
+	gy521_delta_init(&delta, 16, 8);
+#endif
 
 	while(1){
-		if(gy521.fn.read(0))
-			printf("G=X:%6.3f Y:%6.3f Z:%6.3f | °C=%6.2f | °/s=X:%9.3f Y:%9.3f Z:%9.3f\n", 
-				gy521.v.accel.g.x, gy521.v.accel.g.y, gy521.v.accel.g.z, 
-				gy521.v.temp.celsius, 
-				gy521.v.gyro.dps.x, gy521.v.gyro.dps.y, gy521.v.gyro.dps.z);
-		sleep_ms(500);
+		if(!gy521.fn.read(&gy521, GY521_ALL)) continue;
+#if USE_BIAS
+		gy521_bias_update(&bias, &gy521);
+#endif
+#if USE_BIAS && USE_FLASH
+		if(bias.v.changes != saved_changes && time_us_64() - saved_us >= 600ull * 1000000u){
+			gy521_flash_save(flash, &gy521);
+			saved_changes = bias.v.changes;
+			saved_us = time_us_64();
+		}
+#endif
+
+#if USE_TELEMETRY && USE_DELTA
+		uint8_t buf[GY521_DELTA_MAX_SIZE];
+		uint8_t len = gy521_delta_encode(&delta, &gy521, buf);
+		for(uint8_t i = 0; i < len; i++) putchar_raw(buf[i]);
+#elif USE_TELEMETRY
+		gy521_frame_t frame = {
+			.timestamp_us = gy521.v.timestamp_us,
+			.seq = gy521.v.seq,
+			.sample = {
+				.accel = gy521.v.accel.raw,
+				.temp = gy521.v.temp.raw,
+				.gyro = gy521.v.gyro.raw,
+			},
+		};
+		uint8_t buf[GY521_TELEMETRY_FRAME_SIZE];
+		uint8_t len = gy521_telemetry_encode(buf, &frame);
+		for(uint8_t i = 0; i < len; i++) putchar_raw(buf[i]); // No CR/LF translation
+#else
+		printf("#%lu %llu us | G=X:%6.3f Y:%6.3f Z:%6.3f | °C=%6.2f | °/s=X:%9.3f Y:%9.3f Z:%9.3f\n", 
+			(unsigned long)gy521.v.seq, (unsigned long long)gy521.v.timestamp_us,
+			gy521.v.accel.g.x, gy521.v.accel.g.y, gy521.v.accel.g.z, 
+			gy521.v.temp.celsius, 
+			gy521.v.gyro.dps.x, gy521.v.gyro.dps.y, gy521.v.gyro.dps.z);
+#endif
 	}
 }
@@ -0,0 +1,144 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_decode.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Decodes a binary telemetry stream (gy521_telemetry.h) from
+ *  a file, stdin or the USB CDC port (e.g. /dev/ttyACM0, put
+ *  into raw mode) to CSV or to fixed 28 byte records:
+ *
+ *    numpy.dtype([('t', '<u8'), ('seq', '<u4'),
+ *                 ('raw', '<i2', 7), ('gap', '<u2')])
+ *
+ *  raw = ax ay az temp gx gy gz, gap = frames lost before.
+ *  Statistics (frames, lost, CRC errors, skipped bytes) go to
+ *  stderr at the end (Ctrl+C on a serial port).
+ *
+ *  -d decodes the change-only delta stream (gy521_delta.h)
+ *  instead: one row per packet, the values the sender had, gap =
+ *  packets lost before.
+ *
+ *  Usage: gy521_decode [-b] [-d] [-o file] [input|-]
+ *
+ * ================================================================
+ */
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "gy521_delta.h"
+#include "gy521_telemetry.h"
+
+static volatile sig_atomic_t g_stop;
+
+static void decode_stop(int sig){
+	(void)sig;
+	g_stop = 1;
+}
+
+// Serial port: raw bytes, no echo, no CR/LF translation
+static void decode_raw_tty(int fd){
+	struct termios tio;
+	if(!isatty(fd) || tcgetattr(fd, &tio)) return;
+	cfmakeraw(&tio);
+	tcsetattr(fd, TCSANOW, &tio);
+}
+
+// Little endian record, independent of the host byte order
+static void decode_record(FILE *out, const gy521_frame_t *f, uint32_t gap){
+	uint8_t rec[28];
+	for(uint8_t i = 0; i < 8; i++) rec[i] = (uint8_t)(f->timestamp_us >> (8 * i));
+	for(uint8_t i = 0; i < 4; i++) rec[8 + i] = (uint8_t)(f->seq >> (8 * i));
+
+	const gy521_sample_t *s = &f->sample;
+	const int16_t raw[7] = {s->accel.x, s->accel.y, s->accel.z, s->temp, s->gyro.x, s->gyro.y, s->gyro.z};
+	for(uint8_t i = 0; i < 7; i++){
+		rec[12 + 2 * i] = (uint8_t)raw[i];
+		rec[13 + 2 * i] = (uint8_t)((uint16_t)raw[i] >> 8);
+	}
+	uint16_t g = gap > UINT16_MAX ? UINT16_MAX : (uint16_t)gap;
+	rec[26] = (uint8_t)g;
+	rec[27] = (uint8_t)(g >> 8);
+	fwrite(rec, 1, sizeof(rec), out);
+}
+
+int main(int argc, char **argv){
+	bool binary = false, delta = false;
+	const char *in_path = "-", *out_path = NULL;
+
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-b")) binary = true;
+		else if(!strcmp(argv[i], "-d")) delta = true;
+		else if(!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+		else if(argv[i][0] == '-' && argv[i][1]){
+			fprintf(stderr, "usage: %s [-b] [-d] [-o file] [input|-]\n", argv[0]);
+			return 2;
+		}else in_path = argv[i];
+	}
+
+	int fd = strcmp(in_path, "-") ? open(in_path, O_RDONLY | O_NOCTTY) : STDIN_FILENO;
+	if(fd < 0){
+		perror(in_path);
+		return 2;
+	}
+	decode_raw_tty(fd);
+
+	FILE *out = out_path ? fopen(out_path, binary ? "wb" : "w") : stdout;
+	if(!out){
+		perror(out_path);
+		return 2;
+	}
+	if(!binary) fprintf(out, "seq,timestamp_us,ax,ay,az,temp,gx,gy,gz,gap\n");
+
+	signal(SIGINT, decode_stop);
+	signal(SIGTERM, decode_stop);
+
+	gy521_telemetry_decoder_t d;
+	gy521_telemetry_decoder_init(&d);
+	gy521_delta_decoder_t dd;
+	gy521_delta_decoder_init(&dd);
+	gy521_frame_t f;
+	uint8_t buf[4096];
+
+	while(!g_stop){
+		ssize_t n = read(fd, buf, sizeof(buf));
+		if(n <= 0) break;
+
+		for(ssize_t i = 0; i < n; i++){
+			if(delta ? !gy521_delta_decode(&dd, buf[i], &f) : !gy521_telemetry_decode(&d, buf[i], &f)) continue;
+			const uint32_t gap = delta ? dd.gap : d.gap;
+
+			if(binary){
+				decode_record(out, &f, gap);
+				continue;
+			}
+			const gy521_sample_t *s = &f.sample;
+			fprintf(out, "%lu,%llu,%d,%d,%d,%d,%d,%d,%d,%lu\n", (unsigned long)f.seq, (unsigned long long)f.timestamp_us,
+				s->accel.x, s->accel.y, s->accel.z, s->temp, s->gyro.x, s->gyro.y, s->gyro.z, (unsigned long)gap);
+		}
+	}
+
+	fflush(out);
+	if(delta){
+		fprintf(stderr, "packets %lu (keyframes %lu), lost %lu, dropped until keyframe %lu, crc errors %lu, skipped bytes %lu\n",
+			(unsigned long)dd.stat.packets, (unsigned long)dd.stat.keyframes, (unsigned long)dd.stat.lost,
+			(unsigned long)dd.stat.unsynced, (unsigned long)dd.stat.crc_errors, (unsigned long)dd.stat.skipped);
+	}else{
+		fprintf(stderr, "frames %lu, lost %lu, crc errors %lu, skipped bytes %lu\n",
+			(unsigned long)d.stat.frames, (unsigned long)d.stat.lost, (unsigned long)d.stat.crc_errors, (unsigned long)d.stat.skipped);
+	}
+
+	if(out != stdout) fclose(out);
+	if(fd != STDIN_FILENO) close(fd);
+	return 0;
+}
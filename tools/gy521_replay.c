@@ -0,0 +1,150 @@
+/*
+ * ================================================================
+ *  Project:      GY-521 (MPU-6050) Driver for RP2040
+ *  File:         gy521_replay.c
+ *  Author:       (Gnibor) Robin Gerhartz
+ *  License:      MIT License
+ *  Repository:   https://github.com/Gnibor/gy521_rp2040
+ * ================================================================
+ *
+ *  Description:
+ *  Replays a transfer trace (gy521_trace.h) through the driver:
+ *  configuration from the trace (FSR, rate, DLPF), then
+ *  fn.read() with conf.fixed until the trace ends. Samples go
+ *  out as CSV (mg, m°C, m°/s), as fast as possible or with -r
+ *  at the recorded pace. Replay statistics go to stderr.
+ *
+ *  Usage: gy521_replay [-r] [-a addr] [-o file] trace
+ *
+ * ================================================================
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gy521.h"
+#include "gy521_host.h"
+#include "gy521_trace.h"
+#include "gy521_regs.h"
+
+static uint64_t replay_wall_us(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+// Real time: sleeps until the record is due relative to the first one
+static void replay_pace(void *user, uint64_t time_us){
+	uint64_t *start = user; // {wall, trace} at the first record
+	if(!start[0]){
+		start[0] = replay_wall_us();
+		start[1] = time_us;
+		return;
+	}
+
+	uint64_t due = start[0] + (time_us - start[1]), now = replay_wall_us();
+	if(due <= now) return;
+	struct timespec ts = {.tv_sec = (due - now) / 1000000u, .tv_nsec = ((due - now) % 1000000u) * 1000};
+	nanosleep(&ts, NULL);
+}
+
+static uint8_t *replay_load(const char *path, size_t *size){
+	FILE *f = fopen(path, "rb");
+	if(!f) return NULL;
+
+	uint8_t *buf = NULL;
+	size_t cap = 0;
+	*size = 0;
+	for(;;){
+		if(*size == cap){
+			cap = cap ? cap * 2 : 1 << 16;
+			uint8_t *p = realloc(buf, cap);
+			if(!p) break;
+			buf = p;
+		}
+		size_t n = fread(&buf[*size], 1, cap - *size, f);
+		if(!n) break;
+		*size += n;
+	}
+	fclose(f);
+	return buf;
+}
+
+int main(int argc, char **argv){
+	bool realtime = false;
+	uint8_t addr = GY521_I2C_ADDR_GND;
+	const char *in_path = NULL, *out_path = NULL;
+
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "-r")) realtime = true;
+		else if(!strcmp(argv[i], "-a") && i + 1 < argc) addr = (uint8_t)strtoul(argv[++i], NULL, 0);
+		else if(!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+		else if(argv[i][0] == '-' || in_path){
+			fprintf(stderr, "usage: %s [-r] [-a addr] [-o file] trace\n", argv[0]);
+			return 2;
+		}else in_path = argv[i];
+	}
+	if(!in_path){
+		fprintf(stderr, "usage: %s [-r] [-a addr] [-o file] trace\n", argv[0]);
+		return 2;
+	}
+
+	size_t size;
+	uint8_t *trace = replay_load(in_path, &size);
+	static gy521_trace_play_t play;
+	if(!trace || !gy521_trace_replay(&play, trace, size)){
+		fprintf(stderr, "%s: no trace\n", in_path);
+		return 2;
+	}
+
+	FILE *out = out_path ? fopen(out_path, "w") : stdout;
+	if(!out){
+		perror(out_path);
+		return 2;
+	}
+
+	uint64_t start[2] = {0, 0};
+	if(realtime){
+		play.pace = &replay_pace;
+		play.pace_user = start;
+	}
+	gy521_host_clock(&gy521_trace_now, &gy521_trace_sleep, &play);
+
+	// Configuration the samples were taken with
+	uint8_t regs[128] = {0};
+	gy521_trace_regs(trace, size, addr, GY521_REG_ACCEL_XOUT_H, regs);
+	gy521_s dev = gy521_init(&play.bus, addr);
+	dev.conf.sleep = false;
+	dev.conf.accel.fsr = regs[GY521_REG_ACCEL_CONFIG] & 0x18;
+	dev.conf.gyro.fsr = regs[GY521_REG_GYRO_CONFIG] & 0x18;
+	dev.conf.rate.div = regs[GY521_REG_SMPLRT_DIV];
+	dev.conf.rate.dlpf = regs[GY521_REG_CONFIG] & 0x07;
+	dev.conf.fixed = true;
+	dev.fn.commit(&dev);
+
+	fprintf(out, "seq,timestamp_us,ax_mg,ay_mg,az_mg,temp_mc,gx_mdps,gy_mdps,gz_mdps\n");
+	uint32_t samples = 0, failed = 0;
+	while(!gy521_trace_done(&play)){
+		const uint32_t misses = play.stat.misses;
+		if(!dev.fn.read(&dev, GY521_ALL)){
+			if(play.stat.misses != misses) break; // No data read left
+			failed++;
+			continue;
+		}
+		fprintf(out, "%lu,%llu,%ld,%ld,%ld,%ld,%ld,%ld,%ld\n", (unsigned long)dev.v.seq, (unsigned long long)dev.v.timestamp_us,
+			(long)dev.v.accel.mg.x, (long)dev.v.accel.mg.y, (long)dev.v.accel.mg.z, (long)dev.v.temp.mcelsius,
+			(long)dev.v.gyro.mdps.x, (long)dev.v.gyro.mdps.y, (long)dev.v.gyro.mdps.z);
+		samples++;
+	}
+
+	fflush(out);
+	fprintf(stderr, "samples %lu, failed reads %lu, skipped records %lu, write mismatches %lu\n", (unsigned long)samples,
+		(unsigned long)failed, (unsigned long)play.stat.skipped, (unsigned long)play.stat.mismatches);
+
+	if(out != stdout) fclose(out);
+	free(trace);
+	return 0;
+}